@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+# RunBotSwarm.sh - 在一台Linux机器上通过回环地址启动专用服务器和N个无头机器人客户端，
+# 按客户端数量逐级加压，汇总服务器帧时间、每个客户端的带宽和RPC速率。
+#
+# 用法：
+#   UE_EDITOR=/path/to/Engine/Binaries/Linux/UnrealEditor Scripts/RunBotSwarm.sh [-n "1 2 4 8 16"] [-d 60] [-p 7777] [-o Saved/BotSwarm]
+#
+# 也可以用打包后的可执行文件：设置 UE_SERVER 和 UE_CLIENT 代替 UE_EDITOR。
+
+set -euo pipefail
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="${PROJECT_DIR}/UE5FirstPersonDemo.uproject"
+MAP="/Game/Maps/FirstPersonMap"
+
+CLIENT_COUNTS="1 2 4 8 16"
+DURATION=60
+WARMUP=15
+PORT=7777
+OUT_DIR="${PROJECT_DIR}/Saved/BotSwarm"
+
+while getopts "n:d:w:p:o:" opt; do
+	case "${opt}" in
+		n) CLIENT_COUNTS="${OPTARG}" ;;
+		d) DURATION="${OPTARG}" ;;
+		w) WARMUP="${OPTARG}" ;;
+		p) PORT="${OPTARG}" ;;
+		o) OUT_DIR="${OPTARG}" ;;
+		*) echo "usage: $0 [-n \"counts\"] [-d seconds] [-w warmup] [-p port] [-o dir]" >&2; exit 1 ;;
+	esac
+done
+
+if [[ -n "${UE_EDITOR:-}" ]]; then
+	SERVER_CMD=("${UE_EDITOR}" "${PROJECT}" "${MAP}" -server)
+	CLIENT_CMD=("${UE_EDITOR}" "${PROJECT}" "127.0.0.1:${PORT}" -game)
+elif [[ -n "${UE_SERVER:-}" && -n "${UE_CLIENT:-}" ]]; then
+	SERVER_CMD=("${UE_SERVER}" "${MAP}")
+	CLIENT_CMD=("${UE_CLIENT}" "127.0.0.1:${PORT}")
+else
+	echo "Set UE_EDITOR, or UE_SERVER and UE_CLIENT" >&2
+	exit 1
+fi
+
+COMMON_ARGS=(-nullrhi -nosound -unattended -nosplash -nopause -log)
+
+mkdir -p "${OUT_DIR}"
+REPORT="${OUT_DIR}/report.csv"
+echo "clients,frame_avg_ms,frame_max_ms,out_kbps_per_client,in_kbps_per_client,fire_rpc_per_client,cosmetic_rpc_per_client,dropped_rpc_total" > "${REPORT}"
+
+PIDS=()
+cleanup()
+{
+	for pid in "${PIDS[@]:-}"; do
+		kill "${pid}" 2>/dev/null || true
+	done
+	wait 2>/dev/null || true
+	PIDS=()
+}
+trap cleanup EXIT INT TERM
+
+for count in ${CLIENT_COUNTS}; do
+	echo "== ${count} clients =="
+	SERVER_LOG="${OUT_DIR}/server_${count}.log"
+
+	"${SERVER_CMD[@]}" "${COMMON_ARGS[@]}" -port="${PORT}" -fpdloadreport -abslog="${SERVER_LOG}" > /dev/null 2>&1 &
+	PIDS+=($!)
+
+	# 等待服务器开始监听
+	for _ in $(seq 1 120); do
+		if grep -q "LOAD_REPORT\|listening on port\|Game Engine Initialized" "${SERVER_LOG}" 2>/dev/null; then
+			break
+		fi
+		sleep 1
+	done
+
+	for i in $(seq 1 "${count}"); do
+		# 客户端限制帧率以节省CPU，种子固定以便复现
+		"${CLIENT_CMD[@]}" "${COMMON_ARGS[@]}" -fpdbot -fpdbotseed="${i}" -ExecCmds="t.MaxFPS 30" \
+			-abslog="${OUT_DIR}/client_${count}_${i}.log" > /dev/null 2>&1 &
+		PIDS+=($!)
+	done
+
+	sleep "$((WARMUP + DURATION))"
+	cleanup
+
+	# 跳过预热期内的报告，其余取平均（帧时间最大值取最大）
+	awk -v count="${count}" -v skip="$((WARMUP / 5))" '
+		/LOAD_REPORT/ {
+			if (++seen <= skip) next
+			for (i = 1; i <= NF; i++) {
+				split($i, kv, "=")
+				if (kv[1] == "frame_max_ms") { if (kv[2] > maxf) maxf = kv[2] }
+				else if (kv[1] == "dropped_rpc_total") { dropped = kv[2] }
+				else if (kv[1] != "clients" && kv[2] != "") { sum[kv[1]] += kv[2] }
+			}
+			n++
+		}
+		END {
+			if (n == 0) { printf "%d,,,,,,,\n", count; exit }
+			printf "%d,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%d\n", count,
+				sum["frame_avg_ms"] / n, maxf, sum["out_kbps_per_client"] / n, sum["in_kbps_per_client"] / n,
+				sum["fire_rpc_per_client"] / n, sum["cosmetic_rpc_per_client"] / n, dropped
+		}' "${SERVER_LOG}" >> "${REPORT}"
+
+	tail -n 1 "${REPORT}"
+done
+
+echo
+column -s, -t < "${REPORT}" || cat "${REPORT}"
@@ -0,0 +1,177 @@
+// BotClientSubsystem.cpp - 负载测试子系统实现
+
+#include "BotClientSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "NetBandwidthStats.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBotClient, Log, All);
+
+FBotInputScript::FBotInputScript(int32 Seed)
+	: Random(Seed)
+{
+	PitchPhase = Random.FRandRange(0.0f, UE_TWO_PI);
+}
+
+void FBotInputScript::Update(float DeltaTime, FVector2D& OutMove, FVector2D& OutLook, bool& bOutFire)
+{
+	// 每段移动随机选择方向和转向速度，偶尔原地停留
+	MoveTimeLeft -= DeltaTime;
+	if (MoveTimeLeft <= 0.0f)
+	{
+		MoveTimeLeft = Random.FRandRange(MinMoveDuration, MaxMoveDuration);
+		MoveVector = (Random.FRand() < 0.2f) ? FVector2D::ZeroVector
+			: FVector2D(Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-0.3f, 1.0f)).GetSafeNormal();
+		YawRate = Random.FRandRange(-1.0f, 1.0f) * LookRate;
+	}
+
+	PitchPhase = FMath::Fmod(PitchPhase + DeltaTime, UE_TWO_PI);
+
+	OutMove = MoveVector;
+	OutLook = FVector2D(YawRate * DeltaTime, FMath::Sin(PitchPhase) * 0.2f * LookRate * DeltaTime);
+
+	// 连射与停火交替
+	FireTimeLeft -= DeltaTime;
+	if (FireTimeLeft <= 0.0f)
+	{
+		bFiring = !bFiring;
+		FireTimeLeft = bFiring ? Random.FRandRange(MinBurstDuration, MaxBurstDuration)
+			: Random.FRandRange(MinPauseDuration, MaxPauseDuration);
+	}
+
+	bOutFire = bFiring;
+}
+
+bool UBotClientSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	return FParse::Param(FCommandLine::Get(), TEXT("fpdbot")) || FParse::Param(FCommandLine::Get(), TEXT("fpdloadreport"));
+}
+
+void UBotClientSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("fpdbot")))
+	{
+		int32 Seed = FPlatformProcess::GetCurrentProcessId();
+		FParse::Value(FCommandLine::Get(), TEXT("fpdbotseed="), Seed);
+
+		BotScript = MakeUnique<FBotInputScript>(Seed);
+		UE_LOG(LogBotClient, Display, TEXT("Bot client enabled (seed %d)"), Seed);
+	}
+
+	bLoadReport = FParse::Param(FCommandLine::Get(), TEXT("fpdloadreport"));
+}
+
+void UBotClientSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (BotScript)
+	{
+		TickBot(DeltaTime);
+	}
+
+	if (bLoadReport && GetWorld()->GetNetMode() != NM_Client)
+	{
+		TickLoadReport(DeltaTime);
+	}
+}
+
+TStatId UBotClientSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBotClientSubsystem, STATGROUP_Tickables);
+}
+
+void UBotClientSubsystem::TickBot(float DeltaTime)
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	AFirstPersonDemoCharacter* Character = PC ? Cast<AFirstPersonDemoCharacter>(PC->GetPawn()) : nullptr;
+	if (!Character || !Character->IsLocallyControlled())
+	{
+		return;
+	}
+
+	FVector2D MoveVector;
+	FVector2D LookVector;
+	bool bWantsFire = false;
+	BotScript->Update(DeltaTime, MoveVector, LookVector, bWantsFire);
+
+	Character->ApplyScriptedInput(MoveVector, LookVector, bWantsFire);
+}
+
+void UBotClientSubsystem::TickLoadReport(float DeltaTime)
+{
+	// 帧时间去掉帧率限制的空闲等待，即实际工作时间
+	const double FrameWork = FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0);
+	ReportFrameWorkSum += FrameWork;
+	ReportFrameWorkMax = FMath::Max(ReportFrameWorkMax, FrameWork);
+	++ReportFrames;
+
+	ReportTimeElapsed += DeltaTime;
+	if (ReportTimeElapsed < ReportInterval)
+	{
+		return;
+	}
+
+	UNetDriver* Driver = GetWorld()->GetNetDriver();
+	const int32 NumClients = Driver ? Driver->ClientConnections.Num() : 0;
+
+	int64 OutBytesPerSecond = 0;
+	int64 InBytesPerSecond = 0;
+	if (Driver)
+	{
+		for (const UNetConnection* Connection : Driver->ClientConnections)
+		{
+			OutBytesPerSecond += Connection->OutBytesPerSecond;
+			InBytesPerSecond += Connection->InBytesPerSecond;
+		}
+	}
+
+	// 收到的射击RPC来自每个角色的限流计数（包括被丢弃的）
+	uint64 FireRpcsReceived = 0;
+	uint32 FireRpcsDropped = 0;
+	for (TActorIterator<AFirstPersonDemoCharacter> It(GetWorld()); It; ++It)
+	{
+		const FRpcRateLimiter& Limiter = It->GetFireRateLimiter();
+		FireRpcsReceived += Limiter.FireBatches.NumAccepted + Limiter.FireBatches.NumDropped;
+		FireRpcsDropped += Limiter.GetNumDropped();
+	}
+
+	const float FireRpcRate = static_cast<float>(FireRpcsReceived - FMath::Min(LastFireRpcsReceived, FireRpcsReceived)) / ReportTimeElapsed;
+	LastFireRpcsReceived = FireRpcsReceived;
+
+	static const FName NAME_ClientReceiveCosmeticEvents(TEXT("ClientReceiveCosmeticEvents"));
+	const FNetBandwidthCounter* CosmeticCounter = FNetBandwidthStats::Get().GetCounters(ENetBandwidthCategory::Rpc).Find(NAME_ClientReceiveCosmeticEvents);
+	const float CosmeticRpcRate = CosmeticCounter ? CosmeticCounter->GetCountPerSecond(FNetBandwidthStats::GetCurrentSecond()) : 0.0f;
+
+	const float PerClient = NumClients > 0 ? 1.0f / NumClients : 0.0f;
+
+	UE_LOG(LogBotClient, Display,
+		TEXT("LOAD_REPORT clients=%d frame_avg_ms=%.2f frame_max_ms=%.2f out_kbps_per_client=%.1f in_kbps_per_client=%.1f fire_rpc_per_client=%.1f cosmetic_rpc_per_client=%.1f dropped_rpc_total=%u"),
+		NumClients,
+		ReportFrames > 0 ? ReportFrameWorkSum / ReportFrames * 1000.0 : 0.0,
+		ReportFrameWorkMax * 1000.0,
+		OutBytesPerSecond * 8 / 1000.0f * PerClient,
+		InBytesPerSecond * 8 / 1000.0f * PerClient,
+		FireRpcRate * PerClient,
+		CosmeticRpcRate * PerClient,
+		FireRpcsDropped);
+
+	ReportTimeElapsed = 0.0f;
+	ReportFrames = 0;
+	ReportFrameWorkSum = 0.0;
+	ReportFrameWorkMax = 0.0;
+}
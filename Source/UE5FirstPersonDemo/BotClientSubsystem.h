@@ -0,0 +1,93 @@
+// BotClientSubsystem.h - 网络负载测试：无头机器人客户端的脚本输入，以及服务器端的负载报告
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BotClientSubsystem.generated.h"
+
+/**
+ * 脚本输入生成器 - 随机但可复现的移动、视角和连射节奏
+ */
+class FBotInputScript
+{
+public:
+	/** 每段移动的持续时间范围（秒） */
+	static constexpr float MinMoveDuration = 1.0f;
+	static constexpr float MaxMoveDuration = 3.0f;
+
+	/** 连射和停火的持续时间范围（秒） */
+	static constexpr float MinBurstDuration = 0.5f;
+	static constexpr float MaxBurstDuration = 1.5f;
+	static constexpr float MinPauseDuration = 0.5f;
+	static constexpr float MaxPauseDuration = 2.0f;
+
+	/** 视角转动速度（输入单位/秒） */
+	static constexpr float LookRate = 60.0f;
+
+	explicit FBotInputScript(int32 Seed);
+
+	/** 推进脚本并输出本帧的输入 */
+	void Update(float DeltaTime, FVector2D& OutMove, FVector2D& OutLook, bool& bOutFire);
+
+private:
+	FRandomStream Random;
+
+	FVector2D MoveVector = FVector2D::ZeroVector;
+	float MoveTimeLeft = 0.0f;
+
+	/** 目标转向速度（每段移动重新选取） */
+	float YawRate = 0.0f;
+
+	/** 俯仰在水平线附近来回摆动 */
+	float PitchPhase = 0.0f;
+
+	bool bFiring = false;
+	float FireTimeLeft = 0.0f;
+};
+
+/**
+ * 负载测试子系统
+ *
+ * -fpdbot 启动的客户端（通常配合 -nullrhi -nosound）由脚本驱动本地玩家角色，
+ * 可用 -fpdbotseed=N 固定随机种子；-fpdloadreport 启动的服务器每 ReportInterval 秒输出一行
+ * LOAD_REPORT 日志，包含服务器帧时间、每个客户端的带宽和RPC速率，供 Scripts/RunBotSwarm.sh 汇总。
+ */
+UCLASS()
+class UBotClientSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 负载报告间隔（秒） */
+	static constexpr float ReportInterval = 5.0f;
+
+	// UWorldSubsystem
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	// UTickableWorldSubsystem
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	/** 客户端：驱动本地玩家 */
+	void TickBot(float DeltaTime);
+
+	/** 服务器：累积帧时间并定期输出报告 */
+	void TickLoadReport(float DeltaTime);
+
+	/** 机器人输入脚本（只在 -fpdbot 客户端上创建） */
+	TUniquePtr<FBotInputScript> BotScript;
+
+	bool bLoadReport = false;
+
+	/** 当前报告周期内的帧统计 */
+	float ReportTimeElapsed = 0.0f;
+	int32 ReportFrames = 0;
+	double ReportFrameWorkSum = 0.0;
+	double ReportFrameWorkMax = 0.0;
+
+	/** 上次报告时各连接已收到的射击RPC数 */
+	uint64 LastFireRpcsReceived = 0;
+};
@@ -0,0 +1,57 @@
+// CombatAssetSet.cpp - 战斗资产集实现
+
+#include "CombatAssetSet.h"
+#include "EnemyAICharacter.h"
+#include "Animation/AnimMontage.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "Particles/ParticleSystem.h"
+#include "Engine/StaticMesh.h"
+
+const FPrimaryAssetType UCombatAssetSet::PrimaryAssetType(TEXT("CombatAssetSet"));
+
+UCombatAssetSet::UCombatAssetSet()
+{
+	// 与原先同步加载的路径一致（内容迁移到Niagara后在数据资产中改为对应的Niagara系统）；
+	// 枪口火焰原先只由角色蓝图指定，没有默认值
+	ImpactEffect = TSoftObjectPtr<UFXSystemAsset>(FSoftObjectPath(TEXT("/Game/FirstPerson/Particles/P_HitEffect.P_HitEffect")));
+	PlayerDeathMontage = TSoftObjectPtr<UAnimMontage>(FSoftObjectPath(TEXT("/Game/FirstPerson/Animations/DeathAnim.DeathAnim")));
+	ProjectileMesh = TSoftObjectPtr<UStaticMesh>(FSoftObjectPath(TEXT("/Engine/BasicShapes/Sphere.Sphere")));
+
+	// 权威逻辑资产：敌人类默认为原生类（始终存在），行为树为示例内容中的敌人行为树
+	EnemyClass = TSoftClassPtr<AEnemyAICharacter>(AEnemyAICharacter::StaticClass());
+	EnemyBehaviorTree = TSoftObjectPtr<UBehaviorTree>(FSoftObjectPath(TEXT("/Game/FirstPerson/AI/BT_Enemy.BT_Enemy")));
+}
+
+FPrimaryAssetId UCombatAssetSet::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+FSoftObjectPath UCombatAssetSet::GetAssetPath(ECombatAsset Asset) const
+{
+	switch (Asset)
+	{
+	case ECombatAsset::MuzzleEffect:
+		return MuzzleEffect.ToSoftObjectPath();
+	case ECombatAsset::ImpactEffect:
+		return ImpactEffect.ToSoftObjectPath();
+	case ECombatAsset::PlayerDeathMontage:
+		return PlayerDeathMontage.ToSoftObjectPath();
+	case ECombatAsset::EnemyBehaviorTree:
+		return EnemyBehaviorTree.ToSoftObjectPath();
+	case ECombatAsset::EnemyClass:
+		return EnemyClass.ToSoftObjectPath();
+	case ECombatAsset::ProjectileMesh:
+		return ProjectileMesh.ToSoftObjectPath();
+	default:
+		return FSoftObjectPath();
+	}
+}
+
+bool UCombatAssetSet::IsCosmetic(ECombatAsset Asset)
+{
+	return Asset == ECombatAsset::MuzzleEffect
+		|| Asset == ECombatAsset::ImpactEffect
+		|| Asset == ECombatAsset::PlayerDeathMontage
+		|| Asset == ECombatAsset::ProjectileMesh;
+}
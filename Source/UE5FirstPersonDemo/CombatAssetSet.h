@@ -0,0 +1,83 @@
+// CombatAssetSet.h - 战斗资产集：以软引用列出比赛中需要常驻的资产
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CombatAssetSet.generated.h"
+
+class AEnemyAICharacter;
+class UAnimMontage;
+class UBehaviorTree;
+class UFXSystemAsset;
+class UStaticMesh;
+
+/**
+ * 常驻战斗资产槽位
+ */
+enum class ECombatAsset : uint8
+{
+	/** 枪口火焰特效 */
+	MuzzleEffect,
+	/** 命中特效 */
+	ImpactEffect,
+	/** 玩家死亡动画 */
+	PlayerDeathMontage,
+	/** 敌人行为树 */
+	EnemyBehaviorTree,
+	/** 敌人类 */
+	EnemyClass,
+	/** 射弹网格 */
+	ProjectileMesh,
+	Count
+};
+
+/**
+ * 战斗资产集 - 主数据资产
+ *
+ * 所有引用都是软引用，由 UCombatAssetSubsystem 在比赛开始前异步加载并常驻。
+ * 未配置数据资产时使用本类的默认值。
+ */
+UCLASS(BlueprintType)
+class UCombatAssetSet : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UCombatAssetSet();
+
+	/** 主资产类型 */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/** 指定槽位的资产路径 */
+	FSoftObjectPath GetAssetPath(ECombatAsset Asset) const;
+
+	/** 槽位是否只用于表现（专用服务器不加载） */
+	static bool IsCosmetic(ECombatAsset Asset);
+
+	/** 枪口火焰特效（角色未指定时使用；Niagara系统或Cascade粒子系统） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat)
+	TSoftObjectPtr<UFXSystemAsset> MuzzleEffect;
+
+	/** 命中特效（Niagara系统或Cascade粒子系统） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat)
+	TSoftObjectPtr<UFXSystemAsset> ImpactEffect;
+
+	/** 玩家死亡动画 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat)
+	TSoftObjectPtr<UAnimMontage> PlayerDeathMontage;
+
+	/** 敌人行为树（敌人蓝图未指定时使用） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = AI)
+	TSoftObjectPtr<UBehaviorTree> EnemyBehaviorTree;
+
+	/** 敌人类（游戏模式未指定时使用） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = AI)
+	TSoftClassPtr<AEnemyAICharacter> EnemyClass;
+
+	/** 射弹网格（实例化渲染） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat)
+	TSoftObjectPtr<UStaticMesh> ProjectileMesh;
+};
@@ -0,0 +1,189 @@
+// CombatAssetSubsystem.cpp - 战斗资产常驻管理实现
+
+#include "CombatAssetSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCombatAssets, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Combat Asset Sync Loads"), STAT_CombatAssetSyncLoads, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Combat Assets Resident"), STAT_CombatAssetsResident, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sync Loads In Match"), STAT_SyncLoadsInMatch, STATGROUP_FirstPersonDemo);
+
+void UCombatAssetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ResidentAssets.SetNum(static_cast<int32>(ECombatAsset::Count));
+
+	// 全局统计：任何来源的同步加载（蓝图硬引用、LoadObject等）都经过这里
+	SyncLoadHandle = FCoreUObjectDelegates::OnSyncLoadPackage.AddUObject(this, &UCombatAssetSubsystem::OnSyncLoadPackage);
+}
+
+void UCombatAssetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// 客户端没有游戏模式，在世界开始时预加载；服务器由 InitializeGame 触发（重复调用无副作用）
+	PreloadAssets();
+}
+
+void UCombatAssetSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::OnSyncLoadPackage.Remove(SyncLoadHandle);
+	DEC_DWORD_STAT_BY(STAT_SyncLoadsInMatch, NumSyncLoadsInMatch);
+
+	if (AssetSetHandle.IsValid())
+	{
+		AssetSetHandle->ReleaseHandle();
+	}
+	if (AssetsHandle.IsValid())
+	{
+		AssetsHandle->ReleaseHandle();
+	}
+	DEC_DWORD_STAT_BY(STAT_CombatAssetsResident, NumResident);
+
+	Super::Deinitialize();
+}
+
+void UCombatAssetSubsystem::PreloadAssets()
+{
+	if (bPreloadRequested)
+	{
+		return;
+	}
+	bPreloadRequested = true;
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	if (CombatAssetSetPath.IsNull())
+	{
+		OnAssetSetLoaded();
+		return;
+	}
+
+	FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
+	AssetSetHandle = Streamable.RequestAsyncLoad(CombatAssetSetPath,
+		FStreamableDelegate::CreateUObject(this, &UCombatAssetSubsystem::OnAssetSetLoaded),
+		FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UCombatAssetSubsystem::OnAssetSetLoaded()
+{
+	AssetSet = Cast<UCombatAssetSet>(CombatAssetSetPath.ResolveObject());
+	if (!AssetSet && !CombatAssetSetPath.IsNull())
+	{
+		UE_LOG(LogCombatAssets, Warning, TEXT("Combat asset set %s failed to load, using defaults"), *CombatAssetSetPath.ToString());
+	}
+
+	const UCombatAssetSet* Set = GetAssetSet();
+	const bool bLoadCosmetics = ShouldPlayCosmetics(GetWorld());
+
+	TArray<FSoftObjectPath> Paths;
+	for (int32 Index = 0; Index < static_cast<int32>(ECombatAsset::Count); ++Index)
+	{
+		// 专用服务器只加载权威逻辑需要的资产
+		if (!bLoadCosmetics && UCombatAssetSet::IsCosmetic(static_cast<ECombatAsset>(Index)))
+		{
+			continue;
+		}
+
+		const FSoftObjectPath Path = Set->GetAssetPath(static_cast<ECombatAsset>(Index));
+		if (!Path.IsNull())
+		{
+			Paths.Add(Path);
+		}
+	}
+
+	if (Paths.Num() == 0)
+	{
+		OnAssetsLoaded();
+		return;
+	}
+
+	FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
+	AssetsHandle = Streamable.RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UCombatAssetSubsystem::OnAssetsLoaded),
+		FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UCombatAssetSubsystem::OnAssetsLoaded()
+{
+	const UCombatAssetSet* Set = GetAssetSet();
+	const bool bLoadCosmetics = ShouldPlayCosmetics(GetWorld());
+
+	NumResident = 0;
+	for (int32 Index = 0; Index < static_cast<int32>(ECombatAsset::Count); ++Index)
+	{
+		// 同步加载的回退可能已经填充了槽位
+		if (!ResidentAssets[Index] && (bLoadCosmetics || !UCombatAssetSet::IsCosmetic(static_cast<ECombatAsset>(Index))))
+		{
+			ResidentAssets[Index] = Set->GetAssetPath(static_cast<ECombatAsset>(Index)).ResolveObject();
+		}
+		NumResident += ResidentAssets[Index] ? 1 : 0;
+
+		// 权威逻辑资产缺失会让敌人无法生成或没有行为，必须在比赛前发现
+		if (!ResidentAssets[Index] && !UCombatAssetSet::IsCosmetic(static_cast<ECombatAsset>(Index)))
+		{
+			UE_LOG(LogCombatAssets, Error, TEXT("Combat asset slot %d (%s) did not load"),
+				Index, *Set->GetAssetPath(static_cast<ECombatAsset>(Index)).ToString());
+		}
+	}
+
+	bPreloadComplete = true;
+	INC_DWORD_STAT_BY(STAT_CombatAssetsResident, NumResident);
+
+	UE_LOG(LogCombatAssets, Log, TEXT("Preloaded %d combat assets in %.1f ms"),
+		NumResident, (FPlatformTime::Seconds() - PreloadStartTime) * 1000.0);
+}
+
+const UCombatAssetSet* UCombatAssetSubsystem::GetAssetSet() const
+{
+	return AssetSet ? AssetSet.Get() : GetDefault<UCombatAssetSet>();
+}
+
+void UCombatAssetSubsystem::OnSyncLoadPackage(const FString& PackageName)
+{
+	// 预加载完成前的同步加载属于加载阶段，不计入
+	const UWorld* World = GetWorld();
+	if (!bPreloadComplete || !World || !World->IsGameWorld() || !World->HasBegunPlay())
+	{
+		return;
+	}
+
+	++NumSyncLoadsInMatch;
+	INC_DWORD_STAT(STAT_SyncLoadsInMatch);
+	UE_LOG(LogCombatAssets, Warning, TEXT("Synchronous load of %s during match (%d so far)"), *PackageName, NumSyncLoadsInMatch);
+}
+
+UObject* UCombatAssetSubsystem::GetAssetObject(ECombatAsset Asset)
+{
+	const int32 Index = static_cast<int32>(Asset);
+	if (ResidentAssets.IsValidIndex(Index) && ResidentAssets[Index])
+	{
+		return ResidentAssets[Index];
+	}
+
+	// 专用服务器上的表现资产永远不加载
+	if (UCombatAssetSet::IsCosmetic(Asset) && !ShouldPlayCosmetics(GetWorld()))
+	{
+		return nullptr;
+	}
+
+	// 预加载完成后仍为空说明资产不存在，不再重试
+	const FSoftObjectPath Path = GetAssetSet()->GetAssetPath(Asset);
+	if (Path.IsNull() || bPreloadComplete)
+	{
+		return nullptr;
+	}
+
+	// 预加载尚未完成（或未启动）：同步加载并记录，比赛中不应发生
+	INC_DWORD_STAT(STAT_CombatAssetSyncLoads);
+	UE_LOG(LogCombatAssets, Warning, TEXT("Synchronous load of combat asset %s before preload completed"), *Path.ToString());
+
+	UObject* Object = Path.TryLoad();
+	ResidentAssets[Index] = Object;
+	return Object;
+}
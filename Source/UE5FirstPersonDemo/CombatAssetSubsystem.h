@@ -0,0 +1,111 @@
+// CombatAssetSubsystem.h - 战斗资产常驻管理：比赛前异步预加载并固定，比赛中O(1)按类型获取
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "CombatAssetSet.h"
+#include "CombatAssetSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * 战斗资产子系统
+ *
+ * 服务器在 InitializeGame 中、客户端在世界开始时通过 FStreamableManager 异步加载资产集中的全部资产，
+ * 并持有加载句柄使其常驻。获取函数只是数组下标访问；资产尚未加载完时才回退到同步加载，
+ * 并计入 "Combat Asset Sync Loads" 统计，比赛中该值应保持为0。
+ *
+ * 预加载完成后，子系统还监听引擎的同步加载包事件，把比赛中任何来源的同步加载计入
+ * "Sync Loads In Match" 统计并记录包名，不只限于资产集中的槽位。
+ */
+UCLASS(Config = Game)
+class UCombatAssetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** 开始异步预加载（重复调用无副作用） */
+	void PreloadAssets();
+
+	/** 预加载是否完成 */
+	bool IsPreloadComplete() const { return bPreloadComplete; }
+
+	/** 预加载完成后发生的同步加载包数（任何来源） */
+	int32 GetNumSyncLoadsInMatch() const { return NumSyncLoadsInMatch; }
+
+	/** 获取常驻资产 */
+	template<typename T>
+	T* GetAsset(ECombatAsset Asset)
+	{
+		return Cast<T>(GetAssetObject(Asset));
+	}
+
+	/** 获取常驻类 */
+	template<typename T>
+	TSubclassOf<T> GetClass(ECombatAsset Asset)
+	{
+		return Cast<UClass>(GetAssetObject(Asset));
+	}
+
+	/** 便捷访问：通过世界获取资产 */
+	template<typename T>
+	static T* Get(const UWorld* World, ECombatAsset Asset)
+	{
+		UCombatAssetSubsystem* Subsystem = World ? World->GetSubsystem<UCombatAssetSubsystem>() : nullptr;
+		return Subsystem ? Subsystem->GetAsset<T>(Asset) : nullptr;
+	}
+
+protected:
+	/** 资产集路径（DefaultGame.ini 配置，为空时使用 UCombatAssetSet 的默认值） */
+	UPROPERTY(Config)
+	FSoftObjectPath CombatAssetSetPath;
+
+private:
+	/** 按槽位获取，未加载时同步加载并计数 */
+	UObject* GetAssetObject(ECombatAsset Asset);
+
+	/** 资产集加载完成后请求其中的资产 */
+	void OnAssetSetLoaded();
+
+	/** 所有资产加载完成 */
+	void OnAssetsLoaded();
+
+	/** 当前使用的资产集 */
+	const UCombatAssetSet* GetAssetSet() const;
+
+	/** 引擎同步加载包回调 */
+	void OnSyncLoadPackage(const FString& PackageName);
+
+	UPROPERTY()
+	TObjectPtr<UCombatAssetSet> AssetSet;
+
+	/** 按槽位存放的常驻资产 */
+	UPROPERTY()
+	TArray<TObjectPtr<UObject>> ResidentAssets;
+
+	/** 加载句柄（持有即固定） */
+	TSharedPtr<FStreamableHandle> AssetSetHandle;
+	TSharedPtr<FStreamableHandle> AssetsHandle;
+
+	bool bPreloadRequested = false;
+	bool bPreloadComplete = false;
+
+	/** 计入常驻统计的资产数 */
+	int32 NumResident = 0;
+
+	/** 预加载完成后的同步加载包数 */
+	int32 NumSyncLoadsInMatch = 0;
+
+	/** 同步加载包回调句柄 */
+	FDelegateHandle SyncLoadHandle;
+
+	/** 开始预加载的时间（用于日志） */
+	double PreloadStartTime = 0.0;
+};
@@ -0,0 +1,271 @@
+// CosmeticEventSubsystem.cpp - 装饰性事件通道实现
+
+#include "CosmeticEventSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "FirstPersonDemoPlayerController.h"
+#include "NetBandwidthStats.h"
+#include "VfxPoolSubsystem.h"
+#include "EnemyAICharacter.h"
+#include "Engine/NetSerialization.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Cosmetic Flush"), STAT_CosmeticFlush, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Events Queued"), STAT_CosmeticQueued, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Events Sent"), STAT_CosmeticSent, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Events Culled"), STAT_CosmeticCulled, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Batches Sent"), STAT_CosmeticBatches, STATGROUP_FirstPersonDemo);
+
+namespace CosmeticEvents
+{
+	/** 各类型的剔除距离 */
+	constexpr float CullDistance[] =
+	{
+		5000.0f,	// Muzzle
+		4000.0f,	// Impact
+		10000.0f	// Death
+	};
+	static_assert(UE_ARRAY_COUNT(CullDistance) == static_cast<int32>(ECosmeticEventType::Count), "每种事件类型都需要剔除距离");
+
+	/** 各类型的优先级（越小越优先），排序键为 优先级 * PriorityScale + 距离平方 */
+	constexpr float PriorityScale = 1.0e9f;
+
+	constexpr int32 Priority[] =
+	{
+		2,	// Muzzle
+		1,	// Impact
+		0	// Death
+	};
+
+	const FName NAME_CosmeticEventBatch(TEXT("CosmeticEventBatch"));
+	const FName NAME_FirstPersonDemoPlayerController(TEXT("FirstPersonDemoPlayerController"));
+	const FName NAME_ClientReceiveCosmeticEvents(TEXT("ClientReceiveCosmeticEvents"));
+
+	/** 事件是否需要序列化关联角色 */
+	bool NeedsActor(ECosmeticEventType Type)
+	{
+		return Type == ECosmeticEventType::Muzzle || Type == ECosmeticEventType::Death;
+	}
+}
+
+bool FCosmeticEventBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	NetBandwidth::FSerializeScope BandwidthScope(Ar, Map, CosmeticEvents::NAME_CosmeticEventBatch, CosmeticEvents::NAME_FirstPersonDemoPlayerController);
+
+	bOutSuccess = SerializePackedVector<1, 24>(Anchor, Ar);
+
+	uint32 NumEvents = Events.Num();
+	Ar.SerializeInt(NumEvents, MaxEvents + 1);
+
+	if (Ar.IsLoading())
+	{
+		if (NumEvents > MaxEvents)
+		{
+			bOutSuccess = false;
+			return false;
+		}
+		Events.SetNum(NumEvents);
+	}
+
+	for (FCosmeticEvent& Event : Events)
+	{
+		uint32 Type = static_cast<uint32>(Event.Type);
+		Ar.SerializeInt(Type, static_cast<uint32>(ECosmeticEventType::Count));
+		Event.Type = static_cast<ECosmeticEventType>(Type);
+
+		// 相对锚点量化到1单位
+		FVector Offset = Ar.IsSaving() ? (Event.Location - Anchor) : FVector::ZeroVector;
+		bOutSuccess &= SerializePackedVector<1, 20>(Offset, Ar);
+		if (Ar.IsLoading())
+		{
+			Event.Location = Anchor + Offset;
+		}
+
+		if (CosmeticEvents::NeedsActor(Event.Type) && Map)
+		{
+			UObject* Object = Event.Actor.Get();
+			bOutSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), Object);
+			Event.Actor = Cast<AActor>(Object);
+		}
+	}
+
+	return true;
+}
+
+void UCosmeticEventSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	TimeSinceLastFlush += DeltaTime;
+	if (TimeSinceLastFlush < FlushInterval || PendingEvents.Num() == 0)
+	{
+		return;
+	}
+	TimeSinceLastFlush = 0.0f;
+
+	SCOPE_CYCLE_COUNTER(STAT_CosmeticFlush);
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APlayerController* PC = It->Get())
+		{
+			FlushForController(PC);
+		}
+	}
+
+	PendingEvents.Reset();
+}
+
+TStatId UCosmeticEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCosmeticEventSubsystem, STATGROUP_Tickables);
+}
+
+void UCosmeticEventSubsystem::AddEvent(ECosmeticEventType Type, const FVector& Location, AActor* Actor)
+{
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FCosmeticEvent& Event = PendingEvents.AddDefaulted_GetRef();
+	Event.Type = Type;
+	Event.Location = Location;
+	Event.Actor = Actor;
+
+	INC_DWORD_STAT(STAT_CosmeticQueued);
+}
+
+void UCosmeticEventSubsystem::FlushForController(APlayerController* PC)
+{
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const APawn* OwnPawn = PC->GetPawn();
+	const AActor* ViewTarget = PC->GetViewTarget();
+
+	FCosmeticEventBatch Batch;
+	Batch.Anchor = ViewLocation.GridSnap(1.0f);
+
+	// 按优先级和距离收集候选事件
+	TArray<TPair<float, int32>, TInlineAllocator<64>> Candidates;
+	for (int32 Index = 0; Index < PendingEvents.Num(); ++Index)
+	{
+		const FCosmeticEvent& Event = PendingEvents[Index];
+		const int32 TypeIndex = static_cast<int32>(Event.Type);
+
+		// 射击者本地已经预测播放了自己的枪口效果
+		if (Event.Type == ECosmeticEventType::Muzzle && Event.Actor.Get() == OwnPawn)
+		{
+			continue;
+		}
+
+		const float DistSq = FVector::DistSquared(ViewLocation, Event.Location);
+		if (DistSq > FMath::Square(CosmeticEvents::CullDistance[TypeIndex]))
+		{
+			INC_DWORD_STAT(STAT_CosmeticCulled);
+			continue;
+		}
+
+		// 关联角色对该连接不相关时，客户端也无法播放
+		if (const AActor* Actor = Event.Actor.Get())
+		{
+			if (!PC->IsLocalController() && !Actor->IsNetRelevantFor(PC, ViewTarget, ViewLocation))
+			{
+				INC_DWORD_STAT(STAT_CosmeticCulled);
+				continue;
+			}
+		}
+
+		Candidates.Emplace(CosmeticEvents::Priority[TypeIndex] * CosmeticEvents::PriorityScale + DistSq, Index);
+	}
+
+	if (Candidates.Num() == 0)
+	{
+		return;
+	}
+
+	if (Candidates.Num() > FCosmeticEventBatch::MaxEvents)
+	{
+		Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+		INC_DWORD_STAT_BY(STAT_CosmeticCulled, Candidates.Num() - FCosmeticEventBatch::MaxEvents);
+		Candidates.SetNum(FCosmeticEventBatch::MaxEvents, false);
+	}
+
+	// 监听服务器的本地玩家直接播放
+	if (PC->IsLocalController())
+	{
+		for (const TPair<float, int32>& Candidate : Candidates)
+		{
+			PlayEvent(GetWorld(), PendingEvents[Candidate.Value]);
+		}
+		return;
+	}
+
+	AFirstPersonDemoPlayerController* DemoPC = Cast<AFirstPersonDemoPlayerController>(PC);
+	if (!DemoPC)
+	{
+		return;
+	}
+
+	for (const TPair<float, int32>& Candidate : Candidates)
+	{
+		Batch.Events.Add(PendingEvents[Candidate.Value]);
+	}
+
+	{
+		NetBandwidth::FRpcScope RpcScope(DemoPC, CosmeticEvents::NAME_ClientReceiveCosmeticEvents);
+		DemoPC->ClientReceiveCosmeticEvents(Batch);
+	}
+
+	INC_DWORD_STAT_BY(STAT_CosmeticSent, Batch.Events.Num());
+	INC_DWORD_STAT(STAT_CosmeticBatches);
+}
+
+void UCosmeticEventSubsystem::PlayEvent(UWorld* World, const FCosmeticEvent& Event)
+{
+	if (!ShouldPlayCosmetics(World))
+	{
+		return;
+	}
+
+	switch (Event.Type)
+	{
+	case ECosmeticEventType::Muzzle:
+		if (AFirstPersonDemoCharacter* Character = Cast<AFirstPersonDemoCharacter>(Event.Actor.Get()))
+		{
+			Character->PlayFireEffects();
+		}
+		break;
+
+	case ECosmeticEventType::Impact:
+		if (UVfxPoolSubsystem* VfxPool = World->GetSubsystem<UVfxPoolSubsystem>())
+		{
+			VfxPool->SpawnAtLocation(EPooledEffect::Impact, nullptr, Event.Location);
+		}
+		break;
+
+	case ECosmeticEventType::Death:
+		if (AEnemyAICharacter* Enemy = Cast<AEnemyAICharacter>(Event.Actor.Get()))
+		{
+			Enemy->PlayDeathEffects();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,100 @@
+// CosmeticEventSubsystem.h - 装饰性事件通道：按连接累积枪口、击中、死亡事件，每个网络帧合并为一个不可靠包发送
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CosmeticEventSubsystem.generated.h"
+
+class APlayerController;
+
+/**
+ * 装饰性事件类型
+ */
+UENUM()
+enum class ECosmeticEventType : uint8
+{
+	Muzzle,
+	Impact,
+	Death,
+
+	Count UMETA(Hidden)
+};
+
+/**
+ * 单个装饰性事件
+ */
+USTRUCT()
+struct FCosmeticEvent
+{
+	GENERATED_BODY()
+
+	ECosmeticEventType Type = ECosmeticEventType::Impact;
+
+	/** 世界坐标（网络传输时量化到1单位） */
+	FVector Location = FVector::ZeroVector;
+
+	/** 关联角色（只有枪口和死亡事件会序列化） */
+	TWeakObjectPtr<AActor> Actor;
+};
+
+/**
+ * 一个网络帧内发往某个连接的事件包
+ *
+ * 位置相对锚点（接收者视点）以1单位精度打包，近处事件只需很少的位数。
+ */
+USTRUCT()
+struct FCosmeticEventBatch
+{
+	GENERATED_BODY()
+
+	/** 每包最多事件数，决定每个客户端的带宽上限（最坏每包约268字节，按发送间隔约8.3KB/s，见README） */
+	static constexpr int32 MaxEvents = 24;
+
+	FVector Anchor = FVector::ZeroVector;
+
+	TArray<FCosmeticEvent, TInlineAllocator<MaxEvents>> Events;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FCosmeticEventBatch> : public TStructOpsTypeTraitsBase2<FCosmeticEventBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * 装饰性事件子系统 - 服务器累积事件，按相关性和距离筛选后发给每个连接
+ */
+UCLASS()
+class UCosmeticEventSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 发送间隔（秒） */
+	static constexpr float FlushInterval = 1.0f / 30.0f;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** 服务器：添加事件 */
+	void AddEvent(ECosmeticEventType Type, const FVector& Location, AActor* Actor = nullptr);
+
+	/** 本地播放事件 */
+	static void PlayEvent(UWorld* World, const FCosmeticEvent& Event);
+
+private:
+	/** 为一个连接筛选并发送事件 */
+	void FlushForController(APlayerController* PC);
+
+	/** 本帧累积的事件 */
+	TArray<FCosmeticEvent> PendingEvents;
+
+	/** 距上次发送的时间 */
+	float TimeSinceLastFlush = 0.0f;
+};
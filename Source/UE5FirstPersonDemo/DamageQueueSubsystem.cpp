@@ -0,0 +1,357 @@
+// DamageQueueSubsystem.cpp - 伤害队列实现
+
+#include "DamageQueueSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "EnemyAICharacter.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDamageQueue, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue Flush"), STAT_DamageQueueFlush, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Submitted"), STAT_DamageSubmitted, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Applied"), STAT_DamageApplied, STATGROUP_FirstPersonDemo);
+
+static int32 GDamageQueueEnabled = 1;
+static FAutoConsoleVariableRef CVarDamageQueueEnabled(
+	TEXT("fpd.DamageQueue.Enable"),
+	GDamageQueueEnabled,
+	TEXT("是否按帧合并伤害（0 = 每次命中立即调用TakeDamage）"));
+
+namespace DamageQueue
+{
+	/** 受害者当前生命值，用于确定击杀归属；未知类型视为不会被击杀 */
+	float GetVictimHealth(const AActor* Victim)
+	{
+		if (const AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(Victim))
+		{
+			return Player->Health;
+		}
+		if (const AEnemyAICharacter* Enemy = Cast<AEnemyAICharacter>(Victim))
+		{
+			return Enemy->GetHealth();
+		}
+		return TNumericLimits<float>::Max();
+	}
+
+	/** 一个受害者本帧的合并伤害 */
+	struct FVictimTotal
+	{
+		AActor* Victim = nullptr;
+		float Damage = 0.0f;
+		TArray<int32, TInlineAllocator<8>> Submissions;
+	};
+}
+
+void UDamageQueueSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDamageQueueSubsystem::OnWorldPostActorTick);
+}
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PendingDamage.Reset();
+
+	Super::Deinitialize();
+}
+
+void UDamageQueueSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		Flush();
+	}
+}
+
+void UDamageQueueSubsystem::SubmitDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, const FVector& HitLocation, const FVector& ShotDirection)
+{
+	if (!Victim || Damage == 0.0f)
+	{
+		return;
+	}
+
+	++NumSubmitted;
+	INC_DWORD_STAT(STAT_DamageSubmitted);
+
+	FDamageSubmission Submission;
+	Submission.Victim = Victim;
+	Submission.EventInstigator = EventInstigator;
+	Submission.DamageCauser = DamageCauser;
+	Submission.Damage = Damage;
+	Submission.HitLocation = HitLocation;
+	Submission.ShotDirection = ShotDirection;
+
+	if (!GDamageQueueEnabled)
+	{
+		ApplyDamage(Victim, Damage, Submission);
+		return;
+	}
+
+	PendingDamage.Add(MoveTemp(Submission));
+}
+
+int32 UDamageQueueSubsystem::ClearPending()
+{
+	const int32 NumCleared = PendingDamage.Num();
+	PendingDamage.Reset();
+	return NumCleared;
+}
+
+void UDamageQueueSubsystem::Flush()
+{
+	if (PendingDamage.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DamageQueueFlush);
+
+	// 结算过程中（例如死亡逻辑）新提交的伤害留到下一帧
+	TArray<FDamageSubmission> Submissions = MoveTemp(PendingDamage);
+	PendingDamage.Reset();
+
+	// 按受害者首次被提交的顺序合并
+	TArray<DamageQueue::FVictimTotal, TInlineAllocator<16>> Victims;
+	TMap<AActor*, int32, TInlineSetAllocator<16>> VictimIndices;
+
+	for (int32 Index = 0; Index < Submissions.Num(); ++Index)
+	{
+		const FDamageSubmission& Submission = Submissions[Index];
+		AActor* Victim = Submission.Victim.Get();
+		if (!IsValid(Victim))
+		{
+			continue;
+		}
+
+		int32& VictimIndex = VictimIndices.FindOrAdd(Victim, INDEX_NONE);
+		if (VictimIndex == INDEX_NONE)
+		{
+			VictimIndex = Victims.Num();
+			Victims.AddDefaulted_GetRef().Victim = Victim;
+		}
+
+		DamageQueue::FVictimTotal& Total = Victims[VictimIndex];
+		Total.Damage += Submission.Damage;
+		Total.Submissions.Add(Index);
+	}
+
+	for (const DamageQueue::FVictimTotal& Total : Victims)
+	{
+		// 累计伤害首次达到当前生命值的提交者获得击杀；未致死时归属最后一次提交
+		const float Health = DamageQueue::GetVictimHealth(Total.Victim);
+		int32 AttributedIndex = Total.Submissions.Last();
+
+		float Accumulated = 0.0f;
+		for (int32 Index : Total.Submissions)
+		{
+			Accumulated += Submissions[Index].Damage;
+			if (Accumulated >= Health)
+			{
+				AttributedIndex = Index;
+				break;
+			}
+		}
+
+		ApplyDamage(Total.Victim, Total.Damage, Submissions[AttributedIndex]);
+	}
+}
+
+void UDamageQueueSubsystem::ApplyDamage(AActor* Victim, float TotalDamage, const FDamageSubmission& Attributed)
+{
+	if (!IsValid(Victim))
+	{
+		return;
+	}
+
+	++NumApplied;
+	INC_DWORD_STAT(STAT_DamageApplied);
+
+	FHitResult HitInfo;
+	HitInfo.Location = Attributed.HitLocation;
+	HitInfo.ImpactPoint = Attributed.HitLocation;
+
+	const FPointDamageEvent DamageEvent(TotalDamage, HitInfo, Attributed.ShotDirection, UDamageType::StaticClass());
+	Victim->TakeDamage(TotalDamage, DamageEvent, Attributed.EventInstigator.Get(), Attributed.DamageCauser.Get());
+}
+
+/** 控制台命令：伤害队列压力测试，对比逐次结算和按帧合并时玩家和敌人的TakeDamage、生命值广播和生命值复制变化次数 */
+static FAutoConsoleCommandWithWorldAndArgs GDamageQueueStressCommand(
+	TEXT("fpd.DamageQueueStress"),
+	TEXT("伤害队列压力测试：fpd.DamageQueueStress [每帧每个受害者的命中数=20] [受害者数=16]，受害者一半是玩家角色、一半是敌人，连续5帧命中，")
+	TEXT("输出两种方式的TakeDamage次数、玩家生命值广播次数和帧末生命值变化（复制变化）次数"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UDamageQueueSubsystem* DamageQueue = World ? World->GetSubsystem<UDamageQueueSubsystem>() : nullptr;
+		if (!DamageQueue || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		const int32 HitsPerFrame = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20, 1);
+		const int32 NumVictims = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 16, 2);
+		const int32 NumPlayers = NumVictims / 2;
+		const int32 NumFrames = 5;
+		const int32 NumShooters = 4;
+
+		// 临时的受害者和伤害来源停放在可玩区域之外，不被AI控制，测试在本帧内完成后销毁
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.ObjectFlags |= RF_Transient;
+
+		const FTransform DummyTransform(FVector(0.0f, 0.0f, -60000.0f));
+		TArray<AActor*> Shooters;
+		for (int32 Index = 0; Index < NumShooters; ++Index)
+		{
+			if (AActor* Shooter = World->SpawnActor<AActor>(AActor::StaticClass(), DummyTransform, SpawnParams))
+			{
+				Shooters.Add(Shooter);
+			}
+		}
+
+		UDamageQueueStressProbe* Probe = NewObject<UDamageQueueStressProbe>();
+
+		// 进行中比赛的伤害先结算，不混入测试计数
+		DamageQueue->Flush();
+
+		struct FModeResult
+		{
+			int32 NumSubmitted = 0;
+			int32 NumApplied = 0;
+			int32 NumHealthBroadcasts = 0;
+			int32 NumPlayerRepChanges = 0;
+			int32 NumEnemyRepChanges = 0;
+			TArray<float> FinalHealth;
+			double Milliseconds = 0.0;
+		};
+
+		FModeResult Results[2];
+		const int32 SavedEnabled = GDamageQueueEnabled;
+		bool bAllPassed = true;
+
+		for (int32 bQueued = 0; bQueued <= 1; ++bQueued)
+		{
+			FModeResult& Result = Results[bQueued];
+			GDamageQueueEnabled = bQueued;
+			DamageQueue->ResetCounters();
+			Probe->NumHealthBroadcasts = 0;
+
+			// 每种方式使用新生成的满血受害者
+			TArray<AActor*> Victims;
+			for (int32 Index = 0; Index < NumVictims; ++Index)
+			{
+				APawn* Victim = (Index < NumPlayers)
+					? static_cast<APawn*>(World->SpawnActorDeferred<AFirstPersonDemoCharacter>(AFirstPersonDemoCharacter::StaticClass(), DummyTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn))
+					: static_cast<APawn*>(World->SpawnActorDeferred<AEnemyAICharacter>(AEnemyAICharacter::StaticClass(), DummyTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn));
+				if (!Victim)
+				{
+					bAllPassed = false;
+					continue;
+				}
+
+				Victim->AutoPossessAI = EAutoPossessAI::Disabled;
+				Victim->FinishSpawning(DummyTransform);
+				if (AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(Victim))
+				{
+					Player->OnHealthChangedDelegate.AddDynamic(Probe, &UDamageQueueStressProbe::OnHealthChanged);
+				}
+				Victims.Add(Victim);
+			}
+
+			// 每次命中的伤害使总伤害为满血的一半，受害者不会死亡
+			TArray<float> HitDamage;
+			TArray<float> LastHealth;
+			for (AActor* Victim : Victims)
+			{
+				const float Health = DamageQueue::GetVictimHealth(Victim);
+				HitDamage.Add(Health * 0.5f / (HitsPerFrame * NumFrames));
+				LastHealth.Add(Health);
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (int32 Hit = 0; Hit < HitsPerFrame; ++Hit)
+				{
+					AActor* Shooter = Shooters.Num() > 0 ? Shooters[Hit % Shooters.Num()] : nullptr;
+					for (int32 Index = 0; Index < Victims.Num(); ++Index)
+					{
+						DamageQueue->SubmitDamage(Victims[Index], HitDamage[Index], nullptr, Shooter, Victims[Index]->GetActorLocation(), FVector::ForwardVector);
+					}
+				}
+
+				// 帧末：合并的伤害在此结算，随后属性复制只比较此时的生命值
+				DamageQueue->Flush();
+				for (int32 Index = 0; Index < Victims.Num(); ++Index)
+				{
+					const float Health = DamageQueue::GetVictimHealth(Victims[Index]);
+					if (Health == LastHealth[Index])
+					{
+						continue;
+					}
+
+					LastHealth[Index] = Health;
+					if (Victims[Index]->IsA<AFirstPersonDemoCharacter>())
+					{
+						++Result.NumPlayerRepChanges;
+					}
+					else
+					{
+						++Result.NumEnemyRepChanges;
+					}
+				}
+			}
+			Result.Milliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			Result.NumSubmitted = DamageQueue->GetNumSubmitted();
+			Result.NumApplied = DamageQueue->GetNumApplied();
+			Result.NumHealthBroadcasts = Probe->NumHealthBroadcasts;
+			Result.FinalHealth = MoveTemp(LastHealth);
+
+			int32 NumPlayersSpawned = 0;
+			for (AActor* Victim : Victims)
+			{
+				NumPlayersSpawned += Victim->IsA<AFirstPersonDemoCharacter>() ? 1 : 0;
+				Victim->Destroy();
+			}
+
+			// 逐次结算时每次命中一次TakeDamage和一次广播，合并后每个受害者每帧一次；帧末生命值变化两种方式相同
+			const int32 FramesPerVictim = bQueued ? NumFrames : NumFrames * HitsPerFrame;
+			const int32 ExpectedApplied = Victims.Num() * FramesPerVictim;
+			const int32 ExpectedBroadcasts = NumPlayersSpawned * FramesPerVictim;
+			const int32 ExpectedRepChanges = Victims.Num() * NumFrames;
+			const bool bPassed = Result.NumApplied == ExpectedApplied && Result.NumHealthBroadcasts == ExpectedBroadcasts
+				&& Result.NumPlayerRepChanges + Result.NumEnemyRepChanges == ExpectedRepChanges;
+			bAllPassed &= bPassed;
+
+			UE_LOG(LogDamageQueue, Display, TEXT("%s %s: %d hits on %d players + %d enemies over %d frames -> %d TakeDamage (expected %d), %d player health broadcasts (expected %d), health rep changes %d players + %d enemies (expected %d), %.3f ms"),
+				bPassed ? TEXT("PASS") : TEXT("FAIL"), bQueued ? TEXT("Queued   ") : TEXT("Immediate"),
+				Result.NumSubmitted, NumPlayersSpawned, Victims.Num() - NumPlayersSpawned, NumFrames,
+				Result.NumApplied, ExpectedApplied, Result.NumHealthBroadcasts, ExpectedBroadcasts,
+				Result.NumPlayerRepChanges, Result.NumEnemyRepChanges, ExpectedRepChanges, Result.Milliseconds);
+		}
+
+		// 合并不改变结果：每个受害者的最终生命值相同
+		bool bHealthMatched = Results[0].FinalHealth.Num() == Results[1].FinalHealth.Num();
+		for (int32 Index = 0; bHealthMatched && Index < Results[0].FinalHealth.Num(); ++Index)
+		{
+			bHealthMatched = FMath::IsNearlyEqual(Results[0].FinalHealth[Index], Results[1].FinalHealth[Index], 0.01f);
+		}
+		bAllPassed &= bHealthMatched;
+		UE_LOG(LogDamageQueue, Display, TEXT("%s final health matches between immediate and queued"), bHealthMatched ? TEXT("PASS") : TEXT("FAIL"));
+
+		GDamageQueueEnabled = SavedEnabled;
+		DamageQueue->ResetCounters();
+
+		for (AActor* Shooter : Shooters)
+		{
+			Shooter->Destroy();
+		}
+
+		UE_LOG(LogDamageQueue, Display, TEXT("Damage queue stress test: %s"), bAllPassed ? TEXT("all passed") : TEXT("FAILED"));
+	}));
@@ -0,0 +1,90 @@
+// DamageQueueSubsystem.h - 服务器伤害队列：一帧内的命中按受害者合并，帧末各结算一次
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageQueueSubsystem.generated.h"
+
+/**
+ * 伤害队列子系统
+ *
+ * 射击、近战等伤害来源只提交伤害，不直接调用TakeDamage。帧末（所有Actor和Tickable对象更新之后、
+ * 网络复制之前）按受害者合并本帧的伤害，每个受害者只调用一次TakeDamage：
+ * 生命值只写一次、只广播一次生命值变化，死亡和计分也只处理一次。属性复制本来只发送帧末的值，
+ * 合并不减少生命值的复制变化（fpd.DamageQueueStress 同时输出两者）。
+ *
+ * 击杀归属是确定的：按提交顺序累加伤害，使累计伤害首次达到受害者当前生命值的那次提交者获得击杀；
+ * 未致死时归属最后一次提交者（用于受击反应）。
+ */
+UCLASS()
+class UDamageQueueSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** 服务器：提交一次伤害；关闭 fpd.DamageQueue.Enable 时立即结算 */
+	void SubmitDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, const FVector& HitLocation, const FVector& ShotDirection);
+
+	/** 结算所有排队的伤害（帧末自动调用） */
+	void Flush();
+
+	/** 丢弃本帧尚未结算的伤害（比赛软重置时），返回丢弃的提交数 */
+	int32 ClearPending();
+
+	/** 尚未结算的伤害提交数 */
+	int32 GetNumPending() const { return PendingDamage.Num(); }
+
+	/** 已提交的伤害次数 */
+	int32 GetNumSubmitted() const { return NumSubmitted; }
+
+	/** 实际调用TakeDamage的次数（每次对应一次生命值写入和一次生命值变化广播） */
+	int32 GetNumApplied() const { return NumApplied; }
+
+	/** 清零计数 */
+	void ResetCounters() { NumSubmitted = 0; NumApplied = 0; }
+
+private:
+	/** 一次提交的伤害 */
+	struct FDamageSubmission
+	{
+		TWeakObjectPtr<AActor> Victim;
+		TWeakObjectPtr<AController> EventInstigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+		float Damage = 0.0f;
+		FVector HitLocation = FVector::ZeroVector;
+		FVector ShotDirection = FVector::ZeroVector;
+	};
+
+	/** 帧末回调 */
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	/** 对受害者调用一次TakeDamage，伤害事件取自归属的那次提交 */
+	void ApplyDamage(AActor* Victim, float TotalDamage, const FDamageSubmission& Attributed);
+
+	/** 本帧提交的伤害（保持提交顺序） */
+	TArray<FDamageSubmission> PendingDamage;
+
+	FDelegateHandle PostActorTickHandle;
+
+	int32 NumSubmitted = 0;
+	int32 NumApplied = 0;
+};
+
+/**
+ * 伤害队列压力测试：统计玩家角色的生命值变化广播次数
+ */
+UCLASS(Transient)
+class UDamageQueueStressProbe : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	int32 NumHealthBroadcasts = 0;
+
+	UFUNCTION()
+	void OnHealthChanged(float NewHealth) { ++NumHealthBroadcasts; }
+};
@@ -2,7 +2,15 @@
 
 #include "EnemyAICharacter.h"
 #include "FirstPersonDemoCharacter.h"
-#include "AIController.h"
+#include "HitboxProxyComponent.h"
+#include "CosmeticEventSubsystem.h"
+#include "NetThreatPriority.h"
+#include "NetBandwidthStats.h"
+#include "DamageQueueSubsystem.h"
+#include "FirstPersonDemoGameMode.h"
+#include "EnemyPoolSubsystem.h"
+#include "FirstPersonDemoGameState.h"
+#include "EnemyAIController.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
@@ -11,14 +19,25 @@
 #include "Net/UnrealNetwork.h"
 #include "Perception/PawnSensingComponent.h"
 #include "DrawDebugHelpers.h"
+#include "UE5FirstPersonDemo.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogEnemyAI, Warning, All);
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Snapshots Interpolated"), STAT_EnemySnapshotInterpolated, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Snapshots Extrapolated"), STAT_EnemySnapshotExtrapolated, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Snapshots Held"), STAT_EnemySnapshotHeld, STATGROUP_FirstPersonDemo);
+
+namespace EnemyPoolParking
+{
+	/** 回池的敌人停放的位置（远离可玩区域，延迟补偿的射线也到不了） */
+	const FVector Location(0.0f, 0.0f, -50000.0f);
+}
+
 AEnemyAICharacter::AEnemyAICharacter()
 {
-	// 启用复制
+	// 启用复制（移动使用量化格式单独复制）
 	bReplicates = true;
-	bReplicateMovement = true;
+	SetReplicatingMovement(false);
 
 	// AI感知组件
 	UPawnSensingComponent* PawnSensing = CreateDefaultSubobject<UPawnSensingComponent>(TEXT("PawnSensing"));
@@ -27,6 +46,11 @@ AEnemyAICharacter::AEnemyAICharacter()
 	PawnSensing->HearingThreshold = 1000.0f;
 	PawnSensing->LOSHearingThreshold = 1500.0f;
 
+	// 武器射线只检测环境，角色由命中盒代理判定
+	HitboxProxy = CreateDefaultSubobject<UHitboxProxyComponent>(TEXT("HitboxProxy"));
+	GetCapsuleComponent()->SetCollisionResponseToChannel(TraceChannel_Weapon, ECR_Ignore);
+	GetMesh()->SetCollisionResponseToChannel(TraceChannel_Weapon, ECR_Ignore);
+
 	// 初始化属性
 	MaxHealth = 100.0f;
 	Health = MaxHealth;
@@ -45,8 +69,8 @@ AEnemyAICharacter::AEnemyAICharacter()
 	LastAttackTime = 0.0f;
 	bIsDead = false;
 
-	// 设置网络更新频率
-	NetUpdateFrequency = 50.0f;
+	// 设置网络更新频率（客户端快照插值，10~15Hz即可平滑）
+	NetUpdateFrequency = 15.0f;
 	MinNetUpdateFrequency = 10.0f;
 
 	// 初始化角色移动
@@ -54,7 +78,8 @@ AEnemyAICharacter::AEnemyAICharacter()
 	GetCharacterMovement()->bOrientRotationToMovement = true;
 	GetCharacterMovement()->RotationRate = FRotator(0.0f, 300.0f, 0.0f);
 
-	// 设置AI控制器
+	// 设置AI控制器（原生类作为战斗资产集的默认敌人类时也能运行默认行为树）
+	AIControllerClass = AEnemyAIController::StaticClass();
 	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
 }
 
@@ -64,6 +89,19 @@ void AEnemyAICharacter::BeginPlay()
 
 	// 初始状态为巡逻
 	SetEnemyState(EEnemyState::Patrol);
+
+	// 模拟代理的位置完全由快照插值驱动，关闭移动组件自身的模拟和平滑
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		GetCharacterMovement()->NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+		GetCharacterMovement()->SetComponentTickEnabled(false);
+	}
+
+	// 专用服务器不渲染，攻击伤害不依赖动画通知，网格不需要每帧更新姿势
+	if (!ShouldPlayCosmetics(GetWorld()))
+	{
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
 }
 
 void AEnemyAICharacter::Tick(float DeltaTime)
@@ -75,6 +113,25 @@ void AEnemyAICharacter::Tick(float DeltaTime)
 		return;
 	}
 
+	// 客户端模拟代理只做插值，状态逻辑由服务器执行
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		UpdateSimulatedMovement();
+		return;
+	}
+
+	// 服务器更新量化移动，只有数值变化时才更新时间戳并被复制
+	if (HasAuthority())
+	{
+		FEnemyReplicatedMovement NewMovement;
+		NewMovement.Pack(GetActorLocation(), GetActorRotation().Yaw, GetVelocity());
+		if (!NewMovement.HasSameMovement(QuantizedMovement))
+		{
+			NewMovement.SetServerTime(GetWorld()->GetTimeSeconds());
+			QuantizedMovement = NewMovement;
+		}
+	}
+
 	// 根据状态执行行为
 	switch (CurrentState)
 	{
@@ -137,6 +194,71 @@ void AEnemyAICharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 	DOREPLIFETIME(AEnemyAICharacter, CurrentState);
 	DOREPLIFETIME(AEnemyAICharacter, CurrentTarget);
 	DOREPLIFETIME(AEnemyAICharacter, bIsDead);
+	DOREPLIFETIME(AEnemyAICharacter, QuantizedMovement);
+}
+
+void AEnemyAICharacter::UpdateSimulatedMovement()
+{
+	const AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>();
+	if (!DemoGameState)
+	{
+		return;
+	}
+
+	FVector Location;
+	FVector Velocity;
+	float Yaw;
+
+	// 所有敌人在同一渲染时间采样
+	switch (MovementSnapshots.Sample(DemoGameState->GetEnemyRenderServerTime(), Location, Velocity, Yaw))
+	{
+	case ESnapshotSampleResult::None:
+		return;
+
+	case ESnapshotSampleResult::Interpolated:
+		INC_DWORD_STAT(STAT_EnemySnapshotInterpolated);
+		break;
+
+	case ESnapshotSampleResult::Extrapolated:
+		INC_DWORD_STAT(STAT_EnemySnapshotExtrapolated);
+		break;
+
+	case ESnapshotSampleResult::Held:
+		INC_DWORD_STAT(STAT_EnemySnapshotHeld);
+		break;
+	}
+
+	SetActorLocationAndRotation(Location, FRotator(0.0f, Yaw, 0.0f));
+
+	// 动画蓝图读取移动组件的速度
+	GetCharacterMovement()->Velocity = Velocity;
+}
+
+float AEnemyAICharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+	UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	const bool bTargetsViewer = CurrentTarget && (CurrentTarget == ViewTarget || CurrentTarget == Viewer);
+
+	const float Threat = NetThreatPriority::ComputeThreat(NetThreatPriority::GetEnemyStateWeight(CurrentState),
+		bTargetsViewer, GetActorLocation(), ViewPos, ViewDir, bLowBandwidth);
+
+	return NetThreatPriority::ComputePriority(NetPriority, Threat, Time);
+}
+
+void AEnemyAICharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	static const FName NAME_Health(TEXT("Health"));
+	static const FName NAME_CurrentState(TEXT("CurrentState"));
+	static const FName NAME_CurrentTarget(TEXT("CurrentTarget"));
+	static const FName NAME_IsDead(TEXT("bIsDead"));
+
+	// 量化移动由自己的NetSerialize统计；对象引用按NetGUID约32位估算
+	AccountedProperties.Track(this, NAME_Health, Health);
+	AccountedProperties.Track(this, NAME_CurrentState, static_cast<uint8>(CurrentState));
+	AccountedProperties.Track(this, NAME_CurrentTarget, static_cast<const void*>(CurrentTarget), 32);
+	AccountedProperties.Track(this, NAME_IsDead, static_cast<uint8>(bIsDead), 1);
 }
 
 float AEnemyAICharacter::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
@@ -152,7 +274,7 @@ float AEnemyAICharacter::TakeDamage(float DamageAmount, struct FDamageEvent cons
 		Health = FMath::Clamp(Health - ActualDamage, 0.0f, MaxHealth);
 
 		// 播放受伤音效
-		if (HurtSound)
+		if (HurtSound && ShouldPlayCosmetics(GetWorld()))
 		{
 			UGameplayStatics::PlaySoundAtLocation(this, HurtSound, GetActorLocation());
 		}
@@ -176,7 +298,7 @@ float AEnemyAICharacter::TakeDamage(float DamageAmount, struct FDamageEvent cons
 			if (AFirstPersonDemoCharacter* Killer = Cast<AFirstPersonDemoCharacter>(DamageCauser))
 			{
 				Killer->AddScore(ScoreReward);
-				Killer->KillCount++;
+				Killer->AddKill();
 			}
 		}
 
@@ -195,13 +317,15 @@ void AEnemyAICharacter::PerformMeleeAttack()
 
 	LastAttackTime = GetWorld()->GetTimeSeconds();
 
-	// 播放攻击动画
-	PlayAttackAnimation();
-
-	// 播放攻击音效
-	if (AttackSound)
+	// 播放攻击动画和音效
+	if (ShouldPlayCosmetics(GetWorld()))
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, AttackSound, GetActorLocation());
+		PlayAttackAnimation();
+
+		if (AttackSound)
+		{
+			UGameplayStatics::PlaySoundAtLocation(this, AttackSound, GetActorLocation());
+		}
 	}
 
 	// 检测攻击范围内的玩家
@@ -216,8 +340,12 @@ void AEnemyAICharacter::PerformMeleeAttack()
 			float Distance = FVector::Dist(GetActorLocation(), Player->GetActorLocation());
 			if (Distance <= AttackRange)
 			{
-				// 造成伤害
-				UGameplayStatics::ApplyDamage(Player, AttackDamage, GetController(), this, UDamageType::StaticClass());
+				// 造成伤害（帧末与本帧其他伤害合并结算）
+				if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+				{
+					DamageQueue->SubmitDamage(Player, AttackDamage, GetController(), this, Player->GetActorLocation(),
+						(Player->GetActorLocation() - GetActorLocation()).GetSafeNormal());
+				}
 			}
 		}
 	}
@@ -317,38 +445,154 @@ void AEnemyAICharacter::Die()
 	bIsDead = true;
 	SetEnemyState(EEnemyState::Dead);
 
-	// 播放死亡动画
-	PlayDeathAnimation();
-
-	// 播放死亡音效
-	if (DeathSound)
+	// 死亡动画和音效通过装饰性事件通道发给附近玩家
+	if (UCosmeticEventSubsystem* CosmeticEvents = GetWorld()->GetSubsystem<UCosmeticEventSubsystem>())
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, DeathSound, GetActorLocation());
+		CosmeticEvents->AddEvent(ECosmeticEventType::Death, GetActorLocation(), this);
 	}
 
 	// 禁用碰撞
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	// 启用布娃娃物理
-	GetMesh()->SetSimulatePhysics(true);
-	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	// 启用布娃娃物理（专用服务器上没人能看到）
+	if (ShouldPlayCosmetics(GetWorld()))
+	{
+		GetMesh()->SetSimulatePhysics(true);
+		GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	}
 
-	// 设置销毁定时器
+	// 设置回收定时器
 	if (HasAuthority())
 	{
-		FTimerHandle DeathTimer;
-		GetWorld()->GetTimerManager().SetTimer(DeathTimer, [this]()
+		// 通知游戏模式（波次推进和胜利条件）
+		if (AFirstPersonDemoGameMode* GM = Cast<AFirstPersonDemoGameMode>(GetWorld()->GetAuthGameMode()))
 		{
-			Destroy();
+			GM->OnEnemyDeath(this);
+		}
+
+		// 尸体保留5秒后回收到敌人池，下次生成时复用
+		GetWorld()->GetTimerManager().SetTimer(ReleaseTimerHandle, [this]()
+		{
+			if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+			{
+				EnemyPool->Release(this);
+			}
+			else
+			{
+				Destroy();
+			}
 		}, 5.0f, false);
 	}
 }
 
+void AEnemyAICharacter::DeactivateForPool()
+{
+	GetWorld()->GetTimerManager().ClearTimer(ReleaseTimerHandle);
+
+	// 解除控制会停止行为树，控制器保留到重新启用
+	if (AController* EnemyController = GetController())
+	{
+		PooledController = EnemyController;
+		EnemyController->UnPossess();
+	}
+
+	// 比赛重置时回收的敌人可能还活着，同样视为死亡：不受伤害，不计入存活数和影响图
+	bIsDead = true;
+	SetEnemyState(EEnemyState::Dead);
+	CurrentTarget = nullptr;
+
+	StopAnimMontage();
+	RestoreBody();
+	GetCharacterMovement()->StopMovementImmediately();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	SetActorLocation(EnemyPoolParking::Location, false, nullptr, ETeleportType::ResetPhysics);
+}
+
+void AEnemyAICharacter::ActivateFromPool(const FVector& Location, const FRotator& Rotation)
+{
+	GetWorld()->GetTimerManager().ClearTimer(ReleaseTimerHandle);
+
+	Health = MaxHealth;
+	bIsDead = false;
+	CurrentTarget = nullptr;
+	CurrentPatrolIndex = 0;
+	LastAttackTime = 0.0f;
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	RestoreBody();
+
+	// 与生成时相同：尽量避开阻挡，找不到合适位置时仍然放在原处
+	if (!TeleportTo(Location, Rotation))
+	{
+		SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	}
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	// 与BeginPlay相同，从巡逻开始
+	CurrentState = EEnemyState::Idle;
+	SetEnemyState(EEnemyState::Patrol);
+	QuantizedMovement.Pack(GetActorLocation(), GetActorRotation().Yaw, FVector::ZeroVector);
+	QuantizedMovement.SetServerTime(GetWorld()->GetTimeSeconds());
+
+	// 重新控制会重新初始化黑板并启动行为树
+	if (AController* EnemyController = PooledController.Get())
+	{
+		EnemyController->Possess(this);
+	}
+	else
+	{
+		SpawnDefaultController();
+	}
+	PooledController.Reset();
+}
+
+void AEnemyAICharacter::RestoreBody()
+{
+	const AEnemyAICharacter* Defaults = GetClass()->GetDefaultObject<AEnemyAICharacter>();
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+
+	if (MeshComponent->IsSimulatingPhysics())
+	{
+		MeshComponent->SetSimulatePhysics(false);
+	}
+	MeshComponent->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	MeshComponent->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+	MeshComponent->SetCollisionEnabled(Defaults->GetMesh()->GetCollisionEnabled());
+
+	GetCapsuleComponent()->SetCollisionEnabled(Defaults->GetCapsuleComponent()->GetCollisionEnabled());
+}
+
 float AEnemyAICharacter::GetHealthPercent() const
 {
 	return (MaxHealth > 0.0f) ? (Health / MaxHealth) : 0.0f;
 }
 
+void AEnemyAICharacter::PlayDeathEffects()
+{
+	if (!ShouldPlayCosmetics(GetWorld()))
+	{
+		return;
+	}
+
+	// 播放死亡动画
+	PlayDeathAnimation();
+
+	// 播放死亡音效
+	if (DeathSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, DeathSound, GetActorLocation());
+	}
+}
+
 void AEnemyAICharacter::PlayAttackAnimation()
 {
 	if (AttackMontage)
@@ -394,11 +638,66 @@ void AEnemyAICharacter::OnRep_Health()
 	// 生命值变化时的视觉效果（如果有）
 }
 
+void AEnemyAICharacter::OnRep_QuantizedMovement()
+{
+	// 模拟代理不直接跳到新位置，而是按服务器时间戳存入快照缓冲由Tick插值
+	if (GetLocalRole() != ROLE_SimulatedProxy || bIsDead)
+	{
+		return;
+	}
+
+	AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>();
+	if (!DemoGameState)
+	{
+		return;
+	}
+
+	FVector Location;
+	FVector Velocity;
+	float Yaw;
+	QuantizedMovement.Unpack(Location, Yaw, Velocity);
+
+	FEnemyRenderClock& RenderClock = DemoGameState->GetEnemyRenderClock();
+	const double ServerNow = DemoGameState->GetServerWorldTimeSeconds();
+	const double SnapshotTime = QuantizedMovement.UnpackServerTime(ServerNow);
+
+	// 只有连续移动的快照才计入延迟和间隔统计
+	const float Interval = MovementSnapshots.AddSnapshot(SnapshotTime, Location, Velocity, Yaw, RenderClock.GetMeanInterval());
+	if (Interval > 0.0f)
+	{
+		RenderClock.AddSample(static_cast<float>(ServerNow - SnapshotTime), Interval);
+	}
+}
+
 void AEnemyAICharacter::OnRep_IsDead()
 {
 	if (bIsDead)
 	{
-		GetMesh()->SetSimulatePhysics(true);
+		// 回池的敌人已经隐藏，不需要布娃娃
+		if (!IsHidden())
+		{
+			GetMesh()->SetSimulatePhysics(true);
+		}
 		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
+	else
+	{
+		// 从敌人池重新启用：恢复身体，丢弃回池前的快照，直接放到新位置
+		StopAnimMontage();
+		RestoreBody();
+
+		FVector Location;
+		FVector Velocity;
+		float Yaw;
+		QuantizedMovement.Unpack(Location, Yaw, Velocity);
+
+		MovementSnapshots.Reset();
+		SetActorLocationAndRotation(Location, FRotator(0.0f, Yaw, 0.0f));
+
+		if (AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>())
+		{
+			const double SnapshotTime = QuantizedMovement.UnpackServerTime(DemoGameState->GetServerWorldTimeSeconds());
+			MovementSnapshots.AddSnapshot(SnapshotTime, Location, Velocity, Yaw, DemoGameState->GetEnemyRenderClock().GetMeanInterval());
+		}
+	}
 }
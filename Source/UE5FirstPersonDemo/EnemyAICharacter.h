@@ -4,12 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "EnemySnapshotBuffer.h"
+#include "EnemyReplicatedMovement.h"
+#include "NetBandwidthStats.h"
 #include "EnemyAICharacter.generated.h"
 
 class UBehaviorTree;
 class AFirstPersonDemoCharacter;
 class UAnimMontage;
 class USoundBase;
+class UHitboxProxyComponent;
 
 UENUM(BlueprintType)
 enum class EEnemyState : uint8
@@ -40,6 +44,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = Gameplay)
 	float GetHealthPercent() const;
 
+	/** 获取当前生命值 */
+	float GetHealth() const { return Health; }
+
+	/** 是否已死亡 */
+	UFUNCTION(BlueprintPure, Category = Gameplay)
+	bool IsDead() const { return bIsDead; }
+
 	/** 造成近战伤害 */
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	void PerformMeleeAttack();
@@ -72,14 +83,34 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	void Die();
 
+	/** 播放死亡动画和音效（由装饰性事件通道触发） */
+	void PlayDeathEffects();
+
+	/** 对象池：停用并移到场景外（隐藏、关闭碰撞和移动、解除AI控制），视为已死亡 */
+	void DeactivateForPool();
+
+	/** 对象池：在新位置以满生命值重新启用并恢复AI控制 */
+	void ActivateFromPool(const FVector& Location, const FRotator& Rotation);
+
 	/** 网络复制 */
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/** 网络：按威胁度计算复制优先级 */
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+		UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
+	/** 网络：统计属性变化的带宽 */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
 protected:
 	/** 行为树 */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AI)
 	UBehaviorTree* BehaviorTree;
 
+	/** 命中盒代理（武器判定用，服务器注册到延迟补偿历史） */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat)
+	UHitboxProxyComponent* HitboxProxy;
+
 	/** 生命值 */
 	UPROPERTY(ReplicatedUsing=OnRep_Health, VisibleAnywhere, BlueprintReadOnly, Category = Gameplay)
 	float Health;
@@ -162,6 +193,13 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	int32 ScoreReward;
 
+	/** 量化后的移动（替代完整精度的移动复制） */
+	UPROPERTY(ReplicatedUsing=OnRep_QuantizedMovement)
+	FEnemyReplicatedMovement QuantizedMovement;
+
+	/** 带宽统计：复制属性的变化追踪 */
+	NetBandwidth::FPropertyTracker AccountedProperties;
+
 private:
 	/** 网络：生命值复制回调 */
 	UFUNCTION()
@@ -171,6 +209,10 @@ private:
 	UFUNCTION()
 	void OnRep_IsDead();
 
+	/** 网络：量化移动复制回调，写入快照缓冲 */
+	UFUNCTION()
+	void OnRep_QuantizedMovement();
+
 	/** 播放攻击动画 */
 	void PlayAttackAnimation();
 
@@ -179,4 +221,19 @@ private:
 
 	/** 寻找最近的可攻击玩家 */
 	AFirstPersonDemoCharacter* FindNearestPlayer() const;
+
+	/** 客户端：从快照缓冲插值移动 */
+	void UpdateSimulatedMovement();
+
+	/** 关闭布娃娃，网格重新挂回胶囊体，碰撞恢复为类默认值 */
+	void RestoreBody();
+
+	/** 客户端移动快照缓冲 */
+	FEnemySnapshotBuffer MovementSnapshots;
+
+	/** 死亡后回收到敌人池的计时器 */
+	FTimerHandle ReleaseTimerHandle;
+
+	/** 回池时解除控制的AI控制器，重新启用时再次控制 */
+	TWeakObjectPtr<AController> PooledController;
 };
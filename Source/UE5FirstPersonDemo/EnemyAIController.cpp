@@ -3,6 +3,8 @@
 #include "EnemyAIController.h"
 #include "EnemyAICharacter.h"
 #include "FirstPersonDemoCharacter.h"
+#include "CombatAssetSubsystem.h"
+#include "UE5FirstPersonDemo.h"
 #include "BehaviorTree/BehaviorTree.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
@@ -63,11 +65,13 @@ void AEnemyAIController::OnPossess(APawn* InPawn)
 
 	if (EnemyCharacter)
 	{
-		// 初始化并启动行为树
-		if (EnemyCharacter->BehaviorTree)
-		{
-			BehaviorTreeAsset = EnemyCharacter->BehaviorTree;
+		// 初始化并启动行为树（敌人未指定时使用常驻资产集中的行为树）
+		BehaviorTreeAsset = EnemyCharacter->BehaviorTree
+			? EnemyCharacter->BehaviorTree
+			: UCombatAssetSubsystem::Get<UBehaviorTree>(GetWorld(), ECombatAsset::EnemyBehaviorTree);
 
+		if (BehaviorTreeAsset)
+		{
 			// 初始化黑板
 			UBlackboardData* BlackboardAsset = BehaviorTreeAsset->BlackboardAsset;
 			if (UseBlackboard(BlackboardAsset, BlackboardComponent))
@@ -186,22 +190,17 @@ AActor* AEnemyAIController::FindPlayer() const
 
 					if (Angle <= EnemyCharacter->SightAngle)
 					{
-						// 检查视线遮挡
-						FHitResult HitResult;
-						FCollisionQueryParams Params;
-						Params.AddIgnoredActor(EnemyCharacter);
+						// 检查视线遮挡：武器通道只被环境阻挡，没有阻挡即可见
+						FCollisionQueryParams Params(SCENE_QUERY_STAT(EnemyFindPlayer), false, EnemyCharacter);
 
-						if (GetWorld()->LineTraceSingleByChannel(HitResult,
+						if (!GetWorld()->LineTraceTestByChannel(
 							EnemyCharacter->GetActorLocation(),
 							Player->GetActorLocation(),
-							ECC_Pawn,
+							TraceChannel_Weapon,
 							Params))
 						{
-							if (HitResult.GetActor() == Player)
-							{
-								NearestDistance = Distance;
-								NearestPlayer = Player;
-							}
+							NearestDistance = Distance;
+							NearestPlayer = Player;
 						}
 					}
 				}
@@ -0,0 +1,127 @@
+// EnemyPoolSubsystem.cpp - 敌人对象池实现
+
+#include "EnemyPoolSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "EnemyAICharacter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnemyPool, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Pool Reused"), STAT_EnemyPoolReused, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Pool Spawned"), STAT_EnemyPoolSpawned, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemy Pool Active"), STAT_EnemyPoolActive, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemy Pool Idle"), STAT_EnemyPoolIdle, STATGROUP_FirstPersonDemo);
+
+static int32 GEnemyPoolMaxPooled = 64;
+static FAutoConsoleVariableRef CVarEnemyPoolMaxPooled(
+	TEXT("fpd.EnemyPool.MaxPooled"),
+	GEnemyPoolMaxPooled,
+	TEXT("池中最多保留的空闲敌人数，超出时回收的敌人直接销毁"));
+
+void UEnemyPoolSubsystem::Deinitialize()
+{
+	ActiveEnemies.Reset();
+	PooledEnemies.Reset();
+
+	Super::Deinitialize();
+}
+
+AEnemyAICharacter* UEnemyPoolSubsystem::Acquire(TSubclassOf<AEnemyAICharacter> EnemyClass, const FVector& Location, const FRotator& Rotation)
+{
+	if (!EnemyClass)
+	{
+		return nullptr;
+	}
+
+	// 优先复用同类型的空闲敌人（池很小，线性查找即可）
+	AEnemyAICharacter* Enemy = nullptr;
+	for (int32 Index = PooledEnemies.Num() - 1; Index >= 0; --Index)
+	{
+		AEnemyAICharacter* Pooled = PooledEnemies[Index];
+		if (!IsValid(Pooled))
+		{
+			PooledEnemies.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (Pooled->GetClass() == EnemyClass)
+		{
+			PooledEnemies.RemoveAtSwap(Index);
+			Enemy = Pooled;
+			break;
+		}
+	}
+
+	if (Enemy)
+	{
+		Enemy->ActivateFromPool(Location, Rotation);
+		INC_DWORD_STAT(STAT_EnemyPoolReused);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		Enemy = GetWorld()->SpawnActor<AEnemyAICharacter>(EnemyClass, Location, Rotation, SpawnParams);
+		if (!Enemy)
+		{
+			return nullptr;
+		}
+		INC_DWORD_STAT(STAT_EnemyPoolSpawned);
+	}
+
+	ActiveEnemies.Add(Enemy);
+	UpdateStats();
+
+	return Enemy;
+}
+
+void UEnemyPoolSubsystem::Release(AEnemyAICharacter* Enemy)
+{
+	if (!IsValid(Enemy) || PooledEnemies.Contains(Enemy))
+	{
+		return;
+	}
+
+	ActiveEnemies.Remove(Enemy);
+
+	if (PooledEnemies.Num() >= GEnemyPoolMaxPooled)
+	{
+		Enemy->Destroy();
+	}
+	else
+	{
+		Enemy->DeactivateForPool();
+		PooledEnemies.Add(Enemy);
+	}
+
+	UpdateStats();
+}
+
+int32 UEnemyPoolSubsystem::ReleaseAll()
+{
+	const TArray<TWeakObjectPtr<AEnemyAICharacter>> ToRelease = ActiveEnemies.Array();
+	ActiveEnemies.Reset();
+
+	int32 NumReleased = 0;
+	for (const TWeakObjectPtr<AEnemyAICharacter>& Enemy : ToRelease)
+	{
+		if (Enemy.IsValid())
+		{
+			Release(Enemy.Get());
+			++NumReleased;
+		}
+	}
+
+	UE_LOG(LogEnemyPool, Verbose, TEXT("Released %d enemies, %d idle in pool"), NumReleased, PooledEnemies.Num());
+
+	UpdateStats();
+	return NumReleased;
+}
+
+void UEnemyPoolSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_EnemyPoolActive, ActiveEnemies.Num());
+	SET_DWORD_STAT(STAT_EnemyPoolIdle, PooledEnemies.Num());
+}
@@ -0,0 +1,53 @@
+// EnemyPoolSubsystem.h - 敌人对象池：死亡或比赛软重置时回收敌人，下次生成时复用，不再销毁和重新生成Actor
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPoolSubsystem.generated.h"
+
+class AEnemyAICharacter;
+
+/**
+ * 敌人池子系统
+ *
+ * 游戏模式通过 Acquire 取得敌人：池中有同类型的空闲敌人时原地复位后复用，否则生成新的。
+ * 敌人死亡后尸体保留一段时间再 Release 回池；比赛软重置时 ReleaseAll 回收场上所有敌人。
+ * 回池的敌人隐藏并移到场景外，关闭碰撞和移动，解除AI控制，视为已死亡。
+ * 空闲数量超过 fpd.EnemyPool.MaxPooled 时直接销毁。只在服务器使用。
+ */
+UCLASS()
+class UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem
+	virtual void Deinitialize() override;
+
+	/** 在指定位置取出一个敌人，失败时返回nullptr */
+	AEnemyAICharacter* Acquire(TSubclassOf<AEnemyAICharacter> EnemyClass, const FVector& Location, const FRotator& Rotation);
+
+	/** 回收敌人（池满时销毁） */
+	void Release(AEnemyAICharacter* Enemy);
+
+	/** 回收所有已取出的敌人，返回回收数量 */
+	int32 ReleaseAll();
+
+	/** 已取出（在场上，包括尸体）的敌人数 */
+	int32 GetNumActive() const { return ActiveEnemies.Num(); }
+
+	/** 池中空闲的敌人数 */
+	int32 GetNumPooled() const { return PooledEnemies.Num(); }
+
+private:
+	/** 更新统计 */
+	void UpdateStats() const;
+
+	/** 已取出的敌人 */
+	TSet<TWeakObjectPtr<AEnemyAICharacter>> ActiveEnemies;
+
+	/** 空闲的敌人 */
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemyAICharacter>> PooledEnemies;
+};
@@ -0,0 +1,222 @@
+// EnemyReplicatedMovement.cpp - 敌人量化移动复制实现
+
+#include "EnemyReplicatedMovement.h"
+#include "NetBandwidthStats.h"
+#include "Engine/ReplicatedState.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnemyMovement, Log, All);
+
+namespace EnemyMovementPacking
+{
+	const FName NAME_QuantizedMovement(TEXT("QuantizedMovement"));
+	const FName NAME_EnemyAICharacter(TEXT("EnemyAICharacter"));
+
+	/** 有符号整数限制到指定位数 */
+	int32 ClampSigned(int32 Value, int32 NumBits)
+	{
+		const int32 Limit = 1 << (NumBits - 1);
+		return FMath::Clamp(Value, -Limit, Limit - 1);
+	}
+
+	/** 以偏移二进制写入/读取固定位数的有符号整数 */
+	void SerializeSigned(FArchive& Ar, int32& Value, int32 NumBits)
+	{
+		const int32 Bias = 1 << (NumBits - 1);
+
+		uint32 Raw = Ar.IsSaving() ? static_cast<uint32>(ClampSigned(Value, NumBits) + Bias) : 0;
+		Ar.SerializeBits(&Raw, NumBits);
+
+		if (Ar.IsLoading())
+		{
+			Value = static_cast<int32>(Raw & ((1u << NumBits) - 1)) - Bias;
+		}
+	}
+
+	/** 写入/读取固定位数的无符号整数 */
+	void SerializeUnsigned(FArchive& Ar, int32& Value, int32 NumBits)
+	{
+		const uint32 Mask = (1u << NumBits) - 1;
+
+		uint32 Raw = Ar.IsSaving() ? (static_cast<uint32>(Value) & Mask) : 0;
+		Ar.SerializeBits(&Raw, NumBits);
+
+		if (Ar.IsLoading())
+		{
+			Value = static_cast<int32>(Raw & Mask);
+		}
+	}
+}
+
+void FEnemyReplicatedMovement::Pack(const FVector& Location, float Yaw, const FVector& Velocity)
+{
+	using namespace EnemyMovementPacking;
+
+	const int32 OffsetRange = 1 << OffsetBits;
+
+	// 先整体定点化再拆分单元和偏移：舍入到单元上边界时进位到下一个单元，误差不超过半个步长
+	const int64 FixedX = FMath::RoundToInt64(Location.X / CellSize * OffsetRange);
+	const int64 FixedY = FMath::RoundToInt64(Location.Y / CellSize * OffsetRange);
+
+	CellX = ClampSigned(static_cast<int32>(FixedX >> OffsetBits), CellBits);
+	CellY = ClampSigned(static_cast<int32>(FixedY >> OffsetBits), CellBits);
+
+	OffsetX = static_cast<int32>(FixedX & (OffsetRange - 1));
+	OffsetY = static_cast<int32>(FixedY & (OffsetRange - 1));
+
+	Height = ClampSigned(FMath::RoundToInt(Location.Z * HeightScale), HeightBits);
+	PackedYaw = FRotator::CompressAxisToByte(Yaw);
+
+	VelocityX = ClampSigned(FMath::RoundToInt(Velocity.X), VelocityBits);
+	VelocityY = ClampSigned(FMath::RoundToInt(Velocity.Y), VelocityBits);
+}
+
+void FEnemyReplicatedMovement::Unpack(FVector& OutLocation, float& OutYaw, FVector& OutVelocity) const
+{
+	const float OffsetScale = CellSize / (1 << OffsetBits);
+
+	OutLocation.X = CellX * CellSize + OffsetX * OffsetScale;
+	OutLocation.Y = CellY * CellSize + OffsetY * OffsetScale;
+	OutLocation.Z = Height / HeightScale;
+
+	OutYaw = FRotator::DecompressAxisFromByte(static_cast<uint8>(PackedYaw));
+
+	OutVelocity = FVector(VelocityX, VelocityY, 0.0f);
+}
+
+void FEnemyReplicatedMovement::SetServerTime(double ServerTime)
+{
+	ServerTimeMs = static_cast<int32>(static_cast<int64>(FMath::FloorToDouble(ServerTime * 1000.0)) & ((1 << TimeBits) - 1));
+}
+
+double FEnemyReplicatedMovement::UnpackServerTime(double ReferenceTime) const
+{
+	const int64 Range = 1 << TimeBits;
+	const int64 ReferenceMs = static_cast<int64>(FMath::FloorToDouble(ReferenceTime * 1000.0));
+
+	// 在参照时间所在的回绕周期内还原，再修正到距参照时间半个周期以内
+	int64 TimeMs = (ReferenceMs & ~(Range - 1)) + ServerTimeMs;
+	if (TimeMs > ReferenceMs + Range / 2)
+	{
+		TimeMs -= Range;
+	}
+	else if (TimeMs < ReferenceMs - Range / 2)
+	{
+		TimeMs += Range;
+	}
+
+	return TimeMs / 1000.0;
+}
+
+bool FEnemyReplicatedMovement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace EnemyMovementPacking;
+
+	NetBandwidth::FSerializeScope BandwidthScope(Ar, Map, EnemyMovementPacking::NAME_QuantizedMovement, EnemyMovementPacking::NAME_EnemyAICharacter);
+
+	SerializeSigned(Ar, CellX, CellBits);
+	SerializeSigned(Ar, CellY, CellBits);
+	SerializeUnsigned(Ar, OffsetX, OffsetBits);
+	SerializeUnsigned(Ar, OffsetY, OffsetBits);
+	SerializeSigned(Ar, Height, HeightBits);
+	SerializeUnsigned(Ar, PackedYaw, YawBits);
+	SerializeSigned(Ar, VelocityX, VelocityBits);
+	SerializeSigned(Ar, VelocityY, VelocityBits);
+	SerializeUnsigned(Ar, ServerTimeMs, TimeBits);
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+/** 控制台命令：量化移动的序列化往返测试，检查还原误差并与FRepMovement比较每次更新的位数 */
+static FAutoConsoleCommand GMovementPackTestCommand(
+	TEXT("fpd.MovementPackTest"),
+	TEXT("敌人量化移动往返测试：随机位置/偏航/速度经过序列化和还原后检查误差上限，并输出与FRepMovement的位数对比"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		constexpr int32 NumSamples = 10000;
+
+		// 各分量的误差上限：量化步长的一半（加浮点余量）
+		const float MaxLocationError = FEnemyReplicatedMovement::CellSize / (1 << FEnemyReplicatedMovement::OffsetBits) * 0.5f + 0.01f;
+		const float MaxHeightError = 0.5f / FEnemyReplicatedMovement::HeightScale + 0.01f;
+		const float MaxYawError = 360.0f / (1 << FEnemyReplicatedMovement::YawBits) * 0.5f + 0.01f;
+		const float MaxVelocityError = 0.5f + 0.01f;
+
+		FRandomStream Random(30);
+		float WorstLocation = 0.0f;
+		float WorstHeight = 0.0f;
+		float WorstYaw = 0.0f;
+		float WorstVelocity = 0.0f;
+		int32 NumMismatched = 0;
+		int32 NumTimeErrors = 0;
+		int64 PackedBits = 0;
+		int64 RepMovementBits = 0;
+
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			const FVector Location(Random.FRandRange(-200000.0f, 200000.0f), Random.FRandRange(-200000.0f, 200000.0f), Random.FRandRange(-20000.0f, 20000.0f));
+			const float Yaw = Random.FRandRange(-180.0f, 180.0f);
+			const FVector Velocity(Random.FRandRange(-1000.0f, 1000.0f), Random.FRandRange(-1000.0f, 1000.0f), 0.0f);
+			const double ServerTime = Random.FRandRange(0.0f, 20000.0f);
+
+			FEnemyReplicatedMovement Movement;
+			Movement.Pack(Location, Yaw, Velocity);
+			Movement.SetServerTime(ServerTime);
+
+			FBitWriter Writer(0, true);
+			bool bSuccess = false;
+			Movement.NetSerialize(Writer, nullptr, bSuccess);
+			PackedBits += Writer.GetNumBits();
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FEnemyReplicatedMovement Received;
+			Received.NetSerialize(Reader, nullptr, bSuccess);
+			NumMismatched += (bSuccess && Received == Movement) ? 0 : 1;
+
+			FVector OutLocation, OutVelocity;
+			float OutYaw;
+			Received.Unpack(OutLocation, OutYaw, OutVelocity);
+
+			WorstLocation = FMath::Max(WorstLocation, static_cast<float>(FMath::Max(FMath::Abs(OutLocation.X - Location.X), FMath::Abs(OutLocation.Y - Location.Y))));
+			WorstHeight = FMath::Max(WorstHeight, static_cast<float>(FMath::Abs(OutLocation.Z - Location.Z)));
+			WorstYaw = FMath::Max(WorstYaw, FMath::Abs(FMath::FindDeltaAngleDegrees(Yaw, OutYaw)));
+			WorstVelocity = FMath::Max(WorstVelocity, static_cast<float>(FMath::Max(FMath::Abs(OutVelocity.X - Velocity.X), FMath::Abs(OutVelocity.Y - Velocity.Y))));
+
+			// 时间戳在参照时间前后半个回绕周期内都应还原到原毫秒值
+			const double ReferenceTime = ServerTime + Random.FRandRange(-30.0f, 30.0f);
+			NumTimeErrors += FMath::Abs(Received.UnpackServerTime(ReferenceTime) - FMath::FloorToDouble(ServerTime * 1000.0) / 1000.0) < 0.0005 ? 0 : 1;
+
+			FRepMovement RepMovement;
+			RepMovement.Location = Location;
+			RepMovement.Rotation = FRotator(0.0f, Yaw, 0.0f);
+			RepMovement.LinearVelocity = Velocity;
+
+			FBitWriter RepWriter(0, true);
+			RepMovement.NetSerialize(RepWriter, nullptr, bSuccess);
+			RepMovementBits += RepWriter.GetNumBits();
+		}
+
+		int32 NumFailed = 0;
+		auto Check = [&NumFailed](const TCHAR* Name, float Worst, float Limit)
+		{
+			const bool bPassed = Worst <= Limit;
+			NumFailed += bPassed ? 0 : 1;
+			UE_LOG(LogEnemyMovement, Display, TEXT("%s %s: worst error %.4f (limit %.4f)"), bPassed ? TEXT("PASS") : TEXT("FAIL"), Name, Worst, Limit);
+		};
+
+		Check(TEXT("location"), WorstLocation, MaxLocationError);
+		Check(TEXT("height"), WorstHeight, MaxHeightError);
+		Check(TEXT("yaw"), WorstYaw, MaxYawError);
+		Check(TEXT("velocity"), WorstVelocity, MaxVelocityError);
+
+		const bool bSerializationPassed = NumMismatched == 0 && NumTimeErrors == 0 && PackedBits == static_cast<int64>(NumSamples) * FEnemyReplicatedMovement::NumBits;
+		NumFailed += bSerializationPassed ? 0 : 1;
+		UE_LOG(LogEnemyMovement, Display, TEXT("%s serialization: %d mismatched, %d timestamp errors"),
+			bSerializationPassed ? TEXT("PASS") : TEXT("FAIL"), NumMismatched, NumTimeErrors);
+
+		UE_LOG(LogEnemyMovement, Display, TEXT("Bits per update: %.1f quantized vs %.1f FRepMovement"),
+			static_cast<double>(PackedBits) / NumSamples, static_cast<double>(RepMovementBits) / NumSamples);
+		UE_LOG(LogEnemyMovement, Display, TEXT("Movement pack test: %s"), NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+	}));
@@ -0,0 +1,94 @@
+// EnemyReplicatedMovement.h - 敌人量化移动复制格式：网格单元相对位置 + 8位偏航 + 二维速度 + 服务器时间戳，固定位数
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnemyReplicatedMovement.generated.h"
+
+/**
+ * 敌人复制移动
+ *
+ * 敌人只需要偏航角，并且主要在地面平面移动，因此不使用完整精度的FRepMovement
+ * （位置、旋转、线速度、角速度和标志位，通常在150~250位之间）。
+ *
+ * 位数分配（共 NumBits 位，约16字节）：
+ *   网格单元 X/Y      各12位  （单元边长 CellSize，覆盖 ±2048 个单元）
+ *   单元内偏移 X/Y    各16位  （CellSize / 65536 精度）
+ *   高度 Z            20位    （0.25 单位精度）
+ *   偏航              8位     （约1.4度）
+ *   水平速度 X/Y      各12位  （1 单位/秒，±2047）
+ *   服务器时间        16位    （毫秒，按65536取模，约65秒回绕）
+ *
+ * 时间戳是服务器生成该状态的时间，客户端按它插值而不是按到达时间，网络抖动不会变成位置误差。
+ * 回绕由客户端以估计的服务器时间为参照还原。
+ */
+USTRUCT()
+struct FEnemyReplicatedMovement
+{
+	GENERATED_BODY()
+
+	/** 网格单元边长 */
+	static constexpr float CellSize = 4096.0f;
+
+	static constexpr int32 CellBits = 12;
+	static constexpr int32 OffsetBits = 16;
+	static constexpr int32 HeightBits = 20;
+	static constexpr int32 YawBits = 8;
+	static constexpr int32 VelocityBits = 12;
+	static constexpr int32 TimeBits = 16;
+
+	/** 高度精度 */
+	static constexpr float HeightScale = 4.0f;
+
+	static constexpr int32 NumBits = 2 * CellBits + 2 * OffsetBits + HeightBits + YawBits + 2 * VelocityBits + TimeBits;
+
+	int32 CellX = 0;
+	int32 CellY = 0;
+	int32 OffsetX = 0;
+	int32 OffsetY = 0;
+	int32 Height = 0;
+	int32 PackedYaw = 0;
+	int32 VelocityX = 0;
+	int32 VelocityY = 0;
+	int32 ServerTimeMs = 0;
+
+	/** 由世界坐标、偏航和速度量化 */
+	void Pack(const FVector& Location, float Yaw, const FVector& Velocity);
+
+	/** 还原为世界坐标、偏航和速度 */
+	void Unpack(FVector& OutLocation, float& OutYaw, FVector& OutVelocity) const;
+
+	/** 记录服务器时间（毫秒，按 TimeBits 取模） */
+	void SetServerTime(double ServerTime);
+
+	/** 还原服务器时间：取与参照时间最接近的回绕值 */
+	double UnpackServerTime(double ReferenceTime) const;
+
+	/** 量化后的移动是否相同（不比较时间戳） */
+	bool HasSameMovement(const FEnemyReplicatedMovement& Other) const
+	{
+		return CellX == Other.CellX && CellY == Other.CellY
+			&& OffsetX == Other.OffsetX && OffsetY == Other.OffsetY
+			&& Height == Other.Height && PackedYaw == Other.PackedYaw
+			&& VelocityX == Other.VelocityX && VelocityY == Other.VelocityY;
+	}
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FEnemyReplicatedMovement& Other) const
+	{
+		return HasSameMovement(Other) && ServerTimeMs == Other.ServerTimeMs;
+	}
+};
+
+static_assert(FEnemyReplicatedMovement::NumBits == 124, "敌人移动复制的位数预算已改变");
+
+template<>
+struct TStructOpsTypeTraits<FEnemyReplicatedMovement> : public TStructOpsTypeTraitsBase2<FEnemyReplicatedMovement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
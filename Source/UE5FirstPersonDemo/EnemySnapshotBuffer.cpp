@@ -0,0 +1,332 @@
+// EnemySnapshotBuffer.cpp - 敌人快照缓冲实现与位置误差测试
+
+#include "EnemySnapshotBuffer.h"
+#include "EnemyReplicatedMovement.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnemySnapshot, Log, All);
+
+namespace EnemySnapshot
+{
+	/** 延迟和间隔统计的平滑系数 */
+	constexpr float StatSmoothing = 0.1f;
+
+	/** 延迟调整的平滑系数（避免播放速度突变） */
+	constexpr float DelaySmoothing = 0.05f;
+
+	/** 超过此间隔视为断流，不计入统计（秒） */
+	constexpr float MaxTrackedInterval = 1.0f;
+
+	/** 低于此速度（单位/秒）的快照视为静止 */
+	constexpr float StationarySpeed = 1.0f;
+}
+
+void FEnemyRenderClock::AddSample(float Latency, float Interval)
+{
+	if (!bHasLatency)
+	{
+		MeanLatency = Latency;
+		bHasLatency = true;
+	}
+	else
+	{
+		MeanLatency = FMath::Lerp(MeanLatency, Latency, EnemySnapshot::StatSmoothing);
+		LatencyJitter = FMath::Lerp(LatencyJitter, FMath::Abs(Latency - MeanLatency), EnemySnapshot::StatSmoothing);
+	}
+
+	if (Interval > 0.0f)
+	{
+		MeanInterval = FMath::Lerp(MeanInterval, Interval, EnemySnapshot::StatSmoothing);
+	}
+
+	// 渲染时间落后最新快照至少一个间隔，再留两倍抖动的余量
+	const float TargetDelay = FMath::Clamp(MeanLatency + MeanInterval + 2.0f * LatencyJitter, MinDelay, MaxDelay);
+	Delay = FMath::Lerp(Delay, TargetDelay, EnemySnapshot::DelaySmoothing);
+}
+
+float FEnemySnapshotBuffer::AddSnapshot(double ServerTime, const FVector& Location, const FVector& Velocity, float Yaw, float HoldInterval)
+{
+	float Interval = 0.0f;
+	if (Count > 0)
+	{
+		const FEnemyMovementSnapshot& Newest = Get(0);
+		if (ServerTime <= Newest.ServerTime)
+		{
+			return 0.0f;
+		}
+
+		Interval = static_cast<float>(ServerTime - Newest.ServerTime);
+
+		// 静止的敌人不复制，间隔只反映静止时长：补一个停留快照，且不计入间隔统计
+		if (Newest.Velocity.SizeSquared2D() < FMath::Square(EnemySnapshot::StationarySpeed))
+		{
+			if (Interval > HoldInterval)
+			{
+				FEnemyMovementSnapshot Hold = Newest;
+				Hold.ServerTime = ServerTime - HoldInterval;
+				Push(Hold);
+			}
+			Interval = 0.0f;
+		}
+		else if (Interval >= EnemySnapshot::MaxTrackedInterval)
+		{
+			Interval = 0.0f;
+		}
+	}
+
+	FEnemyMovementSnapshot Snapshot;
+	Snapshot.ServerTime = ServerTime;
+	Snapshot.Location = Location;
+	Snapshot.Velocity = Velocity;
+	Snapshot.Yaw = Yaw;
+	Push(Snapshot);
+
+	return Interval;
+}
+
+void FEnemySnapshotBuffer::Push(const FEnemyMovementSnapshot& Snapshot)
+{
+	Snapshots[Head] = Snapshot;
+	Head = (Head + 1) % Capacity;
+	Count = FMath::Min(Count + 1, Capacity);
+}
+
+ESnapshotSampleResult FEnemySnapshotBuffer::Sample(double RenderTime, FVector& OutLocation, FVector& OutVelocity, float& OutYaw) const
+{
+	if (Count == 0)
+	{
+		return ESnapshotSampleResult::None;
+	}
+
+	const FEnemyMovementSnapshot& Newest = Get(0);
+
+	// 超出最新快照：按最新速度外推一小段时间
+	if (RenderTime >= Newest.ServerTime)
+	{
+		const float Ahead = static_cast<float>(RenderTime - Newest.ServerTime);
+		const float ExtrapolationTime = FMath::Min(Ahead, MaxExtrapolation);
+
+		OutLocation = Newest.Location + Newest.Velocity * ExtrapolationTime;
+		OutVelocity = (Ahead <= MaxExtrapolation) ? Newest.Velocity : FVector::ZeroVector;
+		OutYaw = Newest.Yaw;
+		return (Ahead <= MaxExtrapolation) ? ESnapshotSampleResult::Extrapolated : ESnapshotSampleResult::Held;
+	}
+
+	// 查找包围渲染时间的两个快照
+	for (int32 AgeIndex = 1; AgeIndex < Count; ++AgeIndex)
+	{
+		const FEnemyMovementSnapshot& Before = Get(AgeIndex);
+		if (Before.ServerTime <= RenderTime)
+		{
+			const FEnemyMovementSnapshot& After = Get(AgeIndex - 1);
+			const double Span = After.ServerTime - Before.ServerTime;
+			const float Alpha = (Span > KINDA_SMALL_NUMBER) ? static_cast<float>((RenderTime - Before.ServerTime) / Span) : 1.0f;
+
+			OutLocation = FMath::Lerp(Before.Location, After.Location, Alpha);
+			OutVelocity = FMath::Lerp(Before.Velocity, After.Velocity, Alpha);
+			OutYaw = Before.Yaw + FMath::FindDeltaAngleDegrees(Before.Yaw, After.Yaw) * Alpha;
+			return ESnapshotSampleResult::Interpolated;
+		}
+	}
+
+	// 比最旧快照还早（刚开始接收），停在最旧快照
+	const FEnemyMovementSnapshot& Oldest = Get(Count - 1);
+	OutLocation = Oldest.Location;
+	OutVelocity = Oldest.Velocity;
+	OutYaw = Oldest.Yaw;
+	return ESnapshotSampleResult::Interpolated;
+}
+
+void FEnemySnapshotBuffer::Reset()
+{
+	Head = 0;
+	Count = 0;
+}
+
+namespace EnemySnapshotTest
+{
+	constexpr double Duration = 30.0;
+	constexpr double WarmUp = 3.0;
+	constexpr double ServerTickInterval = 1.0 / 60.0;
+	constexpr double ClientFrameInterval = 1.0 / 60.0;
+
+	/** 单程延迟、抖动、丢包率，以及客户端估计的服务器时间的偏差 */
+	constexpr double Latency = 0.04;
+	constexpr double Jitter = 0.03;
+	constexpr float LossRate = 0.05f;
+	constexpr double ClockBias = -0.02;
+
+	/** 服务器轨迹（6秒一个周期）：直线行走、停下、沿圆弧转弯、停下 */
+	void EvaluateTrajectory(double Time, FVector& OutLocation, FVector& OutVelocity)
+	{
+		constexpr double Period = 6.0;
+		constexpr double WalkSpeed = 400.0;
+		constexpr double ArcRadius = 500.0;
+		constexpr double ArcSpeed = 300.0;
+		constexpr double ArcAngle = ArcSpeed / ArcRadius * 2.0;
+
+		const FVector ArcCenter(WalkSpeed * 2.0, ArcRadius, 100.0);
+		const FVector PeriodOffset = ArcCenter + FVector(FMath::Sin(ArcAngle), -FMath::Cos(ArcAngle), 0.0) * ArcRadius - FVector(0.0, 0.0, 100.0);
+
+		const double NumPeriods = FMath::FloorToDouble(Time / Period);
+		const double Local = Time - NumPeriods * Period;
+		const FVector Base = PeriodOffset * NumPeriods + FVector(0.0, 0.0, 100.0);
+
+		if (Local < 2.0)
+		{
+			OutLocation = Base + FVector(WalkSpeed * Local, 0.0, 0.0);
+			OutVelocity = FVector(WalkSpeed, 0.0, 0.0);
+			return;
+		}
+
+		const double Angle = FMath::Clamp(Local - 3.0, 0.0, 2.0) * ArcSpeed / ArcRadius;
+		OutLocation = Base + ArcCenter - FVector(0.0, 0.0, 100.0) + FVector(FMath::Sin(Angle), -FMath::Cos(Angle), 0.0) * ArcRadius;
+		OutVelocity = (Local >= 3.0 && Local < 5.0) ? FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * ArcSpeed : FVector::ZeroVector;
+	}
+
+	struct FResult
+	{
+		double MeanError = 0.0;
+		double P95Error = 0.0;
+		double MaxError = 0.0;
+		int32 NumSnapshots = 0;
+		int32 NumFrames = 0;
+		int32 NumExtrapolated = 0;
+		int32 NumHeld = 0;
+		float FinalDelay = 0.0f;
+	};
+
+	/** 以指定发送频率模拟服务器复制和客户端渲染，统计渲染位置与服务器轨迹的误差 */
+	FResult Simulate(float UpdateRate, int32 Seed)
+	{
+		struct FPacket
+		{
+			double ArrivalTime;
+			FEnemyReplicatedMovement Movement;
+		};
+
+		FRandomStream Random(Seed);
+		TArray<FPacket> Packets;
+
+		// 服务器：每Tick量化，只有量化值变化时更新时间戳；按发送频率复制，丢失的更新在下次发送最新值
+		FEnemyReplicatedMovement Current;
+		bool bDirty = false;
+		double NextNetUpdate = 0.0;
+		for (double Now = 0.0; Now < Duration; Now += ServerTickInterval)
+		{
+			FVector Location, Velocity;
+			EvaluateTrajectory(Now, Location, Velocity);
+
+			FEnemyReplicatedMovement Movement;
+			Movement.Pack(Location, Velocity.IsNearlyZero() ? 0.0f : static_cast<float>(Velocity.Rotation().Yaw), Velocity);
+			if (!Movement.HasSameMovement(Current))
+			{
+				Movement.SetServerTime(Now);
+				Current = Movement;
+				bDirty = true;
+			}
+
+			if (Now >= NextNetUpdate)
+			{
+				NextNetUpdate += 1.0 / UpdateRate;
+				if (bDirty && Random.FRand() >= LossRate)
+				{
+					Packets.Add({ Now + Latency + Random.FRand() * Jitter, Current });
+					bDirty = false;
+				}
+			}
+		}
+
+		Packets.StableSort([](const FPacket& A, const FPacket& B) { return A.ArrivalTime < B.ArrivalTime; });
+
+		// 客户端：按到达时间写入缓冲，每帧在渲染时间采样，与服务器在该时间的真实位置比较
+		FEnemyRenderClock Clock;
+		FEnemySnapshotBuffer Buffer;
+		FResult Result;
+		TArray<double> Errors;
+		int32 NextPacket = 0;
+
+		for (double ClientTime = 0.0; ClientTime < Duration; ClientTime += ClientFrameInterval)
+		{
+			const double ServerNow = ClientTime + ClockBias;
+			for (; NextPacket < Packets.Num() && Packets[NextPacket].ArrivalTime <= ClientTime; ++NextPacket)
+			{
+				const FEnemyReplicatedMovement& Movement = Packets[NextPacket].Movement;
+				FVector Location, Velocity;
+				float Yaw;
+				Movement.Unpack(Location, Yaw, Velocity);
+
+				const double SnapshotTime = Movement.UnpackServerTime(ServerNow);
+				const float Interval = Buffer.AddSnapshot(SnapshotTime, Location, Velocity, Yaw, Clock.GetMeanInterval());
+				if (Interval > 0.0f)
+				{
+					Clock.AddSample(static_cast<float>(ServerNow - SnapshotTime), Interval);
+				}
+				++Result.NumSnapshots;
+			}
+
+			if (ClientTime < WarmUp)
+			{
+				continue;
+			}
+
+			const double RenderTime = ServerNow - Clock.GetDelay();
+			FVector Rendered, RenderedVelocity;
+			float RenderedYaw;
+			const ESnapshotSampleResult SampleResult = Buffer.Sample(RenderTime, Rendered, RenderedVelocity, RenderedYaw);
+			if (SampleResult == ESnapshotSampleResult::None)
+			{
+				continue;
+			}
+
+			FVector Truth, TruthVelocity;
+			EvaluateTrajectory(RenderTime, Truth, TruthVelocity);
+			Errors.Add(FVector::Dist(Rendered, Truth));
+
+			++Result.NumFrames;
+			Result.NumExtrapolated += SampleResult == ESnapshotSampleResult::Extrapolated ? 1 : 0;
+			Result.NumHeld += SampleResult == ESnapshotSampleResult::Held ? 1 : 0;
+		}
+
+		if (Errors.Num() > 0)
+		{
+			Errors.Sort();
+			double Sum = 0.0;
+			for (double Error : Errors)
+			{
+				Sum += Error;
+			}
+			Result.MeanError = Sum / Errors.Num();
+			Result.P95Error = Errors[FMath::Min(FMath::FloorToInt(Errors.Num() * 0.95), Errors.Num() - 1)];
+			Result.MaxError = Errors.Last();
+		}
+		Result.FinalDelay = Clock.GetDelay();
+		return Result;
+	}
+}
+
+/** 控制台命令：快照插值位置误差测试，在不同发送频率下比较客户端渲染位置和服务器轨迹 */
+static FAutoConsoleCommand GSnapshotErrorTestCommand(
+	TEXT("fpd.SnapshotErrorTest"),
+	TEXT("敌人快照插值误差测试：在30/15/10Hz发送（40ms延迟、30ms抖动、5%丢包）下测量渲染位置与服务器轨迹的误差"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		// 平均误差和最大误差的上限（单位）
+		constexpr double MaxMeanError = 5.0;
+		constexpr double MaxPeakError = 30.0;
+		const float UpdateRates[] = { 30.0f, 15.0f, 10.0f };
+
+		int32 NumFailed = 0;
+		for (float UpdateRate : UpdateRates)
+		{
+			const EnemySnapshotTest::FResult Result = EnemySnapshotTest::Simulate(UpdateRate, 29);
+			const bool bPassed = Result.NumFrames > 0 && Result.MeanError < MaxMeanError && Result.MaxError < MaxPeakError;
+			NumFailed += bPassed ? 0 : 1;
+
+			UE_LOG(LogEnemySnapshot, Display, TEXT("%s %2.0f Hz: %d snapshots, error mean %.2f / p95 %.2f / max %.2f, delay %.0f ms, %d/%d frames extrapolated, %d held"),
+				bPassed ? TEXT("PASS") : TEXT("FAIL"), UpdateRate, Result.NumSnapshots, Result.MeanError, Result.P95Error, Result.MaxError,
+				Result.FinalDelay * 1000.0f, Result.NumExtrapolated, Result.NumFrames, Result.NumHeld);
+		}
+
+		UE_LOG(LogEnemySnapshot, Display, TEXT("Snapshot error test: %s"), NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+	}));
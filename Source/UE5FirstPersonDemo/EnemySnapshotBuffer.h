@@ -0,0 +1,107 @@
+// EnemySnapshotBuffer.h - 客户端敌人快照缓冲：按服务器时间戳插值，丢包时短暂航位推算
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 单个移动快照
+ */
+struct FEnemyMovementSnapshot
+{
+	/** 服务器生成该状态的时间（随移动一起复制） */
+	double ServerTime = 0.0;
+
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float Yaw = 0.0f;
+};
+
+/**
+ * 采样结果类型
+ */
+enum class ESnapshotSampleResult : uint8
+{
+	/** 缓冲为空 */
+	None,
+	/** 在两个快照之间插值 */
+	Interpolated,
+	/** 超出最新快照，按速度外推 */
+	Extrapolated,
+	/** 外推超时，停在外推终点 */
+	Held
+};
+
+/**
+ * 敌人渲染时钟 - 客户端所有敌人共用一个插值延迟
+ *
+ * 渲染时间 = 估计的服务器时间 - 延迟。延迟覆盖快照的平均延迟（估计的服务器时间减去快照时间戳）、
+ * 两倍延迟抖动和一个发送间隔。所有敌人在同一服务器时间渲染，射击时把这个时间发给服务器回溯。
+ */
+class FEnemyRenderClock
+{
+public:
+	/** 插值延迟范围（秒） */
+	static constexpr float MinDelay = 0.05f;
+	static constexpr float MaxDelay = 0.35f;
+
+	/** 记录一个移动中敌人的快照：Latency 为到达时的延迟，Interval 为与上一快照的间隔（<= 0 表示不计入） */
+	void AddSample(float Latency, float Interval);
+
+	/** 当前插值延迟 */
+	float GetDelay() const { return Delay; }
+
+	/** 移动中敌人的平均快照间隔 */
+	float GetMeanInterval() const { return MeanInterval; }
+
+	/** 清空统计 */
+	void Reset() { *this = FEnemyRenderClock(); }
+
+private:
+	/** 延迟和间隔的指数平均，以及延迟的平均偏差 */
+	float MeanLatency = 0.0f;
+	float LatencyJitter = 0.0f;
+	float MeanInterval = 0.1f;
+	bool bHasLatency = false;
+
+	/** 当前插值延迟 */
+	float Delay = 0.1f;
+};
+
+/**
+ * 敌人快照缓冲 - 固定长度环形缓冲区
+ *
+ * 快照以复制的服务器时间戳为键，网络抖动不会变成位置误差。服务器只在量化移动变化时复制，
+ * 静止的敌人不产生快照；静止后重新移动时，先在新快照之前一个发送间隔补一个停留快照，
+ * 避免在很长的静止区间上缓慢插值。
+ */
+class FEnemySnapshotBuffer
+{
+public:
+	/** 缓冲快照数 */
+	static constexpr int32 Capacity = 16;
+
+	/** 最长外推时间（秒） */
+	static constexpr float MaxExtrapolation = 0.25f;
+
+	/** 添加新收到的快照，返回与上一快照的间隔（上一快照静止、断流或首个快照时返回0） */
+	float AddSnapshot(double ServerTime, const FVector& Location, const FVector& Velocity, float Yaw, float HoldInterval);
+
+	/** 在指定服务器时间采样 */
+	ESnapshotSampleResult Sample(double RenderTime, FVector& OutLocation, FVector& OutVelocity, float& OutYaw) const;
+
+	/** 清空（例如重新出现或传送时） */
+	void Reset();
+
+private:
+	const FEnemyMovementSnapshot& Get(int32 AgeIndex) const
+	{
+		return Snapshots[(Head - 1 - AgeIndex + Capacity) % Capacity];
+	}
+
+	void Push(const FEnemyMovementSnapshot& Snapshot);
+
+	TStaticArray<FEnemyMovementSnapshot, Capacity> Snapshots;
+	int32 Head = 0;
+	int32 Count = 0;
+};
@@ -0,0 +1,169 @@
+// FireCommandStream.cpp - 射击命令流实现
+
+#include "FireCommandStream.h"
+#include "NetBandwidthStats.h"
+
+namespace FireCommandStream
+{
+	const FName NAME_FireCommandBatch(TEXT("FireCommandBatch"));
+	const FName NAME_FirstPersonDemoCharacter(TEXT("FirstPersonDemoCharacter"));
+
+	/** 方向压缩为16位俯仰 + 16位偏航 */
+	void SerializeDirection(FVector& Direction, FArchive& Ar)
+	{
+		uint16 PackedPitch = 0;
+		uint16 PackedYaw = 0;
+
+		if (Ar.IsSaving())
+		{
+			const FRotator Rotation = Direction.Rotation();
+			PackedPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+			PackedYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+		}
+
+		Ar << PackedPitch;
+		Ar << PackedYaw;
+
+		if (Ar.IsLoading())
+		{
+			Direction = FRotator(FRotator::DecompressAxisFromShort(PackedPitch),
+				FRotator::DecompressAxisFromShort(PackedYaw), 0.0f).Vector();
+		}
+	}
+}
+
+bool FFireCommandBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	NetBandwidth::FSerializeScope BandwidthScope(Ar, Map, FireCommandStream::NAME_FireCommandBatch, FireCommandStream::NAME_FirstPersonDemoCharacter);
+
+	bOutSuccess = true;
+
+	uint32 Epoch = MatchEpoch;
+	Ar.SerializeInt(Epoch, NumMatchEpochs);
+	MatchEpoch = static_cast<uint8>(Epoch);
+
+	uint32 NumCommands = Commands.Num();
+	Ar.SerializeInt(NumCommands, MaxCommands + 1);
+
+	if (Ar.IsLoading())
+	{
+		if (NumCommands > MaxCommands)
+		{
+			bOutSuccess = false;
+			return false;
+		}
+		Commands.SetNum(NumCommands);
+	}
+
+	if (Commands.Num() == 0)
+	{
+		return true;
+	}
+
+	// 首条命令完整序列化
+	FFireCommand& First = Commands[0];
+	Ar << First.Sequence;
+	Ar << First.ClientFireTime;
+	bOutSuccess &= SerializePackedVector<10, 24>(First.Origin, Ar);
+	FireCommandStream::SerializeDirection(First.Direction, Ar);
+
+	for (int32 Index = 1; Index < Commands.Num(); ++Index)
+	{
+		FFireCommand& Command = Commands[Index];
+
+		// 序列号连续，无需传输
+		Command.Sequence = First.Sequence + Index;
+
+		// 时间差（毫秒）
+		uint16 DeltaMs = 0;
+		if (Ar.IsSaving())
+		{
+			DeltaMs = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt((Command.ClientFireTime - First.ClientFireTime) * 1000.0f), 0, MAX_uint16));
+		}
+		Ar << DeltaMs;
+
+		// 位置相对首条命令，短距离自动使用更少的位数
+		FVector DeltaOrigin = Ar.IsSaving() ? (Command.Origin - First.Origin) : FVector::ZeroVector;
+		bOutSuccess &= SerializePackedVector<10, 24>(DeltaOrigin, Ar);
+		FireCommandStream::SerializeDirection(Command.Direction, Ar);
+
+		if (Ar.IsLoading())
+		{
+			Command.ClientFireTime = First.ClientFireTime + DeltaMs / 1000.0f;
+			Command.Origin = First.Origin + DeltaOrigin;
+		}
+	}
+
+	return true;
+}
+
+void FFireCommandStream::Add(const FVector& Origin, const FVector& Direction, float ClientFireTime)
+{
+	// 窗口已满时丢弃最旧的命令，保持序列号连续
+	if (Pending.Num() == FFireCommandBatch::MaxCommands)
+	{
+		Pending.RemoveAt(0, 1, false);
+	}
+
+	FFireCommand& Command = Pending.AddDefaulted_GetRef();
+	Command.Sequence = NextSequence++;
+	Command.ClientFireTime = ClientFireTime;
+	Command.Origin = Origin;
+	Command.Direction = Direction;
+
+	bHasNewCommands = true;
+}
+
+void FFireCommandStream::Acknowledge(uint16 AckedSequence)
+{
+	int32 NumAcked = 0;
+	while (NumAcked < Pending.Num() && !IsFireSequenceNewer(Pending[NumAcked].Sequence, AckedSequence))
+	{
+		++NumAcked;
+	}
+
+	if (NumAcked > 0)
+	{
+		Pending.RemoveAt(0, NumAcked, false);
+	}
+}
+
+bool FFireCommandStream::BuildBatch(float Now, float ClientTime, FFireCommandBatch& OutBatch)
+{
+	// 丢弃过旧的命令
+	int32 NumExpired = 0;
+	while (NumExpired < Pending.Num() && ClientTime - Pending[NumExpired].ClientFireTime > MaxCommandAge)
+	{
+		++NumExpired;
+	}
+
+	if (NumExpired > 0)
+	{
+		Pending.RemoveAt(0, NumExpired, false);
+	}
+
+	if (Pending.Num() == 0)
+	{
+		bHasNewCommands = false;
+		return false;
+	}
+
+	// 有新命令立即发送，否则按间隔重发未确认命令
+	if (!bHasNewCommands && Now - LastSendTime < ResendInterval)
+	{
+		return false;
+	}
+
+	OutBatch.Commands.Reset();
+	OutBatch.Commands.Append(Pending.GetData(), Pending.Num());
+
+	bHasNewCommands = false;
+	LastSendTime = Now;
+	return true;
+}
+
+void FFireCommandStream::Reset()
+{
+	Pending.Reset();
+	bHasNewCommands = false;
+}
@@ -0,0 +1,105 @@
+// FireCommandStream.h - 不可靠、带序列号的射击命令流（客户端冗余发送，服务器按序列号去重）
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "FireCommandStream.generated.h"
+
+/**
+ * 单次射击命令
+ */
+USTRUCT()
+struct FFireCommand
+{
+	GENERATED_BODY()
+
+	/** 射击序列号（客户端递增） */
+	uint16 Sequence = 0;
+
+	/** 服务器时间：命中扫描为客户端渲染敌人的时间（回溯目标），射弹为射弹开始模拟的时间 */
+	float ClientFireTime = 0.0f;
+
+	/** 射击起点 */
+	FVector Origin = FVector::ZeroVector;
+
+	/** 射击方向（单位向量，序列化为16位俯仰/偏航） */
+	FVector Direction = FVector::ForwardVector;
+};
+
+/**
+ * 射击命令包 - 每个包冗余携带最近的未确认命令
+ *
+ * 序列号连续，只传首条序列号；后续命令的时间和位置相对首条命令做差分编码。
+ */
+USTRUCT()
+struct FFireCommandBatch
+{
+	GENERATED_BODY()
+
+	/** 每包最多携带的命令数 */
+	static constexpr int32 MaxCommands = 4;
+
+	/** 比赛轮次的取值个数（回绕；途中的旧命令最多落后一两轮） */
+	static constexpr uint8 NumMatchEpochs = 4;
+
+	/** 发出命令时客户端所在的比赛轮次，服务器丢弃与当前轮次不符的包 */
+	uint8 MatchEpoch = 0;
+
+	TArray<FFireCommand, TFixedAllocator<MaxCommands>> Commands;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FFireCommandBatch> : public TStructOpsTypeTraitsBase2<FFireCommandBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/** 序列号A是否比B新（处理回绕） */
+FORCEINLINE bool IsFireSequenceNewer(uint16 A, uint16 B)
+{
+	return static_cast<int16>(A - B) > 0;
+}
+
+/**
+ * 客户端射击命令窗口 - 保存未被服务器确认的命令并决定何时发送
+ */
+class FFireCommandStream
+{
+public:
+	/** 未确认命令的重发间隔（秒） */
+	static constexpr float ResendInterval = 0.05f;
+
+	/** 命令最长保留时间（秒），超过后服务器也无法回溯 */
+	static constexpr float MaxCommandAge = 0.5f;
+
+	/** 添加一条新命令 */
+	void Add(const FVector& Origin, const FVector& Direction, float ClientFireTime);
+
+	/** 服务器确认到某序列号 */
+	void Acknowledge(uint16 AckedSequence);
+
+	/** 若需要发送则填充命令包 */
+	bool BuildBatch(float Now, float ClientTime, FFireCommandBatch& OutBatch);
+
+	/** 清空（死亡或重生时） */
+	void Reset();
+
+private:
+	/** 未确认命令（序列号连续递增） */
+	TArray<FFireCommand, TInlineAllocator<FFireCommandBatch::MaxCommands>> Pending;
+
+	/** 下一条命令的序列号 */
+	uint16 NextSequence = 1;
+
+	/** 是否有未发送过的新命令 */
+	bool bHasNewCommands = false;
+
+	/** 上次发送时间 */
+	float LastSendTime = -1.0f;
+};
@@ -1,22 +1,39 @@
 // FirstPersonDemoCharacter.cpp - 第一人称角色实现
 
 #include "FirstPersonDemoCharacter.h"
+#include "UE5FirstPersonDemo.h"
 #include "FirstPersonDemoGameMode.h"
+#include "LagCompensationSubsystem.h"
+#include "CosmeticEventSubsystem.h"
+#include "NetThreatPriority.h"
+#include "FirstPersonDemoPlayerController.h"
+#include "NetBandwidthStats.h"
+#include "CombatAssetSubsystem.h"
+#include "VfxPoolSubsystem.h"
+#include "HitscanBatchSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "HitboxProxyComponent.h"
+#include "DamageQueueSubsystem.h"
+#include "FirstPersonDemoGameState.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "EnhancedInputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "Net/UnrealNetwork.h"
-#include "Particles/ParticleSystemComponent.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
+DECLARE_CYCLE_STAT(TEXT("Server Resolve Shot"), STAT_ServerResolveShot, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server Shots Resolved"), STAT_ServerShotsResolved, STATGROUP_FirstPersonDemo);
+
 //////////////////////////////////////////////////////////////////////////
 // AFirstPersonDemoCharacter
 
@@ -51,6 +68,12 @@ AFirstPersonDemoCharacter::AFirstPersonDemoCharacter()
 	ThirdPersonMesh->SetRelativeLocation(FVector(0.f, 0.f, -96.f));
 	ThirdPersonMesh->SetRelativeRotation(FRotator(0.f, -90.f, 0.f));
 
+	// 武器射线只检测环境，角色由命中盒代理判定
+	HitboxProxy = CreateDefaultSubobject<UHitboxProxyComponent>(TEXT("HitboxProxy"));
+	GetCapsuleComponent()->SetCollisionResponseToChannel(TraceChannel_Weapon, ECR_Ignore);
+	FirstPersonMesh->SetCollisionResponseToChannel(TraceChannel_Weapon, ECR_Ignore);
+	ThirdPersonMesh->SetCollisionResponseToChannel(TraceChannel_Weapon, ECR_Ignore);
+
 	// 初始化属性
 	MaxHealth = 100.0f;
 	Health = MaxHealth;
@@ -60,8 +83,14 @@ AFirstPersonDemoCharacter::AFirstPersonDemoCharacter()
 	bIsDead = false;
 
 	FireRate = 0.15f; // 每秒约6.7发
+	ProjectileSpeed = 0.0f;
 	bIsFiring = false;
 	LastFireTime = 0.0f;
+	LastServerShotTime = -1.0f;
+	FireMatchEpoch = 0;
+	LastMovementSnapshotTime = 0.0;
+	LastProcessedFireSequence = 0;
+	RespawnServerTime = 0.0f;
 
 	// 移动设置
 	GetCharacterMovement()->GetNavAgentPropertiesRef().bCanCrouch = true;
@@ -83,27 +112,118 @@ void AFirstPersonDemoCharacter::GetLifetimeReplicatedProps(TArray<FLifetimePrope
 	DOREPLIFETIME(AFirstPersonDemoCharacter, KillCount);
 	DOREPLIFETIME(AFirstPersonDemoCharacter, bIsDead);
 	DOREPLIFETIME_CONDITION(AFirstPersonDemoCharacter, bIsFiring, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(AFirstPersonDemoCharacter, LastProcessedFireSequence, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AFirstPersonDemoCharacter, RespawnServerTime, COND_OwnerOnly);
 }
 
 void AFirstPersonDemoCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 	InitializeHealth();
+
+	// 其他玩家和敌人一样由快照插值驱动：命中扫描射击只附带一个渲染时间，所有远端角色必须在同一时钟上渲染
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		GetCharacterMovement()->NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+		GetCharacterMovement()->SetComponentTickEnabled(false);
+	}
+
+	// 专用服务器不渲染，命中判定只用命中盒代理历史，网格不需要每帧更新姿势和骨骼
+	if (!ShouldPlayCosmetics(GetWorld()))
+	{
+		FirstPersonMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		ThirdPersonMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
 }
 
 void AFirstPersonDemoCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// 持续射击逻辑
+	if (GetLocalRole() == ROLE_SimulatedProxy && !bIsDead)
+	{
+		UpdateSimulatedMovement();
+	}
+
+	// 持续射击：调度器按精确间隔给出本帧内的射击时间，低帧率时一帧可能有多发
 	if (bIsFiring && !bIsDead)
 	{
-		float CurrentTime = GetWorld()->GetTimeSeconds();
-		if (CurrentTime - LastFireTime >= FireRate)
+		FireScheduler.SetFireInterval(FireRate);
+
+		FWeaponFireScheduler::FShotTimes ShotTimes;
+		FireScheduler.Advance(GetWorld()->GetTimeSeconds(), ShotTimes);
+		for (double ShotTime : ShotTimes)
 		{
-			FireWeapon();
+			FireWeapon(ShotTime);
 		}
 	}
+
+	// 客户端每帧最多发送一个射击命令包（本帧的多发射击在同一个包中）
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		FlushFireCommands();
+	}
+}
+
+float AFirstPersonDemoCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+	UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	// 观察者自己的角色始终最高
+	if (this == ViewTarget || GetController() == Viewer)
+	{
+		return NetPriority * Time * 4.0f;
+	}
+
+	// 最近开过火的玩家威胁更高
+	float StateWeight = bIsDead ? 0.5f : 1.0f;
+	if (!bIsDead && LastServerShotTime >= 0.0f && GetWorld()->GetTimeSeconds() - LastServerShotTime < 1.0f)
+	{
+		StateWeight = 2.0f;
+	}
+
+	const float Threat = NetThreatPriority::ComputeThreat(StateWeight, false, GetActorLocation(), ViewPos, ViewDir, bLowBandwidth);
+
+	return NetThreatPriority::ComputePriority(NetPriority, Threat, Time);
+}
+
+void AFirstPersonDemoCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	static const FName NAME_Health(TEXT("Health"));
+	static const FName NAME_Score(TEXT("Score"));
+	static const FName NAME_KillCount(TEXT("KillCount"));
+	static const FName NAME_IsDead(TEXT("bIsDead"));
+	static const FName NAME_IsFiring(TEXT("bIsFiring"));
+	static const FName NAME_LastProcessedFireSequence(TEXT("LastProcessedFireSequence"));
+	static const FName NAME_RespawnServerTime(TEXT("RespawnServerTime"));
+
+	// 只复制给拥有者的属性有一个接收者，跳过拥有者的属性少一个
+	const int32 NumOwnerReceivers = GetNetConnection() ? 1 : 0;
+	const int32 NumOtherReceivers = NetBandwidth::GetNumClientConnections(this) - NumOwnerReceivers;
+
+	AccountedProperties.Track(this, NAME_Health, Health);
+	AccountedProperties.Track(this, NAME_Score, Score);
+	AccountedProperties.Track(this, NAME_KillCount, KillCount);
+	AccountedProperties.Track(this, NAME_IsDead, static_cast<uint8>(bIsDead), 1);
+	AccountedProperties.Track(this, NAME_IsFiring, static_cast<uint8>(bIsFiring), 1, NumOtherReceivers);
+	AccountedProperties.Track(this, NAME_LastProcessedFireSequence, LastProcessedFireSequence, sizeof(LastProcessedFireSequence) * 8, NumOwnerReceivers);
+	AccountedProperties.Track(this, NAME_RespawnServerTime, RespawnServerTime, sizeof(RespawnServerTime) * 8, NumOwnerReceivers);
+}
+
+void AFirstPersonDemoCharacter::ApplyScriptedInput(const FVector2D& MoveVector, const FVector2D& LookVector, bool bWantsFire)
+{
+	Move(FInputActionValue(MoveVector));
+	Look(FInputActionValue(LookVector));
+
+	if (bWantsFire && !bIsFiring)
+	{
+		OnStartFire();
+	}
+	else if (!bWantsFire && bIsFiring)
+	{
+		OnStopFire();
+	}
 }
 
 void AFirstPersonDemoCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -151,13 +271,27 @@ void AFirstPersonDemoCharacter::OnStartFire()
 	if (!bIsDead)
 	{
 		bIsFiring = true;
-		FireWeapon();
+
+		// 冷却已结束时在按下的时刻立即开火，否则由Tick在冷却结束时开火
+		const double Now = GetWorld()->GetTimeSeconds();
+		FireScheduler.SetFireInterval(FireRate);
+		if (FireScheduler.StartFiring(Now))
+		{
+			FireWeapon(Now);
+		}
 	}
 }
 
 void AFirstPersonDemoCharacter::OnStopFire()
 {
 	bIsFiring = false;
+	FireScheduler.StopFiring();
+}
+
+void AFirstPersonDemoCharacter::ResetFiring()
+{
+	bIsFiring = false;
+	FireScheduler.Reset();
 }
 
 void AFirstPersonDemoCharacter::Move(const FInputActionValue& Value)
@@ -208,106 +342,184 @@ void AFirstPersonDemoCharacter::Look(const FInputActionValue& Value)
 	}
 }
 
-void AFirstPersonDemoCharacter::FireWeapon()
+void AFirstPersonDemoCharacter::FireWeapon(double ShotTime)
 {
 	if (bIsDead)
 	{
 		return;
 	}
 
-	LastFireTime = GetWorld()->GetTimeSeconds();
+	LastFireTime = ShotTime;
 
-	// 播放射击音效
-	if (FireSound)
-	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
-	}
+	// 本地立即播放射击效果
+	PlayFireEffects();
 
-	// 播放枪口火焰
-	if (MuzzleFlash)
+	if (HasAuthority())
 	{
-		UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, FirstPersonMesh, FName("Muzzle"));
-	}
+		SCOPE_CYCLE_COUNTER(STAT_ServerResolveShot);
+		INC_DWORD_STAT(STAT_ServerShotsResolved);
 
-	// 射线检测
-	FVector HitLocation;
-	AActor* HitActor;
-	if (WeaponTrace(HitLocation, HitActor))
-	{
-		// 造成伤害
-		if (HasAuthority())
+		LastServerShotTime = LastFireTime;
+
+		// 通知其他玩家
+		if (UCosmeticEventSubsystem* CosmeticEvents = GetWorld()->GetSubsystem<UCosmeticEventSubsystem>())
+		{
+			CosmeticEvents->AddEvent(ECosmeticEventType::Muzzle, GetActorLocation(), this);
+		}
+
+		if (ProjectileSpeed > 0.0f)
 		{
-			ApplyPointDamage(HitActor, WeaponDamage, HitLocation);
+			if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+			{
+				Projectiles->FireProjectile(this, FirstPersonCameraComponent->GetComponentLocation(),
+					GetBaseAimRotation().Vector() * ProjectileSpeed, LastFireTime, WeaponDamage);
+			}
 		}
-		else
+		// 加入本帧的射击批次，由批处理子系统统一检测并结算伤害（不需要回溯）
+		else if (UHitscanBatchSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanBatchSubsystem>())
+		{
+			Hitscan->QueueShot(this, FirstPersonCameraComponent->GetComponentLocation(),
+				GetBaseAimRotation().Vector(), LastFireTime, WeaponDamage);
+		}
+	}
+	else
+	{
+		// 加入命令流，由Tick统一发送（时间均含子帧偏移）：
+		// 命中扫描附带远端角色当前渲染的服务器时间（敌人和其他玩家共用渲染时钟），服务器回溯到玩家看到的画面；
+		// 射弹附带估计的服务器时间，与本地预测射弹的起始时间一致
+		const AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>();
+		const float SubFrameOffset = GetWorld()->GetTimeSeconds() - ShotTime;
+		const float ServerTimeEstimate = DemoGameState ? DemoGameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+		const float RenderTime = DemoGameState ? static_cast<float>(DemoGameState->GetEnemyRenderServerTime()) : ServerTimeEstimate;
+		const float ClientFireTime = ((ProjectileSpeed > 0.0f) ? ServerTimeEstimate : RenderTime) - SubFrameOffset;
+
+		FireCommandStream.Add(FirstPersonCameraComponent->GetComponentLocation(),
+			FirstPersonCameraComponent->GetForwardVector(), ClientFireTime);
+
+		// 射弹武器在本地预测生成射弹，服务器不再把这发射弹发回给自己
+		if (ProjectileSpeed > 0.0f)
 		{
-			ServerFireWeapon(FirstPersonCameraComponent->GetComponentLocation(),
-				FirstPersonCameraComponent->GetForwardVector());
+			if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+			{
+				Projectiles->FireProjectile(this, FirstPersonCameraComponent->GetComponentLocation(),
+					FirstPersonCameraComponent->GetForwardVector() * ProjectileSpeed, ClientFireTime, 0.0f);
+			}
 		}
 	}
 }
 
-void AFirstPersonDemoCharacter::ServerFireWeapon_Implementation(FVector_NetQuantize10 Origin, FVector_NetQuantize10 Direction)
+void AFirstPersonDemoCharacter::FlushFireCommands()
 {
-	if (bIsDead)
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float ClientTime = GameState ? GameState->GetServerWorldTimeSeconds() : Now;
+
+	FFireCommandBatch Batch;
+	if (FireCommandStream.BuildBatch(Now, ClientTime, Batch))
 	{
-		return;
+		Batch.MatchEpoch = FireMatchEpoch;
+
+		static const FName NAME_ServerFireWeapon(TEXT("ServerFireWeapon"));
+
+		NetBandwidth::FRpcScope RpcScope(this, NAME_ServerFireWeapon);
+		ServerFireWeapon(Batch);
 	}
+}
 
-	// 播放射击音效
-	if (FireSound)
+void AFirstPersonDemoCharacter::OnRep_LastProcessedFireSequence()
+{
+	FireCommandStream.Acknowledge(LastProcessedFireSequence);
+}
+
+void AFirstPersonDemoCharacter::ServerFireWeapon_Implementation(const FFireCommandBatch& Batch)
+{
+	ProcessFireBatch(Batch);
+}
+
+int32 AFirstPersonDemoCharacter::ProcessFireBatch(const FFireCommandBatch& Batch)
+{
+	// 重置前发出、重置后才到达的射击不带入新比赛（也不占用新比赛的限流额度）
+	if (Batch.MatchEpoch != FireMatchEpoch)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+		return 0;
 	}
 
-	// 播放枪口火焰
-	if (MuzzleFlash)
+	// 按角色限流，与控制器类型无关；只确认通过限流的命令
+	FireRateLimiter.ConfigureFireRate(FireRate);
+	return FireRateLimiter.ProcessFireBatch(Batch, GetWorld()->GetTimeSeconds(), LastProcessedFireSequence, [this](const FFireCommand& Command)
 	{
-		UGameplayStatics::SpawnEmitterAttached(MuzzleFlash, FirstPersonMesh, FName("Muzzle"));
+		ServerResolveShot(Command.Origin, Command.Direction.GetSafeNormal(), Command.ClientFireTime);
+	});
+}
+
+bool AFirstPersonDemoCharacter::ServerFireWeapon_Validate(const FFireCommandBatch& Batch)
+{
+	return Batch.Commands.Num() <= FFireCommandBatch::MaxCommands;
+}
+
+void AFirstPersonDemoCharacter::ServerResolveShot(const FVector& Origin, const FVector& Direction, float ClientFireTime)
+{
+	if (bIsDead)
+	{
+		return;
 	}
 
-	// 射线检测
-	FVector Start = Origin;
-	FVector End = Origin + (Direction * 10000.f);
+	SCOPE_CYCLE_COUNTER(STAT_ServerResolveShot);
+	INC_DWORD_STAT(STAT_ServerShotsResolved);
 
-	FHitResult HitResult;
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
+	LastServerShotTime = GetWorld()->GetTimeSeconds();
+
+	// 射击效果通过装饰性事件通道发给其他玩家
+	if (UCosmeticEventSubsystem* CosmeticEvents = GetWorld()->GetSubsystem<UCosmeticEventSubsystem>())
+	{
+		CosmeticEvents->AddEvent(ECosmeticEventType::Muzzle, GetActorLocation(), this);
+	}
 
-	if (GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECC_Pawn, Params))
+	// 场景遮挡和回溯检测在本帧末统一批量进行，回溯到客户端开火时刻
+	ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	if (!LagCompensation)
 	{
-		if (AActor* HitActor = HitResult.GetActor())
+		return;
+	}
+
+	// 射弹从客户端开火时刻开始模拟，第一帧追上当前位置
+	if (ProjectileSpeed > 0.0f)
+	{
+		if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
 		{
-			ApplyPointDamage(HitActor, WeaponDamage, HitResult.Location);
+			Projectiles->FireProjectile(this, Origin, Direction * ProjectileSpeed, LagCompensation->ClampRewindTime(ClientFireTime), WeaponDamage);
 		}
 	}
-}
-
-bool AFirstPersonDemoCharacter::ServerFireWeapon_Validate(FVector_NetQuantize10 Origin, FVector_NetQuantize10 Direction)
-{
-	return true;
+	else if (UHitscanBatchSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanBatchSubsystem>())
+	{
+		Hitscan->QueueShot(this, Origin, Direction, LagCompensation->ClampRewindTime(ClientFireTime), WeaponDamage);
+	}
 }
 
 bool AFirstPersonDemoCharacter::WeaponTrace(FVector& OutHitLocation, AActor*& OutHitActor)
 {
+	// 瞄准方向取控制器旋转：AI控制的角色没有视图，相机组件不会跟随俯仰
 	FVector Start = FirstPersonCameraComponent->GetComponentLocation();
-	FVector End = Start + (FirstPersonCameraComponent->GetForwardVector() * 10000.f);
+	FVector End = Start + (GetBaseAimRotation().Vector() * 10000.f);
 
 	FHitResult HitResult;
 	FCollisionQueryParams Params;
 	Params.AddIgnoredActor(this);
 
-	bool bHit = GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECC_Pawn, Params);
+	// 武器通道只被环境阻挡，角色检测当前时刻的命中盒代理
+	bool bHit = GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, TraceChannel_Weapon, Params);
+	OutHitLocation = bHit ? HitResult.Location : End;
+	OutHitActor = bHit ? HitResult.GetActor() : nullptr;
 
-	if (bHit)
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
 	{
-		OutHitLocation = HitResult.Location;
-		OutHitActor = HitResult.GetActor();
-	}
-	else
-	{
-		OutHitLocation = End;
-		OutHitActor = nullptr;
+		FLagCompensatedHit ProxyHit;
+		if (LagCompensation->TraceRewound(Start, bHit ? HitResult.Location : End, GetWorld()->GetTimeSeconds(), this, ProxyHit))
+		{
+			bHit = true;
+			OutHitLocation = ProxyHit.Location;
+			OutHitActor = ProxyHit.Actor;
+		}
 	}
 
 	// 调试绘制射线
@@ -323,14 +535,36 @@ void AFirstPersonDemoCharacter::ApplyPointDamage(AActor* HitActor, float Damage,
 		return;
 	}
 
-	UGameplayStatics::ApplyPointDamage(HitActor, Damage, GetActorForwardVector(),
-		FHitResult(), GetController(), this, UDamageType::StaticClass());
+	// 伤害提交到队列，帧末按受害者合并后结算一次
+	if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+	{
+		DamageQueue->SubmitDamage(HitActor, Damage, GetController(), this, HitLocation, GetActorForwardVector());
+	}
 
-	// 播放击中特效
-	if (UParticleSystem* HitEffect = Cast<UParticleSystem>(StaticLoadObject(UParticleSystem::StaticClass(),
-		nullptr, TEXT("/Game/FirstPerson/Particles/P_HitEffect"))))
+	// 击中特效通过装饰性事件通道发给附近玩家
+	if (UCosmeticEventSubsystem* CosmeticEvents = GetWorld()->GetSubsystem<UCosmeticEventSubsystem>())
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), HitEffect, HitLocation);
+		CosmeticEvents->AddEvent(ECosmeticEventType::Impact, HitLocation);
+	}
+}
+
+void AFirstPersonDemoCharacter::PlayFireEffects()
+{
+	if (!ShouldPlayCosmetics(GetWorld()))
+	{
+		return;
+	}
+
+	// 播放射击音效
+	if (FireSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+	}
+
+	// 播放枪口火焰（本地玩家挂在第一人称网格上，其他人看第三人称网格）
+	if (UVfxPoolSubsystem* VfxPool = GetWorld()->GetSubsystem<UVfxPoolSubsystem>())
+	{
+		VfxPool->SpawnAttached(EPooledEffect::Muzzle, MuzzleFlash, IsLocallyControlled() ? FirstPersonMesh : ThirdPersonMesh, FName("Muzzle"));
 	}
 }
 
@@ -357,7 +591,7 @@ float AFirstPersonDemoCharacter::TakeDamage(float DamageAmount, FDamageEvent con
 			if (AFirstPersonDemoCharacter* Attacker = Cast<AFirstPersonDemoCharacter>(DamageCauser))
 			{
 				Attacker->AddScore(100);
-				Attacker->KillCount++;
+				Attacker->AddKill();
 			}
 		}
 
@@ -375,20 +609,31 @@ void AFirstPersonDemoCharacter::OnDeath()
 	}
 
 	bIsDead = true;
+	ResetFiring();
+
+	// 死亡多播会解除控制，记住控制器以便重生
+	PreviousController = GetController();
 
 	// 禁用移动和碰撞
 	GetCharacterMovement()->DisableMovement();
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
 	// 播放死亡动画
-	if (UAnimMontage* DeathAnim = Cast<UAnimMontage>(StaticLoadObject(UAnimMontage::StaticClass(),
-		nullptr, TEXT("/Game/FirstPerson/Animations/DeathAnim"))))
+	if (ShouldPlayCosmetics(GetWorld()))
 	{
-		PlayAnimMontage(DeathAnim);
+		if (UAnimMontage* DeathAnim = UCombatAssetSubsystem::Get<UAnimMontage>(GetWorld(), ECombatAsset::PlayerDeathMontage))
+		{
+			PlayAnimMontage(DeathAnim);
+		}
 	}
 
 	// 多播死亡
-	MulticastOnDeath();
+	{
+		static const FName NAME_MulticastOnDeath(TEXT("MulticastOnDeath"));
+
+		NetBandwidth::FRpcScope RpcScope(this, NAME_MulticastOnDeath, NetBandwidth::GetNumClientConnections(this));
+		MulticastOnDeath();
+	}
 
 	// 通知游戏模式
 	if (AFirstPersonDemoGameMode* GM = Cast<AFirstPersonDemoGameMode>(GetWorld()->GetAuthGameMode()))
@@ -402,10 +647,16 @@ void AFirstPersonDemoCharacter::OnDeath()
 
 void AFirstPersonDemoCharacter::MulticastOnDeath_Implementation()
 {
+	// 拥有者客户端的射击调度在本地，同样停止
+	ResetFiring();
+
 	// 本地玩家死亡效果
-	FirstPersonMesh->SetHiddenInGame(true);
-	ThirdPersonMesh->SetHiddenInGame(false);
-	ThirdPersonMesh->SetSimulatePhysics(true);
+	if (ShouldPlayCosmetics(GetWorld()))
+	{
+		FirstPersonMesh->SetHiddenInGame(true);
+		ThirdPersonMesh->SetHiddenInGame(false);
+		ThirdPersonMesh->SetSimulatePhysics(true);
+	}
 
 	if (AController* PC = GetController())
 	{
@@ -413,6 +664,13 @@ void AFirstPersonDemoCharacter::MulticastOnDeath_Implementation()
 	}
 }
 
+void AFirstPersonDemoCharacter::ClientResetFiring_Implementation(uint8 NewMatchEpoch)
+{
+	ResetFiring();
+	FireCommandStream.Reset();
+	FireMatchEpoch = NewMatchEpoch;
+}
+
 void AFirstPersonDemoCharacter::OnRep_Health()
 {
 	OnHealthChangedDelegate.Broadcast(Health);
@@ -420,6 +678,12 @@ void AFirstPersonDemoCharacter::OnRep_Health()
 
 void AFirstPersonDemoCharacter::OnRep_IsDead()
 {
+	// 死亡和重生都清空本地射击调度（死亡多播可能先于或晚于属性到达）
+	ResetFiring();
+
+	// 重生是传送，不在死亡位置和出生点之间插值
+	MovementSnapshots.Reset();
+
 	if (bIsDead)
 	{
 		FirstPersonMesh->SetHiddenInGame(true);
@@ -428,6 +692,65 @@ void AFirstPersonDemoCharacter::OnRep_IsDead()
 	}
 }
 
+void AFirstPersonDemoCharacter::PostNetReceiveLocationAndRotation()
+{
+	// 死亡后胶囊体不再移动，沿用默认处理
+	if (GetLocalRole() != ROLE_SimulatedProxy || bIsDead)
+	{
+		Super::PostNetReceiveLocationAndRotation();
+		return;
+	}
+
+	AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>();
+	if (!DemoGameState)
+	{
+		Super::PostNetReceiveLocationAndRotation();
+		return;
+	}
+
+	const FRepMovement& RepMovement = GetReplicatedMovement();
+	const FVector Location = FRepMovement::RebaseOntoLocalOrigin(RepMovement.Location, this);
+
+	// 快照时间用服务器最后一次更新变换的时间戳；时间戳未前进（例如服务器控制的角色不更新它）时按到达时间记录
+	FEnemyRenderClock& RenderClock = DemoGameState->GetEnemyRenderClock();
+	const double ServerNow = DemoGameState->GetServerWorldTimeSeconds();
+	double SnapshotTime = GetReplicatedServerLastTransformUpdateTimeStamp();
+	if (SnapshotTime <= LastMovementSnapshotTime || SnapshotTime > ServerNow)
+	{
+		SnapshotTime = ServerNow;
+	}
+	LastMovementSnapshotTime = SnapshotTime;
+
+	const float Interval = MovementSnapshots.AddSnapshot(SnapshotTime, Location, RepMovement.LinearVelocity,
+		RepMovement.Rotation.Yaw, RenderClock.GetMeanInterval());
+	if (Interval > 0.0f)
+	{
+		RenderClock.AddSample(static_cast<float>(ServerNow - SnapshotTime), Interval);
+	}
+}
+
+void AFirstPersonDemoCharacter::UpdateSimulatedMovement()
+{
+	const AFirstPersonDemoGameState* DemoGameState = GetWorld()->GetGameState<AFirstPersonDemoGameState>();
+	if (!DemoGameState)
+	{
+		return;
+	}
+
+	FVector Location;
+	FVector Velocity;
+	float Yaw;
+	if (MovementSnapshots.Sample(DemoGameState->GetEnemyRenderServerTime(), Location, Velocity, Yaw) == ESnapshotSampleResult::None)
+	{
+		return;
+	}
+
+	SetActorLocationAndRotation(Location, FRotator(0.0f, Yaw, 0.0f));
+
+	// 动画蓝图读取移动组件的速度
+	GetCharacterMovement()->Velocity = Velocity;
+}
+
 float AFirstPersonDemoCharacter::GetHealthPercent() const
 {
 	return (MaxHealth > 0.0f) ? (Health / MaxHealth) : 0.0f;
@@ -437,7 +760,10 @@ void AFirstPersonDemoCharacter::DealDamage(AActor* DamagedActor, float Damage)
 {
 	if (HasAuthority())
 	{
-		UGameplayStatics::ApplyDamage(DamagedActor, Damage, GetController(), this, UDamageType::StaticClass());
+		if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+		{
+			DamageQueue->SubmitDamage(DamagedActor, Damage, GetController(), this, DamagedActor ? DamagedActor->GetActorLocation() : FVector::ZeroVector, GetActorForwardVector());
+		}
 	}
 }
 
@@ -446,6 +772,25 @@ void AFirstPersonDemoCharacter::AddScore(int32 Points)
 	if (HasAuthority())
 	{
 		Score += Points;
+
+		// 通知游戏模式评估胜利条件
+		if (AFirstPersonDemoGameMode* GM = Cast<AFirstPersonDemoGameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GM->NotifyPlayerStatsChanged(this);
+		}
+	}
+}
+
+void AFirstPersonDemoCharacter::AddKill()
+{
+	if (HasAuthority())
+	{
+		KillCount++;
+
+		if (AFirstPersonDemoGameMode* GM = Cast<AFirstPersonDemoGameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GM->NotifyPlayerStatsChanged(this);
+		}
 	}
 }
 
@@ -460,12 +805,18 @@ void AFirstPersonDemoCharacter::Respawn()
 	Health = MaxHealth;
 	OnHealthChangedDelegate.Broadcast(Health);
 
+	// 重生时不继承死亡前的扳机状态和冷却
+	ResetFiring();
+
 	// 重置角色状态
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
 	GetCharacterMovement()->MovementMode = MOVE_Falling;
-	FirstPersonMesh->SetHiddenInGame(false);
-	ThirdPersonMesh->SetHiddenInGame(true);
-	ThirdPersonMesh->SetSimulatePhysics(false);
+	if (ShouldPlayCosmetics(GetWorld()))
+	{
+		FirstPersonMesh->SetHiddenInGame(false);
+		ThirdPersonMesh->SetHiddenInGame(true);
+		ThirdPersonMesh->SetSimulatePhysics(false);
+	}
 
 	// 重生
 	if (AFirstPersonDemoGameMode* GM = Cast<AFirstPersonDemoGameMode>(GetWorld()->GetAuthGameMode()))
@@ -474,10 +825,46 @@ void AFirstPersonDemoCharacter::Respawn()
 		SetActorLocation(SpawnLocation);
 	}
 
-	if (AController* PC = GetController())
+	AController* RespawnController = GetController() ? GetController() : PreviousController.Get();
+	if (RespawnController && RespawnController->GetPawn() != this)
+	{
+		RespawnController->Possess(this);
+	}
+	PreviousController.Reset();
+}
+
+void AFirstPersonDemoCharacter::ResetForMatch()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	Score = 0;
+	KillCount = 0;
+	RespawnServerTime = 0.0f;
+	GetCharacterMovement()->StopMovementImmediately();
+
+	// 停止射击：服务器上的调度立即清空，拥有者客户端的本地调度和未确认命令通过RPC清空，
+	// 途中的旧命令带着上一轮的比赛轮次，到达后被丢弃（按回溯时间判断会误丢重置后的射击：渲染时间落后服务器最多0.35秒）
+	ResetFiring();
+	FireMatchEpoch = (FireMatchEpoch + 1) % FFireCommandBatch::NumMatchEpochs;
+	ClientResetFiring(FireMatchEpoch);
+
+	// 存活和死亡的玩家都走重生流程：恢复生命值、碰撞和网格，回到出生点，重新控制
+	Respawn();
+}
+
+float AFirstPersonDemoCharacter::GetRespawnCountdown() const
+{
+	if (!bIsDead)
 	{
-		PC->Possess(this);
+		return 0.0f;
 	}
+
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	return FMath::Max(RespawnServerTime - ServerTime, 0.0f);
 }
 
 void AFirstPersonDemoCharacter::InitializeHealth()
@@ -4,6 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "EnemySnapshotBuffer.h"
+#include "FireCommandStream.h"
+#include "NetBandwidthStats.h"
+#include "RpcRateLimiter.h"
+#include "WeaponFireScheduler.h"
 #include "FirstPersonDemoCharacter.generated.h"
 
 class UInputComponent;
@@ -12,6 +17,8 @@ class USceneComponent;
 class UCameraComponent;
 class UAnimMontage;
 class USoundBase;
+class UFXSystemAsset;
+class UHitboxProxyComponent;
 class UInputAction;
 class UInputMappingContext;
 struct FInputActionValue;
@@ -62,6 +69,19 @@ public:
 	/** 每帧更新 */
 	virtual void Tick(float DeltaTime) override;
 
+	/** 网络：按威胁度计算复制优先级 */
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+		UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
+	/** 网络：统计属性变化的带宽 */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** 网络：模拟代理把复制的移动存入快照缓冲，与敌人在同一渲染时钟上插值 */
+	virtual void PostNetReceiveLocationAndRotation() override;
+
+	/** 脚本输入（无头机器人客户端使用，等价于增强输入的移动、视角和射击） */
+	void ApplyScriptedInput(const FVector2D& MoveVector, const FVector2D& LookVector, bool bWantsFire);
+
 protected:
 	/** 触发跳跃 */
 	void OnStartJump();
@@ -71,6 +91,9 @@ protected:
 	void OnStartFire();
 	void OnStopFire();
 
+	/** 松开扳机并清空射击调度（死亡和重生时，避免重生后按死亡前的冷却补发射击） */
+	void ResetFiring();
+
 	/** 触发移动 */
 	void Move(const FInputActionValue& Value);
 
@@ -80,12 +103,18 @@ protected:
 	/** 重置跳跃动作 */
 	void ResetJump();
 
-	/** 射击处理 */
-	void FireWeapon();
+	/** 射击处理（ShotTime为调度器给出的子帧射击时间） */
+	void FireWeapon(double ShotTime);
 
-	/** 服务器射击 */
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerFireWeapon(FVector_NetQuantize10 Origin, FVector_NetQuantize10 Direction);
+	/** 服务器射击 - 不可靠命令流，每包冗余携带最近未确认的射击 */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerFireWeapon(const FFireCommandBatch& Batch);
+
+	/** 服务器判定单次射击（ClientFireTime为客户端看到目标时的服务器时间，用于延迟补偿） */
+	void ServerResolveShot(const FVector& Origin, const FVector& Direction, float ClientFireTime);
+
+	/** 客户端：发送待确认的射击命令 */
+	void FlushFireCommands();
 
 	/** 处理伤害 */
 	float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
@@ -98,6 +127,10 @@ protected:
 	UFUNCTION(NetMulticast, Reliable)
 	void MulticastOnDeath();
 
+	/** 网络：比赛软重置时停止拥有者客户端的本地射击（存活的玩家不会收到死亡状态复制），之后的射击带上新的比赛轮次 */
+	UFUNCTION(Client, Reliable)
+	void ClientResetFiring(uint8 NewMatchEpoch);
+
 public:
 	/** 第一人称相机 */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
@@ -111,6 +144,10 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Mesh)
 	USkeletalMeshComponent* ThirdPersonMesh;
 
+	/** 命中盒代理（武器判定用，服务器注册到延迟补偿历史） */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat)
+	UHitboxProxyComponent* HitboxProxy;
+
 	/** 生命值 */
 	UPROPERTY(ReplicatedUsing=OnRep_Health, VisibleAnywhere, BlueprintReadOnly, Category = Gameplay)
 	float Health;
@@ -147,18 +184,29 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	float FireRate;
 
+	/** 射弹速度（大于0时武器发射射弹，否则为即时命中） */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Gameplay)
+	float ProjectileSpeed;
+
 	/** 射击音效 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	USoundBase* FireSound;
 
-	/** 击中特效 */
+	/** 枪口火焰（Niagara系统或Cascade粒子系统，通过特效池播放，为空时使用战斗资产集中的默认特效） */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	UParticleSystem* MuzzleFlash;
+	UFXSystemAsset* MuzzleFlash;
+
+	/** 播放射击音效和枪口火焰（本地预测或装饰性事件通道触发） */
+	void PlayFireEffects();
 
 	/** 获取当前生命值百分比 */
 	UFUNCTION(BlueprintPure, Category = Gameplay)
 	float GetHealthPercent() const;
 
+	/** 是否已死亡 */
+	UFUNCTION(BlueprintPure, Category = Gameplay)
+	bool IsDead() const { return bIsDead; }
+
 	/** 造成伤害 */
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	void DealDamage(AActor* DamagedActor, float Damage);
@@ -167,10 +215,36 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	void AddScore(int32 Points);
 
+	/** 增加一次击杀 */
+	UFUNCTION(BlueprintCallable, Category = Gameplay)
+	void AddKill();
+
 	/** 重生 */
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	void Respawn();
 
+	/** 服务器：比赛软重置，清零得分和击杀数并按重生流程回到出生点 */
+	void ResetForMatch();
+
+	/** 获取重生倒计时（由复制的重生时间戳推算） */
+	UFUNCTION(BlueprintPure, Category = Gameplay)
+	float GetRespawnCountdown() const;
+
+	/** 服务器：设置重生的服务器时间 */
+	void SetRespawnServerTime(float ServerTime) { RespawnServerTime = ServerTime; }
+
+	/** 服务器：射击RPC限流器 */
+	const FRpcRateLimiter& GetFireRateLimiter() const { return FireRateLimiter; }
+
+	/** 服务器：限流并判定一个射击命令包（ServerFireWeapon 的实现，洪泛测试直接调用），返回判定的射击数 */
+	int32 ProcessFireBatch(const FFireCommandBatch& Batch);
+
+	/** 服务器：已处理的最新射击序列号 */
+	uint16 GetLastProcessedFireSequence() const { return LastProcessedFireSequence; }
+
+	/** 当前比赛轮次（射击命令包需带上此值才会被判定） */
+	uint8 GetFireMatchEpoch() const { return FireMatchEpoch; }
+
 	/** 初始化生命值 */
 	UFUNCTION()
 	void InitializeHealth();
@@ -185,6 +259,45 @@ protected:
 	/** 上次射击时间 */
 	float LastFireTime;
 
+	/** 射击调度（按固定间隔累积，每帧输出带子帧时间戳的射击） */
+	FWeaponFireScheduler FireScheduler;
+
+	/** 服务器上次判定射击的时间（用于网络优先级） */
+	float LastServerShotTime;
+
+	/** 比赛轮次：服务器每次软重置递增，拥有者客户端由ClientResetFiring同步；上一场发出的射击不再判定 */
+	uint8 FireMatchEpoch;
+
+	/** 带宽统计：复制属性的变化追踪 */
+	NetBandwidth::FPropertyTracker AccountedProperties;
+
+	/** 客户端未确认的射击命令 */
+	FFireCommandStream FireCommandStream;
+
+	/** 客户端：模拟代理的移动快照缓冲 */
+	FEnemySnapshotBuffer MovementSnapshots;
+
+	/** 客户端：最新移动快照的服务器时间 */
+	double LastMovementSnapshotTime;
+
+	/** 服务器：射击RPC限流器 */
+	FRpcRateLimiter FireRateLimiter;
+
+	/** 服务器已处理的最新射击序列号（只复制给拥有者，作为确认） */
+	UPROPERTY(ReplicatedUsing=OnRep_LastProcessedFireSequence)
+	uint16 LastProcessedFireSequence;
+
+	/** 重生的服务器时间（只复制给拥有者） */
+	UPROPERTY(Replicated)
+	float RespawnServerTime;
+
+	/** 死亡前的控制器（死亡时被解除控制，重生时重新控制） */
+	TWeakObjectPtr<AController> PreviousController;
+
+	/** 网络：射击确认复制回调 */
+	UFUNCTION()
+	void OnRep_LastProcessedFireSequence();
+
 	/** 网络：生命值复制回调 */
 	UFUNCTION()
 	void OnRep_Health();
@@ -193,10 +306,14 @@ protected:
 	UFUNCTION()
 	void OnRep_IsDead();
 
+	/** 客户端：模拟代理从快照缓冲插值移动 */
+	void UpdateSimulatedMovement();
+
 	/** 射线检测 - 服务器使用 */
 	UFUNCTION(BlueprintCallable, Category = Gameplay)
 	bool WeaponTrace(FVector& OutHitLocation, AActor*& OutHitActor);
 
-	/** 造成点伤害 */
+public:
+	/** 造成点伤害（即时命中批处理每次命中调用，伤害队列按受害者合并） */
 	void ApplyPointDamage(AActor* HitActor, float Damage, const FVector& HitLocation);
 };
@@ -1,22 +1,47 @@
 // FirstPersonDemoGameMode.cpp - 游戏模式实现
 
 #include "FirstPersonDemoGameMode.h"
+#include "UE5FirstPersonDemo.h"
 #include "FirstPersonDemoCharacter.h"
 #include "EnemyAICharacter.h"
-#include "GameFramework/PlayerController.h"
+#include "FirstPersonDemoPlayerController.h"
+#include "FirstPersonDemoGameState.h"
+#include "PlayerBotController.h"
+#include "CombatAssetSubsystem.h"
+#include "VictoryEvaluator.h"
+#include "WaveDirectorSubsystem.h"
+#include "ThreatMapSubsystem.h"
+#include "SpawnPointSubsystem.h"
+#include "EnemyPoolSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "HitscanBatchSubsystem.h"
+#include "DamageQueueSubsystem.h"
 #include "GameFramework/PlayerState.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/DamageEvents.h"
 #include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogGameMode, Warning, All);
+DEFINE_LOG_CATEGORY_STATIC(LogRestartTest, Log, All);
+DEFINE_LOG_CATEGORY_STATIC(LogMatchSetup, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Initialize Game"), STAT_InitializeGame, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Restart Match"), STAT_RestartMatch, STATGROUP_FirstPersonDemo);
 
 AFirstPersonDemoGameMode::AFirstPersonDemoGameMode()
 {
-	// 启用网络复制
-	bReplicates = true;
+	// 胜利条件由比赛事件驱动评估，不需要Tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	// 设置默认GameState类
+	GameStateClass = AFirstPersonDemoGameState::StaticClass();
 
 	// 设置默认玩家控制器类
-	PlayerControllerClass = APlayerController::StaticClass();
+	PlayerControllerClass = AFirstPersonDemoPlayerController::StaticClass();
 
 	// 设置默认角色类
 	DefaultPawnClass = AFirstPersonDemoCharacter::StaticClass();
@@ -26,7 +51,6 @@ AFirstPersonDemoGameMode::AFirstPersonDemoGameMode()
 	TargetScore = 1000;
 	TargetKillCount = 10;
 	GameTimeLimit = 600.0f; // 10分钟
-	RemainingTime = GameTimeLimit;
 
 	CurrentWave = 0;
 	MaxWaves = 5;
@@ -35,6 +59,9 @@ AFirstPersonDemoGameMode::AFirstPersonDemoGameMode()
 	WaveInterval = 10.0f;
 	RespawnDelay = 5.0f;
 
+	NumPlayerBots = 0;
+	PlayerBotClass = APlayerBotController::StaticClass();
+
 	CurrentGameState = EGameState::Waiting;
 
 	// 默认敌人生成位置（将在BeginPlay中初始化）
@@ -56,32 +83,13 @@ void AFirstPersonDemoGameMode::BeginPlay()
 	Super::BeginPlay();
 
 	InitializeGame();
-}
-
-void AFirstPersonDemoGameMode::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
 
-	if (CurrentGameState == EGameState::InProgress)
+	// 无人值守的服务器可以只用机器人开局
+	FParse::Value(FCommandLine::Get(), TEXT("bots="), NumPlayerBots);
+	if (NumPlayerBots > 0)
 	{
-		// 更新游戏计时器
-		if (VictoryCondition == EVictoryCondition::TimeLimit)
-		{
-			RemainingTime -= DeltaTime;
-			if (RemainingTime <= 0.0f)
-			{
-				RemainingTime = 0.0f;
-
-				// 时间到，检查最高分玩家获胜
-				if (AFirstPersonDemoCharacter* Winner = GetHighestScoringPlayer())
-				{
-					EndGame(Winner);
-				}
-			}
-		}
-
-		// 检查胜利条件
-		CheckVictoryCondition();
+		SpawnPlayerBots(NumPlayerBots);
+		StartGame();
 	}
 }
 
@@ -123,8 +131,15 @@ void AFirstPersonDemoGameMode::Logout(AController* Exiting)
 		PlayersToRespawn.Remove(Player);
 	}
 
-	// 检查是否所有玩家都已离开
-	if (GetNumPlayers() == 0)
+	// 从排行榜中移除
+	AFirstPersonDemoGameState* DemoGameState = GetDemoGameState();
+	if (DemoGameState && Exiting->PlayerState)
+	{
+		DemoGameState->RemovePlayerScore(Exiting->PlayerState->GetPlayerId());
+	}
+
+	// 检查是否所有玩家都已离开（机器人不算）
+	if (GetNumPlayers() == 0 && PlayerBots.Num() == 0)
 	{
 		EndGame(nullptr);
 	}
@@ -132,19 +147,50 @@ void AFirstPersonDemoGameMode::Logout(AController* Exiting)
 
 void AFirstPersonDemoGameMode::InitializeGame()
 {
-	CurrentGameState = EGameState::Waiting;
-	RemainingTime = GameTimeLimit;
+	SCOPE_CYCLE_COUNTER(STAT_InitializeGame);
+	const double StartTime = FPlatformTime::Seconds();
+
 	CurrentWave = 0;
 
-	// 清理现有敌人生成位置
-	EnemySpawnLocations.Empty();
+	// 比赛开始前异步预加载战斗资产，比赛中不再同步加载
+	if (UCombatAssetSubsystem* CombatAssets = GetWorld()->GetSubsystem<UCombatAssetSubsystem>())
+	{
+		CombatAssets->PreloadAssets();
+	}
+
+	if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		DemoGameState->SetCurrentWave(0);
+		DemoGameState->SetNextWaveServerTime(0.0f);
+	}
 
-	// 从场景中获取所有敌人生成点
-	TArray<AActor*> FoundActors;
-	UGameplayStatics::GetAllActorsWithTag(GetWorld(), FName("EnemySpawn"), FoundActors);
-	for (AActor* Actor : FoundActors)
+	// 从出生点注册表获取敌人生成点和玩家出生点（烘焙清单加上已注册的组件，不扫描世界）
+	USpawnPointSubsystem* SpawnPoints = GetWorld()->GetSubsystem<USpawnPointSubsystem>();
+	if (SpawnPoints && SpawnPoints->HasSpawnPoints())
 	{
-		EnemySpawnLocations.Add(Actor->GetActorLocation());
+		SpawnPoints->GetSpawnLocations(ESpawnPointType::Enemy, EnemySpawnLocations);
+		SpawnPoints->GetSpawnLocations(ESpawnPointType::Player, PlayerStartLocations);
+	}
+	else
+	{
+		// 尚未迁移到出生点组件、也没有烘焙清单的地图：回退到标签扫描
+		UE_LOG(LogGameMode, Warning, TEXT("No spawn point manifest or components registered, falling back to tag scan"));
+
+		EnemySpawnLocations.Empty();
+		PlayerStartLocations.Empty();
+
+		TArray<AActor*> FoundActors;
+		UGameplayStatics::GetAllActorsWithTag(GetWorld(), FName("EnemySpawn"), FoundActors);
+		for (AActor* Actor : FoundActors)
+		{
+			EnemySpawnLocations.Add(Actor->GetActorLocation());
+		}
+
+		UGameplayStatics::GetAllActorsWithTag(GetWorld(), FName("PlayerStart"), FoundActors);
+		for (AActor* Actor : FoundActors)
+		{
+			PlayerStartLocations.Add(Actor->GetActorLocation());
+		}
 	}
 
 	// 如果没有找到生成点，使用默认位置
@@ -157,17 +203,6 @@ void AFirstPersonDemoGameMode::InitializeGame()
 		EnemySpawnLocations.Add(FVector(0.0f, 1000.0f, 100.0f));
 	}
 
-	// 清理现有玩家出生点
-	PlayerStartLocations.Empty();
-
-	// 从场景中获取所有玩家出生点
-	FoundActors.Empty();
-	UGameplayStatics::GetAllActorsWithTag(GetWorld(), FName("PlayerStart"), FoundActors);
-	for (AActor* Actor : FoundActors)
-	{
-		PlayerStartLocations.Add(Actor->GetActorLocation());
-	}
-
 	// 如果没有找到出生点，使用默认位置
 	if (PlayerStartLocations.Num() == 0)
 	{
@@ -176,8 +211,19 @@ void AFirstPersonDemoGameMode::InitializeGame()
 		PlayerStartLocations.Add(FVector(-200.0f, 0.0f, 100.0f));
 		PlayerStartLocations.Add(FVector(0.0f, 200.0f, 100.0f));
 	}
+	NextPlayerStartIndex = 0;
 
-	OnGameStateChangedDelegate.Broadcast(CurrentGameState);
+	// 按候选点建立威胁影响图
+	if (UThreatMapSubsystem* ThreatMap = GetWorld()->GetSubsystem<UThreatMapSubsystem>())
+	{
+		ThreatMap->Build(PlayerStartLocations, EnemySpawnLocations);
+	}
+
+	SetGameState(EGameState::Waiting);
+
+	// LogGameMode默认只输出警告，初始化耗时单独分类，默认可见
+	UE_LOG(LogMatchSetup, Log, TEXT("InitializeGame: %d enemy spawns, %d player starts, %.2f ms"),
+		EnemySpawnLocations.Num(), PlayerStartLocations.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
 void AFirstPersonDemoGameMode::StartGame()
@@ -187,8 +233,16 @@ void AFirstPersonDemoGameMode::StartGame()
 		return;
 	}
 
-	CurrentGameState = EGameState::InProgress;
-	OnGameStateChangedDelegate.Broadcast(CurrentGameState);
+	SetGameState(EGameState::InProgress);
+
+	VictoryEvaluator = FVictoryEvaluator::Create(VictoryCondition, TargetScore, TargetKillCount, MaxWaves);
+	RefreshHighestScorer();
+
+	// 复制一次开始时间戳和时长，客户端自行推算剩余时间
+	if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		DemoGameState->StartMatchClock(VictoryCondition == EVictoryCondition::TimeLimit ? GameTimeLimit : 0.0f);
+	}
 
 	UE_LOG(LogGameMode, Log, TEXT("Game started!"));
 
@@ -197,9 +251,9 @@ void AFirstPersonDemoGameMode::StartGame()
 	{
 		GetWorld()->GetTimerManager().SetTimer(GameTimerHandle, [this]()
 		{
-			if (AFirstPersonDemoCharacter* Winner = GetHighestScoringPlayer())
+			if (VictoryEvaluator)
 			{
-				EndGame(Winner);
+				ApplyVictoryDecision(VictoryEvaluator->OnTimeExpired());
 			}
 		}, GameTimeLimit, false);
 	}
@@ -215,14 +269,18 @@ void AFirstPersonDemoGameMode::EndGame(AFirstPersonDemoCharacter* Winner)
 		return;
 	}
 
-	CurrentGameState = EGameState::GameOver;
-	OnGameStateChangedDelegate.Broadcast(CurrentGameState);
+	SetGameState(EGameState::GameOver);
 
 	// 清理所有计时器
 	GetWorld()->GetTimerManager().ClearTimer(GameTimerHandle);
-	GetWorld()->GetTimerManager().ClearTimer(EnemySpawnTimerHandle);
 	GetWorld()->GetTimerManager().ClearTimer(WaveTimerHandle);
 
+	// 丢弃尚未生成的敌人
+	if (UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>())
+	{
+		WaveDirector->ClearQueue();
+	}
+
 	if (Winner)
 	{
 		UE_LOG(LogGameMode, Log, TEXT("Game Over! Winner: %s with score: %d"),
@@ -254,6 +312,70 @@ void AFirstPersonDemoGameMode::EndGame(AFirstPersonDemoCharacter* Winner)
 	}
 }
 
+void AFirstPersonDemoGameMode::RestartMatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RestartMatch);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// 上一场的计时器全部作废（逐个玩家的重生计时器按比赛编号失效）
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	TimerManager.ClearTimer(GameTimerHandle);
+	TimerManager.ClearTimer(RespawnTimerHandle);
+	TimerManager.ClearTimer(WaveTimerHandle);
+	++MatchNumber;
+	PlayersToRespawn.Reset();
+
+	// 丢弃尚未生成的敌人，场上的敌人（包括尸体）回收到敌人池
+	if (UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>())
+	{
+		WaveDirector->ClearQueue();
+	}
+	int32 NumReleased = 0;
+	if (UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+	{
+		NumReleased = EnemyPool->ReleaseAll();
+	}
+	SpawnedEnemies.Reset();
+
+	// 上一场飞行中的射弹、等待射线结果的射击和本帧未结算的伤害不能落到新比赛的玩家身上
+	int32 NumCombatCleared = 0;
+	if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+	{
+		NumCombatCleared += Projectiles->ClearProjectiles();
+	}
+	if (UHitscanBatchSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanBatchSubsystem>())
+	{
+		NumCombatCleared += Hitscan->ClearShots();
+	}
+	if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+	{
+		NumCombatCleared += DamageQueue->ClearPending();
+	}
+
+	VictoryEvaluator.Reset();
+	HighestScorer = nullptr;
+	HighestScore = -1;
+
+	if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		DemoGameState->ResetMatch();
+	}
+
+	// 重新读取出生点、重建影响图，状态回到等待中
+	InitializeGame();
+
+	// 玩家和机器人回到出生点（分数直接清零，不触发胜利条件评估）
+	for (TActorIterator<AFirstPersonDemoCharacter> It(GetWorld()); It; ++It)
+	{
+		It->ResetForMatch();
+	}
+
+	StartGame();
+
+	UE_LOG(LogGameMode, Log, TEXT("Match %d restarted in place: %d enemies pooled, %d shots/projectiles/damage discarded, %.2f ms"),
+		MatchNumber, NumReleased, NumCombatCleared, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
 void AFirstPersonDemoGameMode::OnPlayerDeath(AFirstPersonDemoCharacter* DeadPlayer)
 {
 	if (!DeadPlayer)
@@ -266,10 +388,21 @@ void AFirstPersonDemoGameMode::OnPlayerDeath(AFirstPersonDemoCharacter* DeadPlay
 	// 添加到待重生列表
 	PlayersToRespawn.Add(DeadPlayer);
 
-	// 设置重生定时器
+	PublishPlayerScore(DeadPlayer, 1);
+
+	// 复制重生时间戳，客户端自行推算倒计时
+	DeadPlayer->SetRespawnServerTime(GetWorld()->GetTimeSeconds() + RespawnDelay);
+
+	// 设置重生定时器（比赛软重置后作废，重置时已经重生）
 	FTimerHandle RespawnTimer;
-	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, [this, DeadPlayer]()
+	const int32 DeathMatchNumber = MatchNumber;
+	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, [this, DeadPlayer, DeathMatchNumber]()
 	{
+		if (DeathMatchNumber != MatchNumber)
+		{
+			return;
+		}
+
 		if (DeadPlayer && !DeadPlayer->IsPendingKillPending())
 		{
 			DeadPlayer->Respawn();
@@ -277,8 +410,7 @@ void AFirstPersonDemoGameMode::OnPlayerDeath(AFirstPersonDemoCharacter* DeadPlay
 		}
 	}, RespawnDelay, false);
 
-	// 检查胜利条件
-	CheckVictoryCondition();
+	// 目前没有依赖玩家死亡的胜利条件，击杀的得分和击杀数变化由NotifyPlayerStatsChanged评估
 }
 
 void AFirstPersonDemoGameMode::OnEnemyDeath(AEnemyAICharacter* DeadEnemy)
@@ -291,37 +423,92 @@ void AFirstPersonDemoGameMode::OnEnemyDeath(AEnemyAICharacter* DeadEnemy)
 	// 从已生成列表中移除
 	SpawnedEnemies.Remove(DeadEnemy);
 
-	// 检查当前波次是否完成
-	if (SpawnedEnemies.Num() == 0 && CurrentWave < MaxWaves)
+	CheckWaveCleared();
+}
+
+void AFirstPersonDemoGameMode::OnSpawnQueueDrained()
+{
+	CheckWaveCleared();
+}
+
+void AFirstPersonDemoGameMode::CheckWaveCleared()
+{
+	// 场上还有敌人，或波次导演的队列中还有待生成的敌人
+	const UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>();
+	if (SpawnedEnemies.Num() > 0 || (WaveDirector && WaveDirector->GetNumQueued() > 0))
+	{
+		return;
+	}
+
+	// 还没有开始波次，或本波已经清空、下一波在等待中
+	if (CurrentWave == 0 || GetWorld()->GetTimerManager().IsTimerActive(WaveTimerHandle))
+	{
+		return;
+	}
+
+	// 当前波次清空
+	if (VictoryEvaluator && CurrentGameState == EGameState::InProgress)
+	{
+		ApplyVictoryDecision(VictoryEvaluator->OnWaveCleared(CurrentWave));
+	}
+
+	if (CurrentGameState == EGameState::InProgress && CurrentWave < MaxWaves)
 	{
 		// 生成下一波
 		GetWorld()->GetTimerManager().SetTimer(WaveTimerHandle, [this]()
 		{
 			SpawnNextWave();
 		}, WaveInterval, false);
+
+		// 复制下一波开始时间戳
+		if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+		{
+			DemoGameState->SetNextWaveServerTime(GetWorld()->GetTimeSeconds() + WaveInterval);
+		}
 	}
 }
 
-void AFirstPersonDemoGameMode::SpawnEnemy()
+AEnemyAICharacter* AFirstPersonDemoGameMode::SpawnEnemy()
 {
-	if (!EnemyClass || EnemySpawnLocations.Num() == 0)
+	// 游戏模式未指定敌人类时使用常驻资产集中的类
+	TSubclassOf<AEnemyAICharacter> SpawnClass = EnemyClass;
+	if (!SpawnClass)
 	{
-		return;
+		if (UCombatAssetSubsystem* CombatAssets = GetWorld()->GetSubsystem<UCombatAssetSubsystem>())
+		{
+			SpawnClass = CombatAssets->GetClass<AEnemyAICharacter>(ECombatAsset::EnemyClass);
+		}
 	}
 
-	// 随机选择生成位置
-	int32 RandomIndex = FMath::RandRange(0, EnemySpawnLocations.Num() - 1);
-	FVector SpawnLocation = EnemySpawnLocations[RandomIndex];
+	if (!SpawnClass || EnemySpawnLocations.Num() == 0)
+	{
+		return nullptr;
+	}
 
-	// 生成敌人
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	// 选择影响图给出的玩家附近、视线外的点（Build时已排出第一批候选），没有影响图时随机选择
+	UThreatMapSubsystem* ThreatMap = GetWorld()->GetSubsystem<UThreatMapSubsystem>();
+	int32 SpawnIndex = ThreatMap ? ThreatMap->ChooseEnemySpawn() : INDEX_NONE;
+	if (!EnemySpawnLocations.IsValidIndex(SpawnIndex))
+	{
+		SpawnIndex = FMath::RandRange(0, EnemySpawnLocations.Num() - 1);
+	}
+	FVector SpawnLocation = EnemySpawnLocations[SpawnIndex];
 
-	if (AEnemyAICharacter* Enemy = GetWorld()->SpawnActor<AEnemyAICharacter>(EnemyClass, SpawnLocation, FRotator::ZeroRotator, SpawnParams))
+	// 从敌人池取出（复用回收的敌人，池中没有时生成新的）
+	UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (!EnemyPool)
+	{
+		return nullptr;
+	}
+
+	if (AEnemyAICharacter* Enemy = EnemyPool->Acquire(SpawnClass, SpawnLocation, FRotator::ZeroRotator))
 	{
 		SpawnedEnemies.Add(Enemy);
 		UE_LOG(LogGameMode, Log, TEXT("Spawned enemy at: %s"), *SpawnLocation.ToString());
+		return Enemy;
 	}
+
+	return nullptr;
 }
 
 void AFirstPersonDemoGameMode::SpawnEnemyWave(int32 WaveNumber)
@@ -332,18 +519,54 @@ void AFirstPersonDemoGameMode::SpawnEnemyWave(int32 WaveNumber)
 	}
 
 	CurrentWave = WaveNumber;
+	if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		DemoGameState->SetCurrentWave(WaveNumber);
+		DemoGameState->SetNextWaveServerTime(0.0f);
+	}
+
 	int32 EnemiesToSpawn = EnemiesPerWave + (WaveNumber - 1) * 2; // 每波增加2个敌人
 
 	UE_LOG(LogGameMode, Log, TEXT("Spawning wave %d with %d enemies"), WaveNumber, EnemiesToSpawn);
 
-	// 生成敌人
-	for (int32 i = 0; i < EnemiesToSpawn; i++)
+	// 交给波次导演排队，按服务器帧时间预算分摊生成
+	if (UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>())
+	{
+		WaveDirector->QueueWave(EnemiesToSpawn, EnemySpawnInterval);
+	}
+}
+
+void AFirstPersonDemoGameMode::SpawnPlayerBots(int32 Count)
+{
+	if (!PlayerBotClass || !DefaultPawnClass)
 	{
-		GetWorld()->GetTimerManager().SetTimer(EnemySpawnTimerHandle, [this]()
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		APlayerBotController* Bot = GetWorld()->SpawnActor<APlayerBotController>(PlayerBotClass, SpawnParams);
+		if (!Bot)
 		{
-			SpawnEnemy();
-		}, i * EnemySpawnInterval, false);
+			continue;
+		}
+
+		AFirstPersonDemoCharacter* Character = GetWorld()->SpawnActor<AFirstPersonDemoCharacter>(DefaultPawnClass,
+			ChoosePlayerStart(nullptr), FRotator::ZeroRotator, SpawnParams);
+		if (!Character)
+		{
+			Bot->Destroy();
+			continue;
+		}
+
+		Bot->Possess(Character);
+		PlayerBots.Add(Bot);
 	}
+
+	UE_LOG(LogGameMode, Log, TEXT("Spawned %d player bots"), PlayerBots.Num());
 }
 
 void AFirstPersonDemoGameMode::SpawnNextWave()
@@ -364,8 +587,41 @@ void AFirstPersonDemoGameMode::SpawnNextWave()
 
 AFirstPersonDemoCharacter* AFirstPersonDemoGameMode::GetHighestScoringPlayer() const
 {
-	AFirstPersonDemoCharacter* HighestScorer = nullptr;
-	int32 HighestScore = -1;
+	return HighestScorer.Get();
+}
+
+void AFirstPersonDemoGameMode::NotifyPlayerStatsChanged(AFirstPersonDemoCharacter* Player)
+{
+	if (!Player)
+	{
+		return;
+	}
+
+	// 维护最高分：分数增加时与当前最高分比较，同分时先达到的玩家领先；
+	// 领先者离开或分数下降时才重新扫描
+	if (!HighestScorer.IsValid() || (HighestScorer == Player && Player->Score < HighestScore))
+	{
+		RefreshHighestScorer();
+	}
+	else if (Player->Score > HighestScore)
+	{
+		HighestScore = Player->Score;
+		HighestScorer = Player;
+	}
+
+	PublishPlayerScore(Player, 0);
+	OnPlayerScoreChangedDelegate.Broadcast(Player, Player->Score);
+
+	if (VictoryEvaluator && CurrentGameState == EGameState::InProgress)
+	{
+		ApplyVictoryDecision(VictoryEvaluator->OnPlayerStatsChanged(Player));
+	}
+}
+
+void AFirstPersonDemoGameMode::RefreshHighestScorer()
+{
+	HighestScorer = nullptr;
+	HighestScore = -1;
 
 	for (FConstPawnIterator It = GetWorld()->GetPawnIterator(); It; ++It)
 	{
@@ -378,68 +634,63 @@ AFirstPersonDemoCharacter* AFirstPersonDemoGameMode::GetHighestScoringPlayer() c
 			}
 		}
 	}
+}
+
+void AFirstPersonDemoGameMode::PublishPlayerScore(AFirstPersonDemoCharacter* Player, int32 DeathDelta)
+{
+	AFirstPersonDemoGameState* DemoGameState = GetDemoGameState();
+	const APlayerState* PlayerState = Player->GetPlayerState();
+	if (!DemoGameState || !PlayerState)
+	{
+		return;
+	}
 
-	return HighestScorer;
+	const int32 PlayerId = PlayerState->GetPlayerId();
+	const FPlayerScoreData* Existing = DemoGameState->FindPlayerScore(PlayerId);
+	const int32 Deaths = (Existing ? Existing->DeathCount : 0) + DeathDelta;
+
+	DemoGameState->UpdatePlayerScoreById(PlayerId, PlayerState->GetPlayerName(), Player->Score, Player->KillCount, Deaths);
 }
 
-void AFirstPersonDemoGameMode::CheckVictoryCondition()
+void AFirstPersonDemoGameMode::ApplyVictoryDecision(const FVictoryDecision& Decision)
 {
-	if (CurrentGameState != EGameState::InProgress)
+	if (!Decision.bGameOver)
 	{
 		return;
 	}
 
-	switch (VictoryCondition)
+	if (!HighestScorer.IsValid())
 	{
-	case EVictoryCondition::Score:
-		{
-			// 检查是否有玩家达到目标分数
-			for (FConstPawnIterator It = GetWorld()->GetPawnIterator(); It; ++It)
-			{
-				if (AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(It->Get()))
-				{
-					if (Player->Score >= TargetScore)
-					{
-						EndGame(Player);
-						return;
-					}
-				}
-			}
-		}
-		break;
+		RefreshHighestScorer();
+	}
 
-	case EVictoryCondition::KillCount:
-		{
-			// 检查是否有玩家达到目标击杀数
-			for (FConstPawnIterator It = GetWorld()->GetPawnIterator(); It; ++It)
-			{
-				if (AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(It->Get()))
-				{
-					if (Player->KillCount >= TargetKillCount)
-					{
-						EndGame(Player);
-						return;
-					}
-				}
-			}
-		}
-		break;
+	EndGame(Decision.Winner ? Decision.Winner : GetHighestScoringPlayer());
+}
+
+void AFirstPersonDemoGameMode::CheckVictoryCondition()
+{
+	if (CurrentGameState != EGameState::InProgress || !VictoryEvaluator)
+	{
+		return;
+	}
 
-	case EVictoryCondition::Survival:
+	// 把当前状态作为事件重放一遍
+	for (FConstPawnIterator It = GetWorld()->GetPawnIterator(); It; ++It)
+	{
+		if (AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(It->Get()))
 		{
-			// 检查所有波次是否完成
-			if (CurrentWave >= MaxWaves && SpawnedEnemies.Num() == 0)
+			ApplyVictoryDecision(VictoryEvaluator->OnPlayerStatsChanged(Player));
+			if (CurrentGameState != EGameState::InProgress)
 			{
-				if (AFirstPersonDemoCharacter* Winner = GetHighestScoringPlayer())
-				{
-					EndGame(Winner);
-				}
+				return;
 			}
 		}
-		break;
+	}
 
-	default:
-		break;
+	const UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>();
+	if (CurrentWave > 0 && SpawnedEnemies.Num() == 0 && (!WaveDirector || WaveDirector->GetNumQueued() == 0))
+	{
+		ApplyVictoryDecision(VictoryEvaluator->OnWaveCleared(CurrentWave));
 	}
 }
 
@@ -462,15 +713,280 @@ FVector AFirstPersonDemoGameMode::ChoosePlayerStart(AFirstPersonDemoCharacter* P
 		return FVector::ZeroVector;
 	}
 
-	// 简单轮询选择出生点
-	static int32 StartIndex = 0;
-	FVector SpawnLocation = PlayerStartLocations[StartIndex % PlayerStartLocations.Num()];
-	StartIndex++;
+	// 影响图给出的最安全出生点
+	if (UThreatMapSubsystem* ThreatMap = GetWorld()->GetSubsystem<UThreatMapSubsystem>())
+	{
+		const int32 StartIndex = ThreatMap->ChoosePlayerStart();
+		if (PlayerStartLocations.IsValidIndex(StartIndex))
+		{
+			return PlayerStartLocations[StartIndex];
+		}
+	}
 
-	return SpawnLocation;
+	// 影响图尚无结果（开局第一帧之前）时轮询
+	return PlayerStartLocations[NextPlayerStartIndex++ % PlayerStartLocations.Num()];
 }
 
-void AFirstPersonDemoGameMode::OnRep_GameState()
+float AFirstPersonDemoGameMode::GetRemainingTime() const
 {
+	const AFirstPersonDemoGameState* DemoGameState = GetDemoGameState();
+	return DemoGameState ? DemoGameState->GetRemainingTime() : 0.0f;
+}
+
+void AFirstPersonDemoGameMode::SetGameState(EGameState NewState)
+{
+	CurrentGameState = NewState;
+
+	// 同步到GameState
+	if (AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		switch (NewState)
+		{
+		case EGameState::Waiting:
+			DemoGameState->SetMatchState(EMatchState::Waiting);
+			break;
+
+		case EGameState::InProgress:
+			DemoGameState->SetMatchState(EMatchState::InProgress);
+			break;
+
+		case EGameState::GameOver:
+			DemoGameState->SetMatchState(EMatchState::Finished);
+			break;
+		}
+	}
+
 	OnGameStateChangedDelegate.Broadcast(CurrentGameState);
 }
+
+AFirstPersonDemoGameState* AFirstPersonDemoGameMode::GetDemoGameState() const
+{
+	return GetGameState<AFirstPersonDemoGameState>();
+}
+
+void AFirstPersonDemoGameMode::StartRestartTest(int32 NumRestarts, float MatchSeconds)
+{
+	RestartTest = FRestartTest();
+	RestartTest.NumRemaining = FMath::Max(NumRestarts, 1);
+
+	// 没有玩家时用机器人测试玩家重置
+	TActorIterator<AFirstPersonDemoCharacter> It(GetWorld());
+	if (!It)
+	{
+		SpawnPlayerBots(2);
+	}
+
+	if (CurrentGameState == EGameState::Waiting)
+	{
+		StartGame();
+	}
+
+	GetWorld()->GetTimerManager().SetTimer(RestartTestTimerHandle, this, &AFirstPersonDemoGameMode::TickRestartTest,
+		FMath::Max(MatchSeconds, 0.1f), true);
+
+	UE_LOG(LogRestartTest, Display, TEXT("Restart test: %d restarts, %.1f s per match"), RestartTest.NumRemaining, MatchSeconds);
+}
+
+void AFirstPersonDemoGameMode::TickRestartTest()
+{
+	// 上一轮还在等待下一帧的检查（帧时间超过比赛时长时）
+	if (RestartTest.bAwaitingVerify)
+	{
+		return;
+	}
+
+	// 制造上一场的状态：第一个存活的玩家击杀一半场上的敌人，再击杀另一名玩家（只有一名时击杀自己）
+	AFirstPersonDemoCharacter* Killer = nullptr;
+	AFirstPersonDemoCharacter* Victim = nullptr;
+	for (TActorIterator<AFirstPersonDemoCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->IsDead())
+		{
+			continue;
+		}
+
+		if (!Killer)
+		{
+			Killer = *It;
+		}
+		else if (!Victim)
+		{
+			Victim = *It;
+		}
+	}
+
+	const TArray<TWeakObjectPtr<AEnemyAICharacter>> Enemies = SpawnedEnemies;
+	for (int32 Index = 0; Index < Enemies.Num(); Index += 2)
+	{
+		if (AEnemyAICharacter* Enemy = Enemies[Index].Get())
+		{
+			Enemy->TakeDamage(Enemy->GetHealth(), FDamageEvent(), nullptr, Killer);
+		}
+	}
+
+	if (AFirstPersonDemoCharacter* DeadPlayer = Victim ? Victim : Killer)
+	{
+		// 角色把TakeDamage覆盖为protected，经由AActor的公有接口调用
+		static_cast<AActor*>(DeadPlayer)->TakeDamage(DeadPlayer->Health, FDamageEvent(), nullptr, Victim ? Killer : nullptr);
+	}
+
+	// 上一场遗留的战斗状态：一次未结算的伤害、一发等待射线的即时命中射击和一发飞行中的射弹
+	if (Killer && !Killer->IsDead())
+	{
+		const FVector Origin = Killer->GetActorLocation();
+		const FVector Direction = Killer->GetActorForwardVector();
+		const float Now = GetWorld()->GetTimeSeconds();
+		if (UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>())
+		{
+			DamageQueue->SubmitDamage(Killer, Killer->MaxHealth, nullptr, nullptr, Origin, Direction);
+		}
+		if (UHitscanBatchSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanBatchSubsystem>())
+		{
+			Hitscan->QueueShot(Killer, Origin, Direction, Now, Killer->WeaponDamage);
+		}
+		if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+		{
+			Projectiles->FireProjectile(Killer, Origin, Direction * 3000.0f, Now, Killer->WeaponDamage);
+		}
+	}
+
+	const int32 NumEnemies = Enemies.Num();
+	const double StartTime = FPlatformTime::Seconds();
+	RestartMatch();
+	RestartTest.RoundMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	RestartTest.RoundNumEnemies = NumEnemies;
+
+	// 战斗队列必须在重置的同一帧清空；其余状态在下一帧检查，本帧末结算的遗留伤害也会被发现
+	RestartTest.RoundError.Reset();
+	VerifyCombatCleared(RestartTest.RoundError);
+	RestartTest.bAwaitingVerify = true;
+	GetWorldTimerManager().SetTimerForNextTick(this, &AFirstPersonDemoGameMode::FinishRestartTestRound);
+}
+
+void AFirstPersonDemoGameMode::FinishRestartTestRound()
+{
+	RestartTest.bAwaitingVerify = false;
+
+	FString Error = RestartTest.RoundError;
+	const bool bPassed = Error.IsEmpty() && VerifyMatchReset(Error);
+	const double RestartMs = RestartTest.RoundMs;
+	++RestartTest.NumRestarts;
+	RestartTest.NumFailed += bPassed ? 0 : 1;
+	RestartTest.TotalMs += RestartMs;
+	RestartTest.MaxMs = FMath::Max(RestartTest.MaxMs, RestartMs);
+
+	UE_LOG(LogRestartTest, Display, TEXT("  Restart %d: %.2f ms, %d enemies on field, %s%s"),
+		RestartTest.NumRestarts, RestartMs, RestartTest.RoundNumEnemies, bPassed ? TEXT("ok") : TEXT("FAILED: "), *Error);
+
+	if (--RestartTest.NumRemaining > 0)
+	{
+		return;
+	}
+
+	GetWorld()->GetTimerManager().ClearTimer(RestartTestTimerHandle);
+
+	// 每次重置都要回到干净状态，且在一秒内完成
+	const bool bAllPassed = RestartTest.NumFailed == 0 && RestartTest.MaxMs < 1000.0;
+	const UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	UE_LOG(LogRestartTest, Display, TEXT("Restart test: %d restarts, %d failed, avg %.2f ms, max %.2f ms, %d enemies idle in pool: %s"),
+		RestartTest.NumRestarts, RestartTest.NumFailed, RestartTest.TotalMs / RestartTest.NumRestarts, RestartTest.MaxMs,
+		EnemyPool ? EnemyPool->GetNumPooled() : 0, bAllPassed ? TEXT("PASS") : TEXT("FAIL"));
+}
+
+bool AFirstPersonDemoGameMode::VerifyMatchReset(FString& OutError) const
+{
+	if (CurrentGameState != EGameState::InProgress || CurrentWave != 1)
+	{
+		OutError = FString::Printf(TEXT("game state %d, wave %d"), static_cast<int32>(CurrentGameState), CurrentWave);
+		return false;
+	}
+
+	if (const AFirstPersonDemoGameState* DemoGameState = GetDemoGameState())
+	{
+		if (DemoGameState->GetCurrentWave() != 1 || DemoGameState->GetPlayerScores().Num() > 0)
+		{
+			OutError = FString::Printf(TEXT("game state wave %d, %d leaderboard entries"),
+				DemoGameState->GetCurrentWave(), DemoGameState->GetPlayerScores().Num());
+			return false;
+		}
+	}
+
+	if (PlayersToRespawn.Num() > 0)
+	{
+		OutError = FString::Printf(TEXT("%d players to respawn"), PlayersToRespawn.Num());
+		return false;
+	}
+
+	for (TActorIterator<AFirstPersonDemoCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->IsDead() || It->Score != 0 || It->KillCount != 0 || It->GetHealthPercent() < 1.0f)
+		{
+			OutError = FString::Printf(TEXT("%s not reset (dead %d, score %d, kills %d, health %.0f%%)"), *It->GetName(),
+				It->IsDead() ? 1 : 0, It->Score, It->KillCount, It->GetHealthPercent() * 100.0f);
+			return false;
+		}
+	}
+
+	// 上一场的敌人全部回池；存活的只能是重置后新一波生成的敌人
+	for (TActorIterator<AEnemyAICharacter> It(GetWorld()); It; ++It)
+	{
+		if (!It->IsDead() && !SpawnedEnemies.Contains(*It))
+		{
+			OutError = FString::Printf(TEXT("enemy %s from previous match still alive"), *It->GetName());
+			return false;
+		}
+	}
+
+	const UEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (EnemyPool && EnemyPool->GetNumActive() > SpawnedEnemies.Num())
+	{
+		OutError = FString::Printf(TEXT("%d enemies checked out of the pool, %d spawned this match"), EnemyPool->GetNumActive(), SpawnedEnemies.Num());
+		return false;
+	}
+
+	return true;
+}
+
+bool AFirstPersonDemoGameMode::VerifyCombatCleared(FString& OutError) const
+{
+	const UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+	const UHitscanBatchSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanBatchSubsystem>();
+	const UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+
+	const int32 NumProjectiles = Projectiles ? Projectiles->GetNumProjectiles() : 0;
+	const int32 NumShots = Hitscan ? Hitscan->GetNumQueued() : 0;
+	const int32 NumDamage = DamageQueue ? DamageQueue->GetNumPending() : 0;
+	if (NumProjectiles > 0 || NumShots > 0 || NumDamage > 0)
+	{
+		OutError = FString::Printf(TEXT("%d projectiles, %d hitscan shots, %d damage submissions left from previous match"), NumProjectiles, NumShots, NumDamage);
+		return false;
+	}
+
+	return true;
+}
+
+/** 控制台命令：在同一世界中软重置并重新开始比赛 */
+static FAutoConsoleCommandWithWorldAndArgs GRestartMatchCommand(
+	TEXT("fpd.RestartMatch"),
+	TEXT("软重置比赛：回收敌人到敌人池，重置玩家、计数和计时器，重新初始化并开始，不切换地图"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (AFirstPersonDemoGameMode* GameMode = World ? World->GetAuthGameMode<AFirstPersonDemoGameMode>() : nullptr)
+		{
+			GameMode->RestartMatch();
+		}
+	}));
+
+/** 控制台命令：连续软重置测试（服务器，可在 -nullrhi 的专用服务器上通过 -ExecCmds 运行） */
+static FAutoConsoleCommandWithWorldAndArgs GRestartTestCommand(
+	TEXT("fpd.RestartTest"),
+	TEXT("连续软重置测试：fpd.RestartTest [重置次数=5] [每场秒数=3]，检查每次重置后的状态并输出耗时，全部通过且都在1秒内时为PASS"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (AFirstPersonDemoGameMode* GameMode = World ? World->GetAuthGameMode<AFirstPersonDemoGameMode>() : nullptr)
+		{
+			const int32 NumRestarts = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 5;
+			const float MatchSeconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 3.0f;
+			GameMode->StartRestartTest(NumRestarts, MatchSeconds);
+		}
+	}));
@@ -8,6 +8,10 @@
 
 class AFirstPersonDemoCharacter;
 class AEnemyAICharacter;
+class AFirstPersonDemoGameState;
+class APlayerBotController;
+class FVictoryEvaluator;
+struct FVictoryDecision;
 
 /**
  * 游戏胜利条件
@@ -49,7 +53,6 @@ public:
 	AFirstPersonDemoGameMode();
 
 	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaTime) override;
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
 
@@ -65,6 +68,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Game)
 	void EndGame(AFirstPersonDemoCharacter* Winner);
 
+	/** 在同一世界中软重置并重新开始比赛：回收敌人，重置玩家、计数和计时器，不切换地图 */
+	UFUNCTION(BlueprintCallable, Category = Game)
+	void RestartMatch();
+
+	/** 连续软重置测试：每场运行MatchSeconds秒、制造一些得分和死亡后重置并检查，共NumRestarts次 */
+	void StartRestartTest(int32 NumRestarts, float MatchSeconds);
+
 	/** 玩家死亡处理 */
 	UFUNCTION(BlueprintCallable, Category = Game)
 	void OnPlayerDeath(AFirstPersonDemoCharacter* DeadPlayer);
@@ -73,31 +83,44 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Game)
 	void OnEnemyDeath(AEnemyAICharacter* DeadEnemy);
 
-	/** 生成敌人 */
+	/** 波次导演的生成队列清空时调用：舍弃的生成请求不会产生敌人死亡，需要在这里检查波次是否结束 */
+	void OnSpawnQueueDrained();
+
+	/** 在随机生成点生成一个敌人，失败时返回nullptr */
 	UFUNCTION(BlueprintCallable, Category = Game)
-	void SpawnEnemy();
+	AEnemyAICharacter* SpawnEnemy();
 
-	/** 生成多组敌人波次 */
+	/** 生成一波敌人（交给波次导演排队生成） */
 	UFUNCTION(BlueprintCallable, Category = Game)
 	void SpawnEnemyWave(int32 WaveNumber);
 
+	/** 选择玩家出生点 */
+	FVector ChoosePlayerStart(AFirstPersonDemoCharacter* Player);
+
+	/** 生成服务器端玩家机器人 */
+	UFUNCTION(BlueprintCallable, Category = Game)
+	void SpawnPlayerBots(int32 Count);
+
 	/** 获取当前游戏状态 */
 	UFUNCTION(BlueprintPure, Category = Game)
 	EGameState GetGameState() const { return CurrentGameState; }
 
-	/** 获取剩余时间 */
+	/** 获取剩余时间（由GameState的比赛时钟推算） */
 	UFUNCTION(BlueprintPure, Category = Game)
-	float GetRemainingTime() const { return RemainingTime; }
+	float GetRemainingTime() const;
 
 	/** 获取当前波次 */
 	UFUNCTION(BlueprintPure, Category = Game)
 	int32 GetCurrentWave() const { return CurrentWave; }
 
-	/** 获取最高分玩家 */
+	/** 获取最高分玩家（维护的最高分，O(1)） */
 	UFUNCTION(BlueprintPure, Category = Game)
 	AFirstPersonDemoCharacter* GetHighestScoringPlayer() const;
 
-	/** 检查胜利条件 */
+	/** 玩家得分或击杀数变化：更新最高分并评估胜利条件 */
+	void NotifyPlayerStatsChanged(AFirstPersonDemoCharacter* Player);
+
+	/** 完整检查一次胜利条件（比赛中由事件驱动，无需调用） */
 	UFUNCTION(BlueprintCallable, Category = Game)
 	void CheckVictoryCondition();
 
@@ -114,8 +137,8 @@ public:
 	FOnGameWinner OnGameWinnerDelegate;
 
 protected:
-	/** 游戏状态 */
-	UPROPERTY(ReplicatedUsing=OnRep_GameState, VisibleAnywhere, BlueprintReadOnly, Category = Game)
+	/** 游戏状态（GameMode只存在于服务器，客户端通过GameState获取） */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Game)
 	EGameState CurrentGameState;
 
 	/** 胜利条件 */
@@ -134,12 +157,8 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Game)
 	float GameTimeLimit;
 
-	/** 剩余时间 */
-	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
-	float RemainingTime;
-
 	/** 当前波次 */
-	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Game)
 	int32 CurrentWave;
 
 	/** 最大波次 */
@@ -174,10 +193,20 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Game)
 	float WaveInterval;
 
+	/** 开局生成的玩家机器人数量（命令行 -bots=N 覆盖） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Game)
+	int32 NumPlayerBots;
+
+	/** 玩家机器人控制器类型 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Game)
+	TSubclassOf<APlayerBotController> PlayerBotClass;
+
 private:
-	/** 网络：游戏状态复制回调 */
-	UFUNCTION()
-	void OnRep_GameState();
+	/** 切换游戏状态并同步到GameState */
+	void SetGameState(EGameState NewState);
+
+	/** 获取GameState */
+	AFirstPersonDemoGameState* GetDemoGameState() const;
 
 	/** 更新玩家得分 */
 	void UpdatePlayerScores();
@@ -185,12 +214,32 @@ private:
 	/** 生成下一波敌人 */
 	void SpawnNextWave();
 
-	/** 选择玩家出生点 */
-	FVector ChoosePlayerStart(AFirstPersonDemoCharacter* Player);
+	/** 场上和生成队列中都没有敌人时结束当前波次，并安排下一波 */
+	void CheckWaveCleared();
+
+	/** 执行评估器的结果 */
+	void ApplyVictoryDecision(const FVictoryDecision& Decision);
+
+	/** 重新扫描所有玩家得到最高分（领先者分数下降或离开时） */
+	void RefreshHighestScorer();
+
+	/** 把玩家的分数写入GameState的排行榜（DeathDelta为新增的死亡数） */
+	void PublishPlayerScore(AFirstPersonDemoCharacter* Player, int32 DeathDelta);
+
+	/** 软重置测试的一轮：制造比赛状态并重置，下一帧检查 */
+	void TickRestartTest();
+
+	/** 软重置测试：重置后的下一帧检查并记录本轮结果 */
+	void FinishRestartTestRound();
+
+	/** 检查软重置后是否回到新比赛的初始状态（重置后的下一帧调用，上一场遗留的伤害已经结算），失败时给出原因 */
+	bool VerifyMatchReset(FString& OutError) const;
+
+	/** 检查射弹、即时命中批处理和伤害队列是否已清空（重置的同一帧调用），失败时给出原因 */
+	bool VerifyCombatCleared(FString& OutError) const;
 
 	/** 计时器句柄 */
 	FTimerHandle GameTimerHandle;
-	FTimerHandle EnemySpawnTimerHandle;
 	FTimerHandle RespawnTimerHandle;
 	FTimerHandle WaveTimerHandle;
 
@@ -199,4 +248,39 @@ private:
 
 	/** 已生成的敌人 */
 	TArray<TWeakObjectPtr<AEnemyAICharacter>> SpawnedEnemies;
+
+	/** 影响图尚无结果时轮询的下一个出生点 */
+	int32 NextPlayerStartIndex = 0;
+
+	/** 已生成的玩家机器人 */
+	TArray<TWeakObjectPtr<APlayerBotController>> PlayerBots;
+
+	/** 当前胜利条件的评估器（开始游戏时创建） */
+	TSharedPtr<FVictoryEvaluator> VictoryEvaluator;
+
+	/** 当前最高分玩家及其分数 */
+	TWeakObjectPtr<AFirstPersonDemoCharacter> HighestScorer;
+	int32 HighestScore = -1;
+
+	/** 比赛编号（软重置时递增，上一场遗留的重生计时器据此失效） */
+	int32 MatchNumber = 0;
+
+	/** 软重置测试状态 */
+	struct FRestartTest
+	{
+		int32 NumRemaining = 0;
+		int32 NumRestarts = 0;
+		int32 NumFailed = 0;
+		double TotalMs = 0.0;
+		double MaxMs = 0.0;
+
+		/** 已重置、等待下一帧检查的一轮 */
+		bool bAwaitingVerify = false;
+		double RoundMs = 0.0;
+		int32 RoundNumEnemies = 0;
+		FString RoundError;
+	};
+
+	FRestartTest RestartTest;
+	FTimerHandle RestartTestTimerHandle;
 };
@@ -2,7 +2,9 @@
 
 #include "FirstPersonDemoGameState.h"
 #include "Net/UnrealNetwork.h"
-#include "Algo/Sort.h"
+#include "GameFramework/PlayerState.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDemoGameState, Log, All);
 
 AFirstPersonDemoGameState::AFirstPersonDemoGameState()
 {
@@ -12,7 +14,11 @@ AFirstPersonDemoGameState::AFirstPersonDemoGameState()
 	// 初始化状态
 	CurrentMatchState = EMatchState::Waiting;
 	CurrentWave = 0;
-	RemainingTime = 0.0f;
+	MatchStartServerTime = 0.0f;
+	MatchEndServerTime = 0.0f;
+	MatchDuration = 0.0f;
+	NextWaveServerTime = 0.0f;
+	bPlayerScoresChanged = false;
 }
 
 void AFirstPersonDemoGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -21,66 +27,286 @@ void AFirstPersonDemoGameState::GetLifetimeReplicatedProps(TArray<FLifetimePrope
 
 	DOREPLIFETIME(AFirstPersonDemoGameState, CurrentMatchState);
 	DOREPLIFETIME(AFirstPersonDemoGameState, CurrentWave);
-	DOREPLIFETIME(AFirstPersonDemoGameState, RemainingTime);
+	DOREPLIFETIME(AFirstPersonDemoGameState, MatchStartServerTime);
+	DOREPLIFETIME(AFirstPersonDemoGameState, MatchEndServerTime);
+	DOREPLIFETIME(AFirstPersonDemoGameState, MatchDuration);
+	DOREPLIFETIME(AFirstPersonDemoGameState, NextWaveServerTime);
 	DOREPLIFETIME(AFirstPersonDemoGameState, PlayerScores);
 }
 
+void AFirstPersonDemoGameState::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	static const FName NAME_PlayerScores(TEXT("PlayerScores"));
+	static const FName NAME_CurrentMatchState(TEXT("CurrentMatchState"));
+	static const FName NAME_CurrentWave(TEXT("CurrentWave"));
+	static const FName NAME_MatchStartServerTime(TEXT("MatchStartServerTime"));
+	static const FName NAME_MatchEndServerTime(TEXT("MatchEndServerTime"));
+	static const FName NAME_MatchDuration(TEXT("MatchDuration"));
+	static const FName NAME_NextWaveServerTime(TEXT("NextWaveServerTime"));
+
+	AccountedProperties.Track(this, NAME_CurrentMatchState, static_cast<uint8>(CurrentMatchState));
+	AccountedProperties.Track(this, NAME_CurrentWave, CurrentWave);
+	AccountedProperties.Track(this, NAME_MatchStartServerTime, MatchStartServerTime);
+	AccountedProperties.Track(this, NAME_MatchEndServerTime, MatchEndServerTime);
+	AccountedProperties.Track(this, NAME_MatchDuration, MatchDuration);
+	AccountedProperties.Track(this, NAME_NextWaveServerTime, NextWaveServerTime);
+
+	if (bPlayerScoresChanged)
+	{
+		bPlayerScoresChanged = false;
+
+		// 按整个数组估算：玩家ID + 名字字符串 + 三个整数
+		uint32 Bits = 32;
+		for (const FPlayerScoreData& ScoreData : PlayerScores)
+		{
+			Bits += (ScoreData.PlayerName.Len() + 1 + 4) * 8 + 4 * 32;
+		}
+		NetBandwidth::RecordPropertyChange(this, NAME_PlayerScores, Bits);
+	}
+}
+
+float AFirstPersonDemoGameState::GetRemainingTime() const
+{
+	if (!HasTimeLimit())
+	{
+		return 0.0f;
+	}
+
+	return FMath::Max(MatchDuration - GetElapsedTime(), 0.0f);
+}
+
+float AFirstPersonDemoGameState::GetElapsedTime() const
+{
+	if (CurrentMatchState == EMatchState::Waiting)
+	{
+		return 0.0f;
+	}
+
+	// 客户端使用同步后的服务器时间推算，无需每帧复制；比赛结束后停在结束时刻
+	const float Now = (MatchEndServerTime > 0.0f) ? MatchEndServerTime : GetServerWorldTimeSeconds();
+	return FMath::Max(Now - MatchStartServerTime, 0.0f);
+}
+
+float AFirstPersonDemoGameState::GetNextWaveCountdown() const
+{
+	if (NextWaveServerTime <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	return FMath::Max(NextWaveServerTime - GetServerWorldTimeSeconds(), 0.0f);
+}
+
+void AFirstPersonDemoGameState::IncrementWave()
+{
+	if (HasAuthority())
+	{
+		CurrentWave++;
+	}
+}
+
+void AFirstPersonDemoGameState::SetCurrentWave(int32 NewWave)
+{
+	if (HasAuthority())
+	{
+		CurrentWave = NewWave;
+	}
+}
+
+void AFirstPersonDemoGameState::StartMatchClock(float Duration)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	MatchStartServerTime = GetServerWorldTimeSeconds();
+	MatchEndServerTime = 0.0f;
+	MatchDuration = Duration;
+}
+
+void AFirstPersonDemoGameState::SetNextWaveServerTime(float ServerTime)
+{
+	if (HasAuthority())
+	{
+		NextWaveServerTime = ServerTime;
+	}
+}
+
+void AFirstPersonDemoGameState::ResetMatch()
+{
+	CurrentWave = 0;
+	MatchStartServerTime = 0.0f;
+	MatchEndServerTime = 0.0f;
+	MatchDuration = 0.0f;
+	NextWaveServerTime = 0.0f;
+
+	// 客户端收到空列表时按人数不一致重建排行榜
+	PlayerScores.Reset();
+	PlayerScoreIndices.Reset();
+	Leaderboard.Reset();
+	bPlayerScoresChanged = true;
+}
+
 FPlayerScoreData AFirstPersonDemoGameState::GetLeadingPlayer() const
 {
-	if (SortedPlayerScores.Num() > 0)
+	if (const FPlayerScoreData* ScoreData = FindPlayerScore(Leaderboard.GetLeader()))
 	{
-		return SortedPlayerScores[0];
+		return *ScoreData;
 	}
 
 	return FPlayerScoreData();
 }
 
+int32 AFirstPersonDemoGameState::GetPlayerRank(int32 PlayerId) const
+{
+	return Leaderboard.GetRank(PlayerId) + 1;
+}
+
+TArray<FPlayerScoreData> AFirstPersonDemoGameState::GetTopPlayers(int32 Count) const
+{
+	TArray<int32> PlayerIds;
+	Leaderboard.GetTopPlayers(Count, PlayerIds);
+
+	TArray<FPlayerScoreData> TopPlayers;
+	TopPlayers.Reserve(PlayerIds.Num());
+	for (int32 PlayerId : PlayerIds)
+	{
+		// 客户端排行榜与分数列表可能短暂不一致，跳过找不到的条目
+		if (const FPlayerScoreData* ScoreData = FindPlayerScore(PlayerId))
+		{
+			TopPlayers.Add(*ScoreData);
+		}
+	}
+	return TopPlayers;
+}
+
+const FPlayerScoreData* AFirstPersonDemoGameState::FindPlayerScore(int32 PlayerId) const
+{
+	const int32* Index = PlayerScoreIndices.Find(PlayerId);
+	return Index ? &PlayerScores[*Index] : nullptr;
+}
+
+void AFirstPersonDemoGameState::UpdatePlayerScoreById(int32 PlayerId, const FString& PlayerName, int32 Score, int32 Kills, int32 Deaths)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// 按玩家ID查找，不存在时添加
+	const int32* ExistingIndex = PlayerScoreIndices.Find(PlayerId);
+	FPlayerScoreData& ScoreData = ExistingIndex ? PlayerScores[*ExistingIndex] : PlayerScores.AddDefaulted_GetRef();
+	if (!ExistingIndex)
+	{
+		PlayerScoreIndices.Add(PlayerId, PlayerScores.Num() - 1);
+		ScoreData.PlayerId = PlayerId;
+	}
+
+	ScoreData.PlayerName = PlayerName;
+	ScoreData.Score = Score;
+	ScoreData.KillCount = Kills;
+	ScoreData.DeathCount = Deaths;
+	bPlayerScoresChanged = true;
+
+	Leaderboard.Update(PlayerId, Score);
+}
+
 void AFirstPersonDemoGameState::UpdatePlayerScore(const FString& PlayerName, int32 Score, int32 Kills, int32 Deaths)
 {
-	// 查找现有玩家分数
-	for (FPlayerScoreData& ScoreData : PlayerScores)
+	if (!HasAuthority())
 	{
-		if (ScoreData.PlayerName == PlayerName)
+		return;
+	}
+
+	// 旧接口按名字定位：先找同名玩家状态，再找已有的同名分数条目
+	for (const APlayerState* PlayerState : PlayerArray)
+	{
+		if (PlayerState && PlayerState->GetPlayerName() == PlayerName)
 		{
-			ScoreData.Score = Score;
-			ScoreData.KillCount = Kills;
-			ScoreData.DeathCount = Deaths;
-			SortPlayerScores();
+			UpdatePlayerScoreById(PlayerState->GetPlayerId(), PlayerName, Score, Kills, Deaths);
 			return;
 		}
 	}
 
-	// 添加新玩家分数
-	FPlayerScoreData NewScoreData;
-	NewScoreData.PlayerName = PlayerName;
-	NewScoreData.Score = Score;
-	NewScoreData.KillCount = Kills;
-	NewScoreData.DeathCount = Deaths;
+	for (const FPlayerScoreData& ScoreData : PlayerScores)
+	{
+		if (ScoreData.PlayerName == PlayerName)
+		{
+			UpdatePlayerScoreById(ScoreData.PlayerId, PlayerName, Score, Kills, Deaths);
+			return;
+		}
+	}
 
-	PlayerScores.Add(NewScoreData);
-	SortPlayerScores();
+	UE_LOG(LogDemoGameState, Warning, TEXT("UpdatePlayerScore: no player named %s, use UpdatePlayerScoreById"), *PlayerName);
 }
 
-void AFirstPersonDemoGameState::SetMatchState(EMatchState NewState)
+void AFirstPersonDemoGameState::RemovePlayerScore(int32 PlayerId)
 {
-	if (CurrentMatchState != NewState)
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	int32 Index = INDEX_NONE;
+	if (!PlayerScoreIndices.RemoveAndCopyValue(PlayerId, Index))
+	{
+		return;
+	}
+
+	// 交换删除，修正被移到该位置的玩家的下标
+	PlayerScores.RemoveAtSwap(Index);
+	if (PlayerScores.IsValidIndex(Index))
 	{
-		CurrentMatchState = NewState;
-		OnRep_MatchState();
+		PlayerScoreIndices.Add(PlayerScores[Index].PlayerId, Index);
 	}
+	bPlayerScoresChanged = true;
+
+	Leaderboard.Remove(PlayerId);
 }
 
-void AFirstPersonDemoGameState::OnRep_MatchState()
+void AFirstPersonDemoGameState::OnRep_PlayerScores()
 {
-	// 匹配状态变化时的处理
+	// 分数未变的玩家在索引中是O(1)的空操作，只有变化的玩家重新插入
+	for (int32 Index = 0; Index < PlayerScores.Num(); ++Index)
+	{
+		PlayerScoreIndices.Add(PlayerScores[Index].PlayerId, Index);
+		Leaderboard.Update(PlayerScores[Index].PlayerId, PlayerScores[Index].Score);
+	}
+
+	// 有玩家离开时重建
+	if (Leaderboard.Num() != PlayerScores.Num())
+	{
+		PlayerScoreIndices.Reset();
+		Leaderboard.Reset();
+		for (int32 Index = 0; Index < PlayerScores.Num(); ++Index)
+		{
+			PlayerScoreIndices.Add(PlayerScores[Index].PlayerId, Index);
+			Leaderboard.Update(PlayerScores[Index].PlayerId, PlayerScores[Index].Score);
+		}
+	}
 }
 
-void AFirstPersonDemoGameState::SortPlayerScores()
+void AFirstPersonDemoGameState::SetMatchState(EMatchState NewState)
 {
-	// 按分数降序排序
-	SortedPlayerScores = PlayerScores;
-	SortedPlayerScores.Sort([](const FPlayerScoreData& A, const FPlayerScoreData& B)
+	if (!HasAuthority() || CurrentMatchState == NewState)
+	{
+		return;
+	}
+
+	// 比赛结束时冻结已进行时间和剩余时间
+	if (NewState == EMatchState::Finished && MatchEndServerTime <= 0.0f)
 	{
-		return A.Score > B.Score;
-	});
+		MatchEndServerTime = GetServerWorldTimeSeconds();
+	}
+
+	CurrentMatchState = NewState;
+	OnRep_MatchState();
+}
+
+void AFirstPersonDemoGameState::OnRep_MatchState()
+{
+	// 匹配状态变化时的处理
 }
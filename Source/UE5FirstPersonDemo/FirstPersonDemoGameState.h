@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameStateBase.h"
+#include "ScoreLeaderboard.h"
+#include "EnemySnapshotBuffer.h"
+#include "NetBandwidthStats.h"
 #include "FirstPersonDemoGameState.generated.h"
 
 UENUM(BlueprintType)
@@ -24,6 +27,9 @@ struct FPlayerScoreData
 {
 	GENERATED_BODY()
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PlayerId;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FString PlayerName;
 
@@ -37,7 +43,8 @@ struct FPlayerScoreData
 	int32 DeathCount;
 
 	FPlayerScoreData()
-		: PlayerName(TEXT(""))
+		: PlayerId(INDEX_NONE)
+		, PlayerName(TEXT(""))
 		, Score(0)
 		, KillCount(0)
 		, DeathCount(0)
@@ -58,6 +65,9 @@ public:
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/** 网络：统计属性变化的带宽 */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
 	/** 获取当前匹配状态 */
 	UFUNCTION(BlueprintPure, Category = Game)
 	EMatchState GetMatchState() const { return CurrentMatchState; }
@@ -66,29 +76,81 @@ public:
 	UFUNCTION(BlueprintPure, Category = Game)
 	int32 GetCurrentWave() const { return CurrentWave; }
 
-	/** 获取剩余时间 */
+	/** 获取剩余时间（由服务器开始时间戳和时长推算，无时间限制时返回0，比赛结束后停止） */
+	UFUNCTION(BlueprintPure, Category = Game)
+	float GetRemainingTime() const;
+
+	/** 获取比赛已进行时间（比赛结束后停在结束时刻） */
+	UFUNCTION(BlueprintPure, Category = Game)
+	float GetElapsedTime() const;
+
+	/** 是否有时间限制 */
+	UFUNCTION(BlueprintPure, Category = Game)
+	bool HasTimeLimit() const { return MatchDuration > 0.0f; }
+
+	/** 获取下一波倒计时（没有待开始的波次时返回0） */
 	UFUNCTION(BlueprintPure, Category = Game)
-	float GetRemainingTime() const { return RemainingTime; }
+	float GetNextWaveCountdown() const;
 
 	/** 获取玩家分数列表 */
 	UFUNCTION(BlueprintPure, Category = Game)
 	TArray<FPlayerScoreData> GetPlayerScores() const { return PlayerScores; }
 
-	/** 获取领先玩家 */
+	/** 获取领先玩家（O(1)） */
 	UFUNCTION(BlueprintPure, Category = Game)
 	FPlayerScoreData GetLeadingPlayer() const;
 
-	/** 更新玩家分数 */
-	UFUNCTION(BlueprintCallable, Category = Game)
+	/** 获取玩家排名（从1开始，不在榜上时返回0） */
+	UFUNCTION(BlueprintPure, Category = Game)
+	int32 GetPlayerRank(int32 PlayerId) const;
+
+	/** 获取前Count名玩家（按名次） */
+	UFUNCTION(BlueprintPure, Category = Game)
+	TArray<FPlayerScoreData> GetTopPlayers(int32 Count) const;
+
+	/** 按玩家ID查找分数 */
+	const FPlayerScoreData* FindPlayerScore(int32 PlayerId) const;
+
+	/** 服务器：更新玩家分数（按玩家ID，不存在时添加） */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void UpdatePlayerScoreById(int32 PlayerId, const FString& PlayerName, int32 Score, int32 Kills, int32 Deaths);
+
+	/** 服务器：按玩家名更新分数（旧接口，保留给已有蓝图；名字可能重复，新代码使用 UpdatePlayerScoreById） */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game, meta = (DeprecatedFunction, DeprecationMessage = "Use UpdatePlayerScoreById; player names are not unique."))
 	void UpdatePlayerScore(const FString& PlayerName, int32 Score, int32 Kills, int32 Deaths);
 
-	/** 设置匹配状态 */
-	UFUNCTION(BlueprintCallable, Category = Game)
+	/** 服务器：移除玩家分数 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void RemovePlayerScore(int32 PlayerId);
+
+	/** 服务器：设置匹配状态（进入已结束时冻结比赛时钟） */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
 	void SetMatchState(EMatchState NewState);
 
-	/** 增加当前波次 */
-	UFUNCTION(BlueprintCallable, Category = Game)
-	void IncrementWave() { CurrentWave++; }
+	/** 服务器：增加当前波次 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void IncrementWave();
+
+	/** 服务器：设置当前波次 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void SetCurrentWave(int32 NewWave);
+
+	/** 服务器：开始比赛计时（Duration <= 0 表示不限时） */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void StartMatchClock(float Duration);
+
+	/** 服务器：设置下一波开始的服务器时间（0表示没有待开始的波次） */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Game)
+	void SetNextWaveServerTime(float ServerTime);
+
+	/** 服务器：比赛软重置，清空分数列表、排行榜、波次和比赛时钟 */
+	void ResetMatch();
+
+	/** 客户端：所有敌人和其他玩家共用的渲染时钟 */
+	FEnemyRenderClock& GetEnemyRenderClock() { return EnemyRenderClock; }
+
+	/** 客户端：远端角色（敌人和其他玩家）当前渲染的服务器时间（估计的服务器时间减去插值延迟），射击时用于服务器回溯 */
+	double GetEnemyRenderServerTime() const { return GetServerWorldTimeSeconds() - EnemyRenderClock.GetDelay(); }
 
 protected:
 	/** 当前匹配状态 */
@@ -99,23 +161,47 @@ protected:
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
 	int32 CurrentWave;
 
-	/** 剩余时间 */
+	/** 比赛开始的服务器时间 */
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
+	float MatchStartServerTime;
+
+	/** 比赛结束的服务器时间（0表示尚未结束） */
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
-	float RemainingTime;
+	float MatchEndServerTime;
 
-	/** 玩家分数列表 */
+	/** 比赛时长（<= 0 表示不限时） */
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
+	float MatchDuration;
+
+	/** 下一波开始的服务器时间 */
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Game)
+	float NextWaveServerTime;
+
+	/** 玩家分数列表（无序，名次由排行榜索引给出） */
+	UPROPERTY(ReplicatedUsing=OnRep_PlayerScores, VisibleAnywhere, BlueprintReadOnly, Category = Game)
 	TArray<FPlayerScoreData> PlayerScores;
 
-	/** 排序后的玩家分数 */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Game)
-	TArray<FPlayerScoreData> SortedPlayerScores;
+	/** 分数列表自上次复制后是否变化（带宽统计用） */
+	bool bPlayerScoresChanged;
+
+	/** 带宽统计：其他复制属性的变化追踪 */
+	NetBandwidth::FPropertyTracker AccountedProperties;
 
 private:
 	/** 网络：匹配状态复制回调 */
 	UFUNCTION()
 	void OnRep_MatchState();
 
-	/** 排序玩家分数 */
-	void SortPlayerScores();
+	/** 网络：分数列表复制回调，增量更新本地的排行榜索引 */
+	UFUNCTION()
+	void OnRep_PlayerScores();
+
+	/** 玩家ID到PlayerScores下标 */
+	TMap<int32, int32> PlayerScoreIndices;
+
+	/** 排行榜索引 */
+	FScoreLeaderboard Leaderboard;
+
+	/** 敌人渲染时钟（只在客户端更新） */
+	FEnemyRenderClock EnemyRenderClock;
 };
@@ -0,0 +1,23 @@
+// FirstPersonDemoPlayerController.cpp - 玩家控制器实现
+
+#include "FirstPersonDemoPlayerController.h"
+
+AFirstPersonDemoPlayerController::AFirstPersonDemoPlayerController()
+{
+}
+
+void AFirstPersonDemoPlayerController::ClientReceiveCosmeticEvents_Implementation(const FCosmeticEventBatch& Batch)
+{
+	for (const FCosmeticEvent& Event : Batch.Events)
+	{
+		UCosmeticEventSubsystem::PlayEvent(GetWorld(), Event);
+	}
+}
+
+void AFirstPersonDemoPlayerController::ClientReceiveProjectileSpawns_Implementation(const FProjectileSpawnBatch& Batch)
+{
+	if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+	{
+		Projectiles->ReceiveSpawns(Batch);
+	}
+}
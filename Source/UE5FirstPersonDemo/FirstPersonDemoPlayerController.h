@@ -0,0 +1,29 @@
+// FirstPersonDemoPlayerController.h - 玩家控制器，承载每个连接专属的网络通道
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "CosmeticEventSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "FirstPersonDemoPlayerController.generated.h"
+
+/**
+ * 玩家控制器 - 接收服务器按连接合并的装饰性事件和射弹生成
+ */
+UCLASS()
+class AFirstPersonDemoPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AFirstPersonDemoPlayerController();
+
+	/** 网络：接收一个网络帧内累积的装饰性事件 */
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveCosmeticEvents(const FCosmeticEventBatch& Batch);
+
+	/** 网络：接收服务器发射的射弹生成参数 */
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveProjectileSpawns(const FProjectileSpawnBatch& Batch);
+};
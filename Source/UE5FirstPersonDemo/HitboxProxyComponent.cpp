@@ -0,0 +1,201 @@
+// HitboxProxyComponent.cpp - 命中盒代理组件实现
+
+#include "HitboxProxyComponent.h"
+#include "UE5FirstPersonDemo.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHitboxProxy, Log, All);
+
+UHitboxProxyComponent::UHitboxProxyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	HeadDamageMultiplier = 2.0f;
+	LegsDamageMultiplier = 0.75f;
+}
+
+void UHitboxProxyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* Owner = GetOwner();
+	if (!Owner || !Owner->HasAuthority())
+	{
+		return;
+	}
+
+	ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	if (!LagCompensation)
+	{
+		return;
+	}
+
+	TArray<FHitboxShape, TInlineAllocator<4>> ProxyShapes;
+	for (const FHitboxProxyShape& Source : Shapes)
+	{
+		FHitboxShape& Shape = ProxyShapes.AddDefaulted_GetRef();
+		Shape.LocalCenter = FVector3f(Source.LocalCenter);
+		Shape.Radius = Source.Radius;
+		Shape.HalfHeight = FMath::Max(Source.HalfHeight, Source.Radius);
+		Shape.Region = Source.Region;
+		Shape.DamageMultiplier = Source.DamageMultiplier;
+	}
+
+	if (ProxyShapes.Num() == 0)
+	{
+		const ACharacter* Character = Cast<ACharacter>(Owner);
+		const UCapsuleComponent* Capsule = Character ? Character->GetCapsuleComponent() : nullptr;
+		if (!Capsule)
+		{
+			return;
+		}
+
+		BuildDefaultShapes(Capsule->GetUnscaledCapsuleRadius(), Capsule->GetUnscaledCapsuleHalfHeight(), ProxyShapes);
+	}
+
+	LagCompensation->RegisterActor(Owner, ProxyShapes);
+}
+
+void UHitboxProxyComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterActor(GetOwner());
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHitboxProxyComponent::BuildDefaultShapes(float CapsuleRadius, float CapsuleHalfHeight, TArray<FHitboxShape, TInlineAllocator<4>>& OutShapes) const
+{
+	// 根节点位于胶囊中心：头部为顶端的球，躯干从头部底端向下延伸，腿部占下半段。
+	// 躯干和腿部与胶囊体同宽；躯干顶端收成半球接到头部底端，只在肩颈和头部两侧与胶囊体有空隙。
+	const float HeadRadius = FMath::Min(CapsuleRadius * 0.4f, CapsuleHalfHeight * 0.15f);
+	const float HeadBottom = CapsuleHalfHeight - HeadRadius * 2.0f;
+
+	// 腿部：胶囊底端到中心
+	FHitboxShape& Legs = OutShapes.AddDefaulted_GetRef();
+	Legs.Region = EHitboxRegion::Legs;
+	Legs.LocalCenter = FVector3f(0.0f, 0.0f, -CapsuleHalfHeight * 0.5f);
+	Legs.Radius = FMath::Min(CapsuleRadius, CapsuleHalfHeight * 0.5f);
+	Legs.HalfHeight = CapsuleHalfHeight * 0.5f;
+	Legs.DamageMultiplier = LegsDamageMultiplier;
+
+	// 躯干：从下半段中点到头部底端，与腿部重叠，重叠处按射线先碰到的表面判定部位
+	const float BodyBottom = -CapsuleHalfHeight * 0.5f;
+	const float BodyHalfHeight = (HeadBottom - BodyBottom) * 0.5f;
+
+	FHitboxShape& Body = OutShapes.AddDefaulted_GetRef();
+	Body.Region = EHitboxRegion::Body;
+	Body.LocalCenter = FVector3f(0.0f, 0.0f, BodyBottom + BodyHalfHeight);
+	Body.Radius = FMath::Min(CapsuleRadius, BodyHalfHeight);
+	Body.HalfHeight = BodyHalfHeight;
+	Body.DamageMultiplier = 1.0f;
+
+	FHitboxShape& Head = OutShapes.AddDefaulted_GetRef();
+	Head.Region = EHitboxRegion::Head;
+	Head.LocalCenter = FVector3f(0.0f, 0.0f, CapsuleHalfHeight - HeadRadius);
+	Head.Radius = HeadRadius;
+	Head.HalfHeight = HeadRadius;
+	Head.DamageMultiplier = HeadDamageMultiplier;
+}
+
+/** 控制台命令：对比旧方案（Pawn通道检测胶囊体和网格）与新方案（武器通道 + 命中盒代理）的射线开销 */
+static FAutoConsoleCommandWithWorldAndArgs GWeaponTraceBenchCommand(
+	TEXT("fpd.WeaponTraceBench"),
+	TEXT("武器射线微基准：fpd.WeaponTraceBench [射线数=10000]，输出两种方案的每条射线耗时和逐条射线的命中一致性"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ULagCompensationSubsystem* LagCompensation = World ? World->GetSubsystem<ULagCompensationSubsystem>() : nullptr;
+		if (!LagCompensation || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		const int32 NumTraces = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000, 1);
+
+		TArray<FVector> Targets;
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			Targets.Add(It->GetActorLocation());
+		}
+		if (Targets.Num() == 0)
+		{
+			UE_LOG(LogHitboxProxy, Warning, TEXT("Weapon trace benchmark needs at least one character in the level"));
+			return;
+		}
+
+		// 两种方案使用完全相同的射线
+		TArray<TPair<FVector, FVector>> Rays;
+		Rays.Reserve(NumTraces);
+		FRandomStream Random(12345);
+		for (int32 Index = 0; Index < NumTraces; ++Index)
+		{
+			const FVector& Target = Targets[Random.RandHelper(Targets.Num())];
+			const FVector Origin = Target + Random.GetUnitVector().GetSafeNormal2D() * 1500.0f + FVector(0.0f, 0.0f, 50.0f);
+			const FVector Direction = Random.VRandCone((Target - Origin).GetSafeNormal(), FMath::DegreesToRadians(3.0f));
+			Rays.Emplace(Origin, Origin + Direction * 10000.0f);
+		}
+
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(WeaponTraceBench), false);
+		const float Now = World->GetTimeSeconds();
+
+		// 旧方案：Pawn通道，检测所有角色的胶囊体和网格
+		int32 OldHits = 0;
+		TBitArray<> OldHitRays(false, NumTraces);
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 RayIndex = 0; RayIndex < Rays.Num(); ++RayIndex)
+		{
+			const TPair<FVector, FVector>& Ray = Rays[RayIndex];
+			FHitResult HitResult;
+			if (World->LineTraceSingleByChannel(HitResult, Ray.Key, Ray.Value, ECC_Pawn, Params) && Cast<ACharacter>(HitResult.GetActor()))
+			{
+				++OldHits;
+				OldHitRays[RayIndex] = true;
+			}
+		}
+		const double OldSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// 新方案：武器通道只检测环境简化碰撞，角色由命中盒代理解析求交
+		int32 NewHits = 0;
+		int32 HeadHits = 0;
+		TBitArray<> NewHitRays(false, NumTraces);
+		StartTime = FPlatformTime::Seconds();
+		for (int32 RayIndex = 0; RayIndex < Rays.Num(); ++RayIndex)
+		{
+			const TPair<FVector, FVector>& Ray = Rays[RayIndex];
+			FHitResult HitResult;
+			const float BlockingDistance = World->LineTraceSingleByChannel(HitResult, Ray.Key, Ray.Value, TraceChannel_Weapon, Params)
+				? HitResult.Distance
+				: TNumericLimits<float>::Max();
+
+			FLagCompensatedHit ProxyHit;
+			if (LagCompensation->TraceRewound(Ray.Key, Ray.Value, Now, nullptr, ProxyHit) && ProxyHit.Distance <= BlockingDistance)
+			{
+				++NewHits;
+				HeadHits += ProxyHit.Region == EHitboxRegion::Head ? 1 : 0;
+				NewHitRays[RayIndex] = true;
+			}
+		}
+		const double NewSeconds = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogHitboxProxy, Display, TEXT("Weapon trace benchmark: %d rays, %d characters"), NumTraces, Targets.Num());
+		UE_LOG(LogHitboxProxy, Display, TEXT("  Pawn channel (capsule + mesh): %.3f us/trace, %d character hits"),
+			OldSeconds * 1e6 / NumTraces, OldHits);
+		UE_LOG(LogHitboxProxy, Display, TEXT("  Weapon channel + hitbox proxies: %.3f us/trace, %d character hits (%d head)"),
+			NewSeconds * 1e6 / NumTraces, NewHits, HeadHits);
+
+		// 逐条射线对比命中/未命中：代理只在肩颈和头部两侧的空隙与胶囊体不一致
+		int32 OldOnly = 0;
+		int32 NewOnly = 0;
+		for (int32 RayIndex = 0; RayIndex < NumTraces; ++RayIndex)
+		{
+			OldOnly += (OldHitRays[RayIndex] && !NewHitRays[RayIndex]) ? 1 : 0;
+			NewOnly += (!OldHitRays[RayIndex] && NewHitRays[RayIndex]) ? 1 : 0;
+		}
+		UE_LOG(LogHitboxProxy, Display, TEXT("  Hit/miss agreement: %.1f%%, capsule-only hits %d, proxy-only hits %d"),
+			100.0 * (NumTraces - OldOnly - NewOnly) / NumTraces, OldOnly, NewOnly);
+	}));
@@ -0,0 +1,67 @@
+// HitboxProxyComponent.h - 命中盒代理组件：每个角色几个竖直胶囊（头、躯干、腿），注册到延迟补偿历史中参与武器判定
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LagCompensationSubsystem.h"
+#include "HitboxProxyComponent.generated.h"
+
+/**
+ * 单个命中盒代理形状（角色局部空间，相对根节点）
+ */
+USTRUCT(BlueprintType)
+struct FHitboxProxyShape
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	EHitboxRegion Region = EHitboxRegion::Body;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	FVector LocalCenter = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	float Radius = 0.0f;
+
+	/** 胶囊半高（包含半球部分，等于半径时为球体） */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	float HalfHeight = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	float DamageMultiplier = 1.0f;
+};
+
+/**
+ * 命中盒代理组件
+ *
+ * 武器射线不再检测角色的胶囊体和网格（它们忽略武器通道），而是由延迟补偿子系统
+ * 对这些代理胶囊做解析求交。未配置形状时按角色胶囊体尺寸生成头、躯干、腿三段。
+ * 只在服务器注册。
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class UHitboxProxyComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHitboxProxyComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** 代理形状（为空时按胶囊体生成默认形状） */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	TArray<FHitboxProxyShape> Shapes;
+
+	/** 默认形状的伤害倍率 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	float HeadDamageMultiplier;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	float LegsDamageMultiplier;
+
+private:
+	/** 按胶囊体尺寸生成头、躯干、腿三段 */
+	void BuildDefaultShapes(float CapsuleRadius, float CapsuleHalfHeight, TArray<FHitboxShape, TInlineAllocator<4>>& OutShapes) const;
+};
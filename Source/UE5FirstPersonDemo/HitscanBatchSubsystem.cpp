@@ -0,0 +1,268 @@
+// HitscanBatchSubsystem.cpp - 即时命中批处理实现
+
+#include "HitscanBatchSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "LagCompensationSubsystem.h"
+#include "GameFramework/Character.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHitscan, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan Dispatch"), STAT_HitscanDispatch, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Hitscan Resolve"), STAT_HitscanResolve, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots"), STAT_HitscanShots, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Hits"), STAT_HitscanHits, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Headshots"), STAT_HitscanHeadshots, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Sync Fallbacks"), STAT_HitscanSyncFallbacks, STATGROUP_FirstPersonDemo);
+
+namespace HitscanBatch
+{
+	/** 场景遮挡走武器通道（只有环境的简化碰撞阻挡），角色由命中盒代理判定 */
+	FCollisionQueryParams MakeQueryParams(const FHitscanShot& Shot)
+	{
+		static const FName NAME_HitscanBatch(TEXT("HitscanBatch"));
+
+		FCollisionQueryParams Params(NAME_HitscanBatch, false);
+		Params.AddIgnoredActor(Shot.Shooter.Get());
+		return Params;
+	}
+}
+
+void UHitscanBatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	if (Benchmark.bActive)
+	{
+		TickBenchmark(DeltaTime);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// 先结算上一帧的射线（结果已在帧末由物理线程完成），再发出本帧的射线
+	ResolveInFlightShots();
+	DispatchPendingShots();
+
+	if (Benchmark.bActive)
+	{
+		Benchmark.GameThreadSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+}
+
+TStatId UHitscanBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanBatchSubsystem, STATGROUP_Tickables);
+}
+
+int32 UHitscanBatchSubsystem::ClearShots()
+{
+	// 已发出的异步射线结果不再取回
+	const int32 NumCleared = PendingShots.Num() + InFlightShots.Num();
+	PendingShots.Reset();
+	InFlightShots.Reset();
+	return NumCleared;
+}
+
+void UHitscanBatchSubsystem::QueueShot(AFirstPersonDemoCharacter* Shooter, const FVector& Origin, const FVector& Direction, float RewindTime, float Damage)
+{
+	FHitscanShot& Shot = PendingShots.AddDefaulted_GetRef();
+	Shot.Shooter = Shooter;
+	Shot.Start = Origin;
+	Shot.End = Origin + Direction * TraceRange;
+	Shot.RewindTime = RewindTime;
+	Shot.Damage = Damage;
+
+	INC_DWORD_STAT(STAT_HitscanShots);
+}
+
+void UHitscanBatchSubsystem::DispatchPendingShots()
+{
+	if (PendingShots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HitscanDispatch);
+
+	UWorld* World = GetWorld();
+
+	// 基准测试的同步对照：逐发同步射线，立即结算
+	if (Benchmark.bActive && Benchmark.bSynchronous)
+	{
+		for (const FHitscanShot& Shot : PendingShots)
+		{
+			FHitResult HitResult;
+			const float BlockingDistance = World->LineTraceSingleByChannel(HitResult, Shot.Start, Shot.End, TraceChannel_Weapon, HitscanBatch::MakeQueryParams(Shot))
+				? HitResult.Distance
+				: TraceRange;
+			ResolveShot(Shot, BlockingDistance);
+		}
+		PendingShots.Reset();
+		return;
+	}
+
+	for (FHitscanShot& Shot : PendingShots)
+	{
+		Shot.TraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.Start, Shot.End,
+			TraceChannel_Weapon, HitscanBatch::MakeQueryParams(Shot));
+	}
+
+	InFlightShots.Append(MoveTemp(PendingShots));
+	PendingShots.Reset();
+}
+
+void UHitscanBatchSubsystem::ResolveInFlightShots()
+{
+	if (InFlightShots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HitscanResolve);
+
+	UWorld* World = GetWorld();
+
+	FTraceDatum Datum;
+	for (const FHitscanShot& Shot : InFlightShots)
+	{
+		float BlockingDistance = TraceRange;
+
+		if (World->QueryTraceData(Shot.TraceHandle, Datum))
+		{
+			if (Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+			{
+				BlockingDistance = Datum.OutHits[0].Distance;
+			}
+		}
+		else
+		{
+			// 结果不可用（句柄已过期）时退回同步射线，保证射击不丢失
+			INC_DWORD_STAT(STAT_HitscanSyncFallbacks);
+
+			FHitResult HitResult;
+			if (World->LineTraceSingleByChannel(HitResult, Shot.Start, Shot.End, TraceChannel_Weapon, HitscanBatch::MakeQueryParams(Shot)))
+			{
+				BlockingDistance = HitResult.Distance;
+			}
+		}
+
+		ResolveShot(Shot, BlockingDistance);
+	}
+	InFlightShots.Reset();
+}
+
+void UHitscanBatchSubsystem::ResolveShot(const FHitscanShot& Shot, float BlockingDistance)
+{
+	ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	if (!LagCompensation)
+	{
+		return;
+	}
+
+	AFirstPersonDemoCharacter* Shooter = Shot.Shooter.Get();
+
+	// 回溯到开火时刻的碰撞盒
+	FLagCompensatedHit RewoundHit;
+	if (!LagCompensation->TraceRewound(Shot.Start, Shot.End, Shot.RewindTime, Shooter, RewoundHit) || RewoundHit.Distance > BlockingDistance)
+	{
+		return;
+	}
+
+	// 射击者已离开或基准测试射击：只做检测
+	if (!Shooter || Shot.Damage <= 0.0f)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_HitscanHits);
+	if (RewoundHit.Region == EHitboxRegion::Head)
+	{
+		INC_DWORD_STAT(STAT_HitscanHeadshots);
+	}
+
+	// 每次命中直接提交，同一受害者本帧的多次命中由伤害队列合并为一次TakeDamage
+	Shooter->ApplyPointDamage(RewoundHit.Actor, Shot.Damage * RewoundHit.DamageMultiplier, RewoundHit.Location);
+}
+
+void UHitscanBatchSubsystem::StartBenchmark(int32 ShotsPerSecond, float Duration, bool bSynchronous)
+{
+	Benchmark = FBenchmark();
+	Benchmark.bSynchronous = bSynchronous;
+	Benchmark.ShotsPerSecond = FMath::Max(ShotsPerSecond, 1);
+	Benchmark.Duration = FMath::Max(Duration, 1.0f);
+
+	// 以当前场景中的角色作为瞄准目标，让回溯检测也有实际工作量
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		Benchmark.Targets.Add(It->GetActorLocation());
+	}
+	if (Benchmark.Targets.Num() == 0)
+	{
+		Benchmark.Targets.Add(FVector::ZeroVector);
+	}
+
+	Benchmark.bActive = true;
+
+	UE_LOG(LogHitscan, Display, TEXT("Hitscan benchmark: %d shots/s for %.0f s (%s traces, %d targets)"),
+		Benchmark.ShotsPerSecond, Benchmark.Duration, bSynchronous ? TEXT("sync") : TEXT("async batched"), Benchmark.Targets.Num());
+}
+
+void UHitscanBatchSubsystem::TickBenchmark(float DeltaTime)
+{
+	Benchmark.Elapsed += DeltaTime;
+	if (Benchmark.Elapsed >= Benchmark.Duration)
+	{
+		const double GameThreadMs = Benchmark.GameThreadSeconds * 1000.0;
+		UE_LOG(LogHitscan, Display, TEXT("Hitscan benchmark (%s): %d shots in %.1f s, game thread %.2f ms total, %.2f ms per second, %.2f us per shot"),
+			Benchmark.bSynchronous ? TEXT("sync") : TEXT("async batched"),
+			Benchmark.NumShots, Benchmark.Elapsed, GameThreadMs,
+			GameThreadMs / Benchmark.Elapsed,
+			Benchmark.NumShots > 0 ? GameThreadMs * 1000.0 / Benchmark.NumShots : 0.0);
+
+		Benchmark.bActive = false;
+		return;
+	}
+
+	// 从目标周围随机位置向目标开火，带少量散布
+	Benchmark.ShotAccumulator += Benchmark.ShotsPerSecond * DeltaTime;
+	const int32 NumShots = FMath::FloorToInt(Benchmark.ShotAccumulator);
+	Benchmark.ShotAccumulator -= NumShots;
+
+	for (int32 Index = 0; Index < NumShots; ++Index)
+	{
+		const FVector& Target = Benchmark.Targets[FMath::RandHelper(Benchmark.Targets.Num())];
+		const FVector Origin = Target + FVector(FMath::VRand().GetSafeNormal2D() * 1500.0f) + FVector(0.0f, 0.0f, 50.0f);
+		const FVector Direction = FMath::VRandCone((Target - Origin).GetSafeNormal(), FMath::DegreesToRadians(3.0f));
+
+		QueueShot(nullptr, Origin, Direction, GetWorld()->GetTimeSeconds(), 0.0f);
+	}
+	Benchmark.NumShots += NumShots;
+}
+
+/** 控制台命令：即时命中批处理基准测试 */
+static FAutoConsoleCommandWithWorldAndArgs GHitscanBenchCommand(
+	TEXT("fpd.HitscanBench"),
+	TEXT("服务器即时命中基准测试：fpd.HitscanBench [每秒射击数=1000] [秒数=5] [sync]，结束时输出游戏线程耗时"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		if (UHitscanBatchSubsystem* Hitscan = World->GetSubsystem<UHitscanBatchSubsystem>())
+		{
+			const int32 ShotsPerSecond = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+			const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 5.0f;
+			const bool bSynchronous = Args.Num() > 2 && Args[2] == TEXT("sync");
+			Hitscan->StartBenchmark(ShotsPerSecond, Duration, bSynchronous);
+		}
+	}));
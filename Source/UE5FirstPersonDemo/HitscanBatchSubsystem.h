@@ -0,0 +1,96 @@
+// HitscanBatchSubsystem.h - 服务器按帧批量判定即时命中射击：异步射线统一发出，下一帧回溯检测并提交伤害
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "HitscanBatchSubsystem.generated.h"
+
+class AFirstPersonDemoCharacter;
+
+/**
+ * 排队中的一次射击
+ */
+struct FHitscanShot
+{
+	/** 射击者（基准测试的射击为空，不造成伤害） */
+	TWeakObjectPtr<AFirstPersonDemoCharacter> Shooter;
+
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	/** 延迟补偿回溯的服务器时间 */
+	float RewindTime = 0.0f;
+
+	float Damage = 0.0f;
+
+	/** 场景遮挡的异步射线 */
+	FTraceHandle TraceHandle;
+};
+
+/**
+ * 即时命中批处理子系统
+ *
+ * 一帧内排队的射击在子系统Tick中一次性发出武器通道的场景遮挡异步射线，由物理线程并行执行；
+ * 下一帧取回结果，再做延迟补偿回溯检测，命中提交到伤害队列（由伤害队列按受害者合并后结算一次）。
+ * 命中结算因此比射击晚一帧（约一个服务器Tick）。
+ */
+UCLASS()
+class UHitscanBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 射线长度 */
+	static constexpr float TraceRange = 10000.0f;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** 服务器：排队一次射击，RewindTime为延迟补偿回溯到的服务器时间 */
+	void QueueShot(AFirstPersonDemoCharacter* Shooter, const FVector& Origin, const FVector& Direction, float RewindTime, float Damage);
+
+	/** 排队和等待射线结果的射击数 */
+	int32 GetNumQueued() const { return PendingShots.Num() + InFlightShots.Num(); }
+
+	/** 丢弃排队和等待射线结果的射击（比赛软重置时），返回丢弃的射击数 */
+	int32 ClearShots();
+
+	/** 基准测试：每秒排队ShotsPerSecond次无伤害射击，持续Duration秒；bSynchronous为真时改用逐发同步射线作对比 */
+	void StartBenchmark(int32 ShotsPerSecond, float Duration, bool bSynchronous);
+
+private:
+	/** 取回上一帧发出的射线结果并结算 */
+	void ResolveInFlightShots();
+
+	/** 发出本帧排队射击的异步射线 */
+	void DispatchPendingShots();
+
+	/** 对单次射击做回溯检测，命中时提交伤害 */
+	void ResolveShot(const FHitscanShot& Shot, float BlockingDistance);
+
+	/** 基准测试每帧生成射击 */
+	void TickBenchmark(float DeltaTime);
+
+	/** 本帧排队、尚未发出的射击 */
+	TArray<FHitscanShot> PendingShots;
+
+	/** 上一帧已发出、等待结果的射击 */
+	TArray<FHitscanShot> InFlightShots;
+
+	/** 基准测试状态 */
+	struct FBenchmark
+	{
+		bool bActive = false;
+		bool bSynchronous = false;
+		int32 ShotsPerSecond = 0;
+		float Duration = 0.0f;
+		float Elapsed = 0.0f;
+		float ShotAccumulator = 0.0f;
+		int32 NumShots = 0;
+		double GameThreadSeconds = 0.0;
+		TArray<FVector> Targets;
+	};
+	FBenchmark Benchmark;
+};
@@ -0,0 +1,549 @@
+// LagCompensationSubsystem.cpp - 延迟补偿实现
+
+#include "LagCompensationSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/Unique.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLagCompensation, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("LagComp Record"), STAT_LagCompRecord, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("LagComp Rewind Trace"), STAT_LagCompTrace, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LagComp Shots"), STAT_LagCompShots, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LagComp Rewound Actors"), STAT_LagCompRewound, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("LagComp Broad Phase Rebuild"), STAT_LagCompBroadPhase, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LagComp Broad Phase Candidates"), STAT_LagCompCandidates, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LagComp Tracked Actors"), STAT_LagCompTracked, STATGROUP_FirstPersonDemo);
+
+static int32 GLagCompBroadPhaseGrid = 1;
+static FAutoConsoleVariableRef CVarLagCompBroadPhaseGrid(
+	TEXT("fpd.LagComp.BroadPhaseGrid"),
+	GLagCompBroadPhaseGrid,
+	TEXT("回溯射线的粗检测是否使用网格（0 = 逐个检查所有角色的历史包围盒，用于基准对比）"));
+
+namespace LagCompBroadPhase
+{
+	FIntPoint GetCell(const FVector& Location)
+	{
+		return FIntPoint(
+			FMath::FloorToInt(Location.X / ULagCompensationSubsystem::BroadPhaseCellSize),
+			FMath::FloorToInt(Location.Y / ULagCompensationSubsystem::BroadPhaseCellSize));
+	}
+
+	/** 按顺序遍历线段在水平面上经过的格子（二维DDA），最后一定到达终点所在格子 */
+	template<typename FuncType>
+	void ForEachCellOnSegment(const FVector& Start, const FVector& End, FuncType&& Func)
+	{
+		constexpr double CellSize = ULagCompensationSubsystem::BroadPhaseCellSize;
+		constexpr double Never = TNumericLimits<double>::Max();
+
+		FIntPoint Cell = GetCell(Start);
+		const FIntPoint EndCell = GetCell(End);
+		const int32 StepX = (EndCell.X >= Cell.X) ? 1 : -1;
+		const int32 StepY = (EndCell.Y >= Cell.Y) ? 1 : -1;
+		const double DeltaX = End.X - Start.X;
+		const double DeltaY = End.Y - Start.Y;
+
+		// 沿线段到达下一条格线的参数，以及每跨一格的参数增量
+		double NextX = (EndCell.X != Cell.X) ? ((Cell.X + (StepX > 0 ? 1 : 0)) * CellSize - Start.X) / DeltaX : Never;
+		double NextY = (EndCell.Y != Cell.Y) ? ((Cell.Y + (StepY > 0 ? 1 : 0)) * CellSize - Start.Y) / DeltaY : Never;
+		const double StepTX = (EndCell.X != Cell.X) ? CellSize / FMath::Abs(DeltaX) : Never;
+		const double StepTY = (EndCell.Y != Cell.Y) ? CellSize / FMath::Abs(DeltaY) : Never;
+
+		Func(Cell);
+		for (int32 NumSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y); NumSteps > 0; --NumSteps)
+		{
+			// 某一轴已到达终点格子时只走另一轴，避免浮点误差越过终点
+			const bool bStepX = Cell.X != EndCell.X && (Cell.Y == EndCell.Y || NextX < NextY);
+			if (bStepX)
+			{
+				Cell.X += StepX;
+				NextX += StepTX;
+			}
+			else
+			{
+				Cell.Y += StepY;
+				NextY += StepTY;
+			}
+			Func(Cell);
+		}
+	}
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// 只有服务器需要历史
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	TimeSinceLastRecord += DeltaTime;
+	if (TimeSinceLastRecord < RecordInterval)
+	{
+		return;
+	}
+	TimeSinceLastRecord = 0.0f;
+
+	RecordFrames(World->GetTimeSeconds());
+}
+
+void ULagCompensationSubsystem::RecordFrames(float ServerTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompRecord);
+
+	for (int32 Index = TrackedActors.Num() - 1; Index >= 0; --Index)
+	{
+		if (!TrackedActors[Index].Actor.IsValid())
+		{
+			TrackedActors.RemoveAtSwap(Index);
+			continue;
+		}
+
+		RecordFrame(TrackedActors[Index], ServerTime);
+	}
+
+	SET_DWORD_STAT(STAT_LagCompTracked, TrackedActors.Num());
+
+	// 历史包围盒每帧都在变化
+	RebuildBroadPhase();
+}
+
+void ULagCompensationSubsystem::RebuildBroadPhase() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompBroadPhase);
+
+	bBroadPhaseDirty = false;
+	BroadPhaseCells.Reset();
+	BroadPhaseEntries.Reset();
+	OversizedActors.Reset();
+
+	// 先收集（格子，角色）对并按格子排序，每个格子的角色在 BroadPhaseEntries 中连续
+	TArray<TPair<FIntPoint, int32>> CellEntries;
+	CellEntries.Reserve(TrackedActors.Num() * 2);
+	for (int32 Index = 0; Index < TrackedActors.Num(); ++Index)
+	{
+		const FBox& Bounds = TrackedActors[Index].HistoryBounds;
+		if (!Bounds.IsValid)
+		{
+			continue;
+		}
+
+		const FIntPoint MinCell = LagCompBroadPhase::GetCell(Bounds.Min);
+		const FIntPoint MaxCell = LagCompBroadPhase::GetCell(Bounds.Max);
+		if ((MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) > MaxBroadPhaseCellsPerActor)
+		{
+			OversizedActors.Add(Index);
+			continue;
+		}
+
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				CellEntries.Emplace(FIntPoint(X, Y), Index);
+			}
+		}
+	}
+
+	CellEntries.Sort([](const TPair<FIntPoint, int32>& A, const TPair<FIntPoint, int32>& B)
+	{
+		return (A.Key.X != B.Key.X) ? (A.Key.X < B.Key.X) : (A.Key.Y < B.Key.Y);
+	});
+
+	BroadPhaseEntries.Reserve(CellEntries.Num());
+	for (const TPair<FIntPoint, int32>& Entry : CellEntries)
+	{
+		FIntPoint& Range = BroadPhaseCells.FindOrAdd(Entry.Key, FIntPoint(BroadPhaseEntries.Num(), 0));
+		++Range.Y;
+		BroadPhaseEntries.Add(Entry.Value);
+	}
+}
+
+void ULagCompensationSubsystem::GatherCandidates(const FVector& Start, const FVector& End, TArray<int32, TInlineAllocator<32>>& OutCandidates) const
+{
+	OutCandidates.Reset();
+
+	if (!GLagCompBroadPhaseGrid)
+	{
+		for (int32 Index = 0; Index < TrackedActors.Num(); ++Index)
+		{
+			OutCandidates.Add(Index);
+		}
+		return;
+	}
+
+	if (bBroadPhaseDirty)
+	{
+		RebuildBroadPhase();
+	}
+
+	OutCandidates.Append(OversizedActors);
+	LagCompBroadPhase::ForEachCellOnSegment(Start, End, [this, &OutCandidates](const FIntPoint& Cell)
+	{
+		if (const FIntPoint* Range = BroadPhaseCells.Find(Cell))
+		{
+			OutCandidates.Append(&BroadPhaseEntries[Range->X], Range->Y);
+		}
+	});
+
+	// 跨多个格子的角色只检测一次
+	OutCandidates.Sort();
+	OutCandidates.SetNum(Algo::Unique(OutCandidates), false);
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (!Character)
+	{
+		return;
+	}
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+	FHitboxShape Shape;
+	Shape.Radius = Capsule->GetUnscaledCapsuleRadius();
+	Shape.HalfHeight = Capsule->GetUnscaledCapsuleHalfHeight();
+
+	RegisterActor(Character, MakeArrayView(&Shape, 1));
+}
+
+void ULagCompensationSubsystem::RegisterActor(AActor* Actor, TConstArrayView<FHitboxShape> Shapes)
+{
+	if (!Actor || Shapes.Num() == 0)
+	{
+		return;
+	}
+
+	// 已注册时只更新形状
+	FTrackedActor* Tracked = TrackedActors.FindByPredicate([Actor](const FTrackedActor& Entry)
+	{
+		return Entry.Actor.Get() == Actor;
+	});
+
+	if (!Tracked)
+	{
+		Tracked = &TrackedActors.AddDefaulted_GetRef();
+		Tracked->Actor = Actor;
+	}
+
+	bBroadPhaseDirty = true;
+
+	Tracked->Shapes.Reset();
+	Tracked->Shapes.Append(Shapes.GetData(), Shapes.Num());
+	Tracked->ShapeExtent = 0.0f;
+	for (const FHitboxShape& Shape : Shapes)
+	{
+		Tracked->ShapeExtent = FMath::Max(Tracked->ShapeExtent, Shape.LocalCenter.Size() + Shape.HalfHeight);
+	}
+
+	// 立即记录一帧，避免刚生成的角色没有历史
+	if (UWorld* World = GetWorld())
+	{
+		RecordFrame(*Tracked, World->GetTimeSeconds());
+	}
+}
+
+void ULagCompensationSubsystem::UnregisterActor(AActor* Actor)
+{
+	const int32 Index = TrackedActors.IndexOfByPredicate([Actor](const FTrackedActor& Entry)
+	{
+		return Entry.Actor.Get() == Actor;
+	});
+
+	if (Index != INDEX_NONE)
+	{
+		TrackedActors.RemoveAtSwap(Index);
+		bBroadPhaseDirty = true;
+	}
+}
+
+float ULagCompensationSubsystem::ClampRewindTime(float ClientTime) const
+{
+	const float ServerTime = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ClientTime, ServerTime - MaxRewindTime, ServerTime);
+}
+
+void ULagCompensationSubsystem::RecordFrame(FTrackedActor& Tracked, float ServerTime)
+{
+	const AActor* Actor = Tracked.Actor.Get();
+
+	FHitboxFrame& Frame = Tracked.Frames[Tracked.Head];
+	Frame.ServerTime = ServerTime;
+	Frame.Location = FVector3f(Actor->GetActorLocation());
+	Frame.PackedYaw = FRotator::CompressAxisToShort(Actor->GetActorRotation().Yaw);
+
+	const UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+	Frame.bCollisionEnabled = Root ? Root->IsCollisionEnabled() : Actor->GetActorEnableCollision();
+
+	Tracked.Head = (Tracked.Head + 1) % HistoryLength;
+	Tracked.Count = FMath::Min(Tracked.Count + 1, HistoryLength);
+
+	// 重新计算整段历史的包围盒（帧数固定，开销恒定）
+	Tracked.HistoryBounds = FBox(ForceInit);
+	for (int32 i = 0; i < Tracked.Count; ++i)
+	{
+		Tracked.HistoryBounds += FVector(Tracked.Frames[i].Location);
+	}
+	Tracked.HistoryBounds = Tracked.HistoryBounds.ExpandBy(Tracked.ShapeExtent);
+}
+
+bool ULagCompensationSubsystem::SampleFrame(const FTrackedActor& Tracked, float Time, FVector& OutLocation, float& OutYaw) const
+{
+	if (Tracked.Count == 0)
+	{
+		return false;
+	}
+
+	// 从最新帧向旧帧查找包围Time的两帧
+	const int32 Newest = (Tracked.Head - 1 + HistoryLength) % HistoryLength;
+	const FHitboxFrame* After = &Tracked.Frames[Newest];
+	const FHitboxFrame* Before = After;
+
+	for (int32 i = 1; i < Tracked.Count && Before->ServerTime > Time; ++i)
+	{
+		After = Before;
+		Before = &Tracked.Frames[(Newest - i + HistoryLength) % HistoryLength];
+	}
+
+	// 超出历史范围时取端点
+	const FHitboxFrame& Nearest = (Time - Before->ServerTime <= After->ServerTime - Time) ? *Before : *After;
+	if (!Nearest.bCollisionEnabled)
+	{
+		return false;
+	}
+
+	const float Span = After->ServerTime - Before->ServerTime;
+	const float Alpha = (Span > KINDA_SMALL_NUMBER) ? FMath::Clamp((Time - Before->ServerTime) / Span, 0.0f, 1.0f) : 1.0f;
+
+	const float BeforeYaw = FRotator::DecompressAxisFromShort(Before->PackedYaw);
+	const float AfterYaw = FRotator::DecompressAxisFromShort(After->PackedYaw);
+
+	OutLocation = FVector(FMath::Lerp(Before->Location, After->Location, Alpha));
+	OutYaw = BeforeYaw + FMath::FindDeltaAngleDegrees(BeforeYaw, AfterYaw) * Alpha;
+	return true;
+}
+
+bool ULagCompensationSubsystem::TraceRewound(const FVector& Start, const FVector& End, float RewindTime,
+	const AActor* IgnoreActor, FLagCompensatedHit& OutHit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompTrace);
+	INC_DWORD_STAT(STAT_LagCompShots);
+
+	const FVector StartToEnd = End - Start;
+	bool bHit = false;
+	OutHit = FLagCompensatedHit();
+	OutHit.Distance = StartToEnd.Size();
+
+	// 粗检测：射线经过的格子中的角色，再检查射线与整段历史包围盒
+	TArray<int32, TInlineAllocator<32>> Candidates;
+	GatherCandidates(Start, End, Candidates);
+	INC_DWORD_STAT_BY(STAT_LagCompCandidates, Candidates.Num());
+
+	for (int32 CandidateIndex : Candidates)
+	{
+		const FTrackedActor& Tracked = TrackedActors[CandidateIndex];
+		AActor* Actor = Tracked.Actor.Get();
+		if (!Actor || Actor == IgnoreActor)
+		{
+			continue;
+		}
+
+		if (!FMath::LineBoxIntersection(Tracked.HistoryBounds, Start, End, StartToEnd))
+		{
+			continue;
+		}
+
+		// 只回溯通过粗检测的角色
+		FVector Location;
+		float Yaw;
+		if (!SampleFrame(Tracked, RewindTime, Location, Yaw))
+		{
+			continue;
+		}
+		INC_DWORD_STAT(STAT_LagCompRewound);
+
+		const FRotator Rotation(0.0f, Yaw, 0.0f);
+		for (int32 ShapeIndex = 0; ShapeIndex < Tracked.Shapes.Num(); ++ShapeIndex)
+		{
+			const FHitboxShape& Shape = Tracked.Shapes[ShapeIndex];
+			const FVector Center = Location + Rotation.RotateVector(FVector(Shape.LocalCenter));
+			const FVector Axis(0.0f, 0.0f, FMath::Max(Shape.HalfHeight - Shape.Radius, 0.0f));
+
+			// 射线与胶囊轴线的最近点
+			FVector PointOnRay, PointOnAxis;
+			FMath::SegmentDistToSegmentSafe(Start, End, Center - Axis, Center + Axis, PointOnRay, PointOnAxis);
+
+			const float DistSq = FVector::DistSquared(PointOnRay, PointOnAxis);
+			if (DistSq > FMath::Square(Shape.Radius))
+			{
+				continue;
+			}
+
+			// 由最近点沿射线回退到胶囊表面
+			const float Distance = FMath::Max(FVector::Dist(Start, PointOnRay) - FMath::Sqrt(FMath::Square(Shape.Radius) - DistSq), 0.0f);
+			if (Distance < OutHit.Distance)
+			{
+				bHit = true;
+				OutHit.Actor = Actor;
+				OutHit.Distance = Distance;
+				OutHit.Location = Start + StartToEnd.GetSafeNormal() * Distance;
+				OutHit.HitboxIndex = ShapeIndex;
+				OutHit.Region = Shape.Region;
+				OutHit.DamageMultiplier = Shape.DamageMultiplier;
+			}
+		}
+	}
+
+	return bHit;
+}
+
+/** 控制台命令：每次射击的回溯检测开销基准，在独立的子系统实例中注册大量移动角色 */
+static FAutoConsoleCommandWithWorldAndArgs GLagCompBenchCommand(
+	TEXT("fpd.LagCompBench"),
+	TEXT("延迟补偿基准测试：fpd.LagCompBench [角色数=128] [射击次数=10000]，输出每次射击的回溯检测耗时"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		const int32 NumActors = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 128, 1);
+		const int32 NumShots = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000, 1);
+
+		// 独立实例：不在世界中Tick，也不影响正在使用的历史
+		ULagCompensationSubsystem* LagCompensation = NewObject<ULagCompensationSubsystem>(World);
+
+		// 与角色胶囊体（半径42，半高96）相当的躯干和头部
+		FHitboxShape Shapes[2];
+		Shapes[0].Radius = 42.0f;
+		Shapes[0].HalfHeight = 80.0f;
+		Shapes[0].LocalCenter = FVector3f(0.0f, 0.0f, -16.0f);
+		Shapes[1].Region = EHitboxRegion::Head;
+		Shapes[1].Radius = 14.0f;
+		Shapes[1].HalfHeight = 14.0f;
+		Shapes[1].LocalCenter = FVector3f(0.0f, 0.0f, 80.0f);
+		Shapes[1].DamageMultiplier = 2.0f;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// 角色散布在一片区域内，各自匀速移动，记录整段历史
+		FRandomStream Random(26);
+		TArray<AActor*> Actors;
+		TArray<FVector> StartLocations;
+		TArray<FVector> Velocities;
+		for (int32 Index = 0; Index < NumActors; ++Index)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+			USceneComponent* Root = NewObject<USceneComponent>(Actor);
+			Actor->SetRootComponent(Root);
+			Root->RegisterComponent();
+
+			Actors.Add(Actor);
+			StartLocations.Add(FVector(Random.FRandRange(-5000.0f, 5000.0f), Random.FRandRange(-5000.0f, 5000.0f), 100.0f));
+			Velocities.Add(Random.GetUnitVector().GetSafeNormal2D() * Random.FRandRange(200.0f, 600.0f));
+
+			Actor->SetActorLocation(StartLocations.Last());
+			LagCompensation->RegisterActor(Actor, Shapes);
+		}
+
+		const float StartTime = World->GetTimeSeconds();
+		for (int32 Frame = 1; Frame < ULagCompensationSubsystem::HistoryLength; ++Frame)
+		{
+			const float FrameTime = Frame * ULagCompensationSubsystem::RecordInterval;
+			for (int32 Index = 0; Index < NumActors; ++Index)
+			{
+				Actors[Index]->SetActorLocation(StartLocations[Index] + Velocities[Index] * FrameTime);
+			}
+			LagCompensation->RecordFrames(StartTime + FrameTime);
+		}
+		const float EndTime = StartTime + (ULagCompensationSubsystem::HistoryLength - 1) * ULagCompensationSubsystem::RecordInterval;
+
+		// 一半射击瞄准目标在回溯时刻的躯干中心（必须命中），一半随机方向
+		struct FShot
+		{
+			FVector Start;
+			FVector End;
+			float RewindTime;
+			bool bAimed;
+		};
+
+		TArray<FShot> Shots;
+		Shots.Reserve(NumShots);
+		for (int32 ShotIndex = 0; ShotIndex < NumShots; ++ShotIndex)
+		{
+			const int32 Target = Random.RandHelper(NumActors);
+			const float RewindTime = EndTime - Random.FRandRange(0.0f, ULagCompensationSubsystem::MaxRewindTime);
+			const FVector TargetLocation = StartLocations[Target] + Velocities[Target] * (RewindTime - StartTime);
+
+			FShot& Shot = Shots.AddDefaulted_GetRef();
+			Shot.Start = TargetLocation + Random.GetUnitVector().GetSafeNormal2D() * Random.FRandRange(500.0f, 3000.0f);
+			Shot.bAimed = ShotIndex % 2 == 0;
+			const FVector Direction = Shot.bAimed ? (TargetLocation - Shot.Start).GetSafeNormal() : Random.GetUnitVector();
+			Shot.End = Shot.Start + Direction * 10000.0f;
+			Shot.RewindTime = RewindTime;
+		}
+
+		UE_LOG(LogLagCompensation, Display, TEXT("Lag compensation benchmark: %d actors x %d frames, %d shots"),
+			NumActors, ULagCompensationSubsystem::HistoryLength, NumShots);
+
+		// 网格粗检测和逐个检查包围盒各跑一遍，命中结果必须一致
+		TArray<FLagCompensatedHit> Hits[2];
+		double TraceSeconds[2];
+		int32 NumAimedMissed = 0;
+		const int32 SavedBroadPhaseGrid = GLagCompBroadPhaseGrid;
+		for (int32 Mode = 0; Mode < 2; ++Mode)
+		{
+			GLagCompBroadPhaseGrid = (Mode == 0) ? 1 : 0;
+			Hits[Mode].SetNum(NumShots);
+
+			int32 NumHits = 0;
+			const double TraceStart = FPlatformTime::Seconds();
+			for (int32 ShotIndex = 0; ShotIndex < NumShots; ++ShotIndex)
+			{
+				const FShot& Shot = Shots[ShotIndex];
+				const bool bHit = LagCompensation->TraceRewound(Shot.Start, Shot.End, Shot.RewindTime, nullptr, Hits[Mode][ShotIndex]);
+				NumHits += bHit ? 1 : 0;
+				NumAimedMissed += (Shot.bAimed && !bHit) ? 1 : 0;
+			}
+			TraceSeconds[Mode] = FPlatformTime::Seconds() - TraceStart;
+
+			UE_LOG(LogLagCompensation, Display, TEXT("  %s: %.3f ms total, %.2f us per shot, %d hits"),
+				(Mode == 0) ? TEXT("grid broad phase") : TEXT("linear broad phase"),
+				TraceSeconds[Mode] * 1000.0, TraceSeconds[Mode] * 1000000.0 / NumShots, NumHits);
+		}
+		GLagCompBroadPhaseGrid = SavedBroadPhaseGrid;
+
+		int32 NumMismatched = 0;
+		for (int32 ShotIndex = 0; ShotIndex < NumShots; ++ShotIndex)
+		{
+			const FLagCompensatedHit& GridHit = Hits[0][ShotIndex];
+			const FLagCompensatedHit& LinearHit = Hits[1][ShotIndex];
+			NumMismatched += (GridHit.Actor != LinearHit.Actor || GridHit.HitboxIndex != LinearHit.HitboxIndex) ? 1 : 0;
+		}
+
+		UE_LOG(LogLagCompensation, Display, TEXT("  grid speedup %.1fx"), TraceSeconds[1] / FMath::Max(TraceSeconds[0], UE_SMALL_NUMBER));
+		UE_LOG(LogLagCompensation, Display, TEXT("%s aimed shots at the rewound position: %d missed"),
+			NumAimedMissed == 0 ? TEXT("PASS") : TEXT("FAIL"), NumAimedMissed);
+		UE_LOG(LogLagCompensation, Display, TEXT("%s grid and linear broad phase agree: %d mismatched"),
+			NumMismatched == 0 ? TEXT("PASS") : TEXT("FAIL"), NumMismatched);
+
+		for (AActor* Actor : Actors)
+		{
+			Actor->Destroy();
+		}
+		LagCompensation->MarkAsGarbage();
+	}));
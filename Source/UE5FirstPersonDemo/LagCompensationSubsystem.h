@@ -0,0 +1,160 @@
+// LagCompensationSubsystem.h - 服务器端延迟补偿，为玩家和敌人保存固定长度的碰撞盒历史
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class ACharacter;
+
+/**
+ * 命中部位
+ */
+UENUM(BlueprintType)
+enum class EHitboxRegion : uint8
+{
+	Body	UMETA(DisplayName = "躯干"),
+	Head	UMETA(DisplayName = "头部"),
+	Legs	UMETA(DisplayName = "腿部")
+};
+
+/**
+ * 角色局部空间中的竖直胶囊碰撞盒
+ */
+struct FHitboxShape
+{
+	/** 相对角色根节点的中心点 */
+	FVector3f LocalCenter = FVector3f::ZeroVector;
+
+	/** 胶囊半径 */
+	float Radius = 0.0f;
+
+	/** 胶囊半高（包含半球部分） */
+	float HalfHeight = 0.0f;
+
+	/** 命中部位及伤害倍率 */
+	EHitboxRegion Region = EHitboxRegion::Body;
+	float DamageMultiplier = 1.0f;
+};
+
+/**
+ * 单帧历史 - 只保存根位置和偏航角，碰撞盒由局部形状推导
+ */
+struct FHitboxFrame
+{
+	float ServerTime = 0.0f;
+	FVector3f Location = FVector3f::ZeroVector;
+	uint16 PackedYaw = 0;
+	bool bCollisionEnabled = false;
+};
+
+/**
+ * 回溯后的命中结果
+ */
+struct FLagCompensatedHit
+{
+	AActor* Actor = nullptr;
+	FVector Location = FVector::ZeroVector;
+	float Distance = 0.0f;
+	int32 HitboxIndex = INDEX_NONE;
+	EHitboxRegion Region = EHitboxRegion::Body;
+	float DamageMultiplier = 1.0f;
+};
+
+/**
+ * 延迟补偿子系统 - 每个服务器Tick记录碰撞盒，射击时只回溯射线粗检测命中的角色
+ *
+ * 粗检测按整段历史的包围盒放入水平网格，射线只检查经过的格子，开销与射线附近的角色数相关而不是全部角色数。
+ */
+UCLASS()
+class ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 每个角色保存的历史帧数（内存固定） */
+	static constexpr int32 HistoryLength = 32;
+
+	/** 历史记录间隔（秒） */
+	static constexpr float RecordInterval = 1.0f / 60.0f;
+
+	/** 允许回溯的最长时间（秒）：覆盖客户端的敌人插值延迟和上行延迟，不超过历史长度 */
+	static constexpr float MaxRewindTime = 0.5f;
+
+	static_assert(MaxRewindTime < HistoryLength * RecordInterval, "回溯时间超出历史长度");
+
+	/** 粗检测网格的格子大小（水平面） */
+	static constexpr float BroadPhaseCellSize = 1024.0f;
+
+	/** 历史包围盒覆盖超过此格子数的角色（例如历史中有传送）不进网格，每次射击都检测 */
+	static constexpr int32 MaxBroadPhaseCellsPerActor = 64;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** 注册角色，使用其胶囊体作为单个碰撞盒（没有命中盒代理组件时使用） */
+	void RegisterCharacter(ACharacter* Character);
+
+	/** 注册任意Actor及其碰撞盒形状 */
+	void RegisterActor(AActor* Actor, TConstArrayView<FHitboxShape> Shapes);
+
+	/** 取消注册 */
+	void UnregisterActor(AActor* Actor);
+
+	/** 为所有已注册角色记录一帧历史（Tick按 RecordInterval 调用） */
+	void RecordFrames(float ServerTime);
+
+	/** 将客户端时间戳限制在可回溯范围内 */
+	float ClampRewindTime(float ClientTime) const;
+
+	/** 在指定服务器时间回溯碰撞盒并检测射线，返回最近的命中 */
+	bool TraceRewound(const FVector& Start, const FVector& End, float RewindTime,
+		const AActor* IgnoreActor, FLagCompensatedHit& OutHit) const;
+
+private:
+	struct FTrackedActor
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TArray<FHitboxShape, TInlineAllocator<4>> Shapes;
+
+		/** 碰撞盒相对根节点的最大范围，用于扩展历史包围盒 */
+		float ShapeExtent = 0.0f;
+
+		/** 环形缓冲区 */
+		TStaticArray<FHitboxFrame, HistoryLength> Frames;
+		int32 Head = 0;
+		int32 Count = 0;
+
+		/** 整段历史的包围盒（已包含碰撞盒范围） */
+		FBox HistoryBounds = FBox(ForceInit);
+	};
+
+	/** 记录一帧历史 */
+	void RecordFrame(FTrackedActor& Tracked, float ServerTime);
+
+	/** 在指定时间采样历史（线性插值） */
+	bool SampleFrame(const FTrackedActor& Tracked, float Time, FVector& OutLocation, float& OutYaw) const;
+
+	/** 按历史包围盒重建粗检测网格（记录历史后，或注册变化后的第一次检测前） */
+	void RebuildBroadPhase() const;
+
+	/** 收集射线在水平面上经过的格子中的角色索引（已去重） */
+	void GatherCandidates(const FVector& Start, const FVector& End, TArray<int32, TInlineAllocator<32>>& OutCandidates) const;
+
+	/** 已注册的角色 */
+	TArray<FTrackedActor> TrackedActors;
+
+	/** 粗检测网格：格子 -> BroadPhaseEntries 中的连续区间（起点，数量） */
+	mutable TMap<FIntPoint, FIntPoint> BroadPhaseCells;
+	mutable TArray<int32> BroadPhaseEntries;
+
+	/** 不进网格的角色 */
+	mutable TArray<int32> OversizedActors;
+
+	/** 角色索引变化后网格需要重建 */
+	mutable bool bBroadPhaseDirty = true;
+
+	/** 距上次记录的时间 */
+	float TimeSinceLastRecord = 0.0f;
+};
@@ -0,0 +1,409 @@
+// NetBandwidthStats.cpp - 网络带宽统计实现
+
+#include "NetBandwidthStats.h"
+#include "UE5FirstPersonDemo.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Serialization/BitWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogNetBandwidth, Log, All);
+
+CSV_DEFINE_CATEGORY(FPDNet, true);
+
+DECLARE_CYCLE_STAT(TEXT("Net Bandwidth Publish"), STAT_NetBandwidthPublish, STATGROUP_FirstPersonDemo);
+
+static int32 GNetBandwidthEnabled = 1;
+static FAutoConsoleVariableRef CVarNetBandwidthEnabled(
+	TEXT("fpd.NetBandwidth.Enable"),
+	GNetBandwidthEnabled,
+	TEXT("是否统计项目级网络带宽（按属性、RPC、Actor类和连接）"));
+
+namespace NetBandwidth
+{
+	/** 分类名称（日志和CSV使用） */
+	const TCHAR* const CategoryNames[] =
+	{
+		TEXT("Property"),
+		TEXT("Rpc"),
+		TEXT("ActorClass"),
+		TEXT("Connection")
+	};
+	static_assert(UE_ARRAY_COUNT(CategoryNames) == static_cast<int32>(ENetBandwidthCategory::Count), "每个分类都需要名称");
+
+	/**
+	 * 取得网络写入存档
+	 *
+	 * 引擎没有RTTI，只能按存档标志判断：写入模式的网络存档（IsNetArchive）都是FBitWriter
+	 * （FNetBitWriter、FOutBunch）。其他存档，或不带PackageMap的写入（例如本地测试），不统计。
+	 */
+	FBitWriter* GetNetWriter(FArchive& Ar, UPackageMap* Map)
+	{
+		if (!Map || !Ar.IsSaving() || !Ar.IsNetArchive())
+		{
+			return nullptr;
+		}
+
+		return static_cast<FBitWriter*>(&Ar);
+	}
+
+	FRpcScope* FRpcScope::Active = nullptr;
+}
+
+void FNetBandwidthCounter::Add(int64 Second, uint32 Bits, uint32 Count)
+{
+	const int32 Bucket = static_cast<int32>(Second % WindowSeconds);
+	if (BucketSecond[Bucket] != Second)
+	{
+		BucketSecond[Bucket] = Second;
+		BucketBits[Bucket] = 0;
+		BucketCounts[Bucket] = 0;
+	}
+
+	BucketBits[Bucket] += Bits;
+	BucketCounts[Bucket] += Count;
+	TotalBits += Bits;
+	TotalCount += Count;
+}
+
+float FNetBandwidthCounter::GetBitsPerSecond(int64 Second) const
+{
+	uint64 Sum = 0;
+	for (int32 Bucket = 0; Bucket < WindowSeconds; ++Bucket)
+	{
+		// 只统计完整的秒
+		if (BucketSecond[Bucket] < Second && BucketSecond[Bucket] >= Second - WindowSeconds)
+		{
+			Sum += BucketBits[Bucket];
+		}
+	}
+	return static_cast<float>(Sum) / WindowSeconds;
+}
+
+float FNetBandwidthCounter::GetCountPerSecond(int64 Second) const
+{
+	uint64 Sum = 0;
+	for (int32 Bucket = 0; Bucket < WindowSeconds; ++Bucket)
+	{
+		if (BucketSecond[Bucket] < Second && BucketSecond[Bucket] >= Second - WindowSeconds)
+		{
+			Sum += BucketCounts[Bucket];
+		}
+	}
+	return static_cast<float>(Sum) / WindowSeconds;
+}
+
+FNetBandwidthStats& FNetBandwidthStats::Get()
+{
+	static FNetBandwidthStats Instance;
+	return Instance;
+}
+
+bool FNetBandwidthStats::IsEnabled()
+{
+	return GNetBandwidthEnabled != 0;
+}
+
+int64 FNetBandwidthStats::GetCurrentSecond()
+{
+	return static_cast<int64>(FPlatformTime::Seconds());
+}
+
+void FNetBandwidthStats::Record(ENetBandwidthCategory Category, FName Key, uint32 Bits, uint32 Count)
+{
+	check(IsInGameThread());
+	Counters[static_cast<int32>(Category)].FindOrAdd(Key).Add(GetCurrentSecond(), Bits, Count);
+}
+
+void FNetBandwidthStats::Remove(ENetBandwidthCategory Category, FName Key)
+{
+	check(IsInGameThread());
+	Counters[static_cast<int32>(Category)].Remove(Key);
+}
+
+void FNetBandwidthStats::Reset()
+{
+	for (TMap<FName, FNetBandwidthCounter>& CategoryCounters : Counters)
+	{
+		CategoryCounters.Reset();
+	}
+}
+
+void FNetBandwidthStats::Dump(int32 MaxEntriesPerCategory) const
+{
+	const int64 Second = GetCurrentSecond();
+
+	for (int32 CategoryIndex = 0; CategoryIndex < static_cast<int32>(ENetBandwidthCategory::Count); ++CategoryIndex)
+	{
+		TArray<TPair<float, FName>> Sorted;
+		for (const TPair<FName, FNetBandwidthCounter>& Pair : Counters[CategoryIndex])
+		{
+			Sorted.Emplace(Pair.Value.GetBitsPerSecond(Second), Pair.Key);
+		}
+
+		Sorted.Sort([](const TPair<float, FName>& A, const TPair<float, FName>& B)
+		{
+			return A.Key > B.Key;
+		});
+
+		UE_LOG(LogNetBandwidth, Display, TEXT("[%s]"), NetBandwidth::CategoryNames[CategoryIndex]);
+
+		for (int32 Index = 0; Index < FMath::Min(Sorted.Num(), MaxEntriesPerCategory); ++Index)
+		{
+			const FNetBandwidthCounter& Counter = Counters[CategoryIndex].FindChecked(Sorted[Index].Value);
+			UE_LOG(LogNetBandwidth, Display, TEXT("  %-40s %10.2f kbit/s %8.1f /s   total %llu bytes, %llu sends"),
+				*Sorted[Index].Value.ToString(),
+				Sorted[Index].Key / 1000.0f,
+				Counter.GetCountPerSecond(Second),
+				Counter.TotalBits / 8,
+				Counter.TotalCount);
+		}
+	}
+}
+
+int32 NetBandwidth::GetNumClientConnections(const AActor* Actor)
+{
+	const UNetDriver* Driver = Actor ? Actor->GetNetDriver() : nullptr;
+	if (!Driver)
+	{
+		return 0;
+	}
+
+	return Driver->ServerConnection ? 1 : Driver->ClientConnections.Num();
+}
+
+void NetBandwidth::RecordPropertyChange(const AActor* Actor, FName Property, uint32 Bits, int32 NumReceivers)
+{
+	if (!FNetBandwidthStats::IsEnabled() || !Actor)
+	{
+		return;
+	}
+
+	const int32 NumConnections = GetNumClientConnections(Actor);
+	NumReceivers = (NumReceivers == INDEX_NONE) ? NumConnections : FMath::Min(NumReceivers, NumConnections);
+	if (NumReceivers <= 0)
+	{
+		return;
+	}
+
+	FNetBandwidthStats& Stats = FNetBandwidthStats::Get();
+	Stats.Record(ENetBandwidthCategory::Property, Property, Bits * NumReceivers, NumReceivers);
+	Stats.Record(ENetBandwidthCategory::ActorClass, Actor->GetClass()->GetFName(), Bits * NumReceivers, NumReceivers);
+}
+
+void NetBandwidth::FPropertyTracker::TrackHash(const AActor* Actor, FName Property, uint32 ValueHash, uint32 Bits, int32 NumReceivers)
+{
+	TPair<FName, uint32>* Last = LastHashes.FindByPredicate([Property](const TPair<FName, uint32>& Entry)
+	{
+		return Entry.Key == Property;
+	});
+
+	if (Last && Last->Value == ValueHash)
+	{
+		return;
+	}
+
+	if (Last)
+	{
+		Last->Value = ValueHash;
+	}
+	else
+	{
+		LastHashes.Emplace(Property, ValueHash);
+	}
+
+	RecordPropertyChange(Actor, Property, Bits, NumReceivers);
+}
+
+NetBandwidth::FSerializeScope::FSerializeScope(FArchive& InAr, UPackageMap* Map, FName InProperty, FName InOwnerClass)
+	: Property(InProperty)
+	, OwnerClass(InOwnerClass)
+{
+	if (FNetBandwidthStats::IsEnabled())
+	{
+		Writer = GetNetWriter(InAr, Map);
+		StartBits = Writer ? Writer->GetNumBits() : 0;
+	}
+}
+
+NetBandwidth::FSerializeScope::~FSerializeScope()
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	const uint32 Bits = static_cast<uint32>(Writer->GetNumBits() - StartBits);
+
+	if (FRpcScope* RpcScope = FRpcScope::GetActive())
+	{
+		RpcScope->AddPayloadBits(Bits);
+		return;
+	}
+
+	FNetBandwidthStats& Stats = FNetBandwidthStats::Get();
+	Stats.Record(ENetBandwidthCategory::Property, Property, Bits);
+	Stats.Record(ENetBandwidthCategory::ActorClass, OwnerClass, Bits);
+}
+
+NetBandwidth::FRpcScope::FRpcScope(const AActor* Actor, FName InRpc, int32 InNumReceivers, uint32 InEstimatedPayloadBits)
+	: Rpc(InRpc)
+	, OwnerClass(Actor ? Actor->GetClass()->GetFName() : NAME_None)
+	, NumReceivers(InNumReceivers)
+	, EstimatedPayloadBits(InEstimatedPayloadBits)
+	, bEnabled(FNetBandwidthStats::IsEnabled())
+{
+	if (bEnabled)
+	{
+		Previous = Active;
+		Active = this;
+	}
+}
+
+NetBandwidth::FRpcScope::~FRpcScope()
+{
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	Active = Previous;
+
+	// 自定义序列化的参数：按连接序列化时每个连接已各记一次；只序列化一次再共享时按接收者数放大
+	uint32 NumSends = 0;
+	uint32 Bits = 0;
+	if (NumSerializations > 0)
+	{
+		NumSends = FMath::Max(NumSerializations, static_cast<uint32>(FMath::Max(NumReceivers, 0)));
+		Bits = static_cast<uint32>(static_cast<uint64>(PayloadBits) * NumSends / NumSerializations);
+	}
+	else
+	{
+		NumSends = static_cast<uint32>(FMath::Max(NumReceivers, 0));
+		Bits = EstimatedPayloadBits * NumSends;
+	}
+
+	if (NumSends == 0)
+	{
+		return;
+	}
+
+	Bits += RpcHeaderBits * NumSends;
+
+	FNetBandwidthStats& Stats = FNetBandwidthStats::Get();
+	Stats.Record(ENetBandwidthCategory::Rpc, Rpc, Bits, NumSends);
+	Stats.Record(ENetBandwidthCategory::ActorClass, OwnerClass, Bits, NumSends);
+}
+
+void UNetBandwidthSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!FNetBandwidthStats::IsEnabled())
+	{
+		return;
+	}
+
+	const int64 Second = FNetBandwidthStats::GetCurrentSecond();
+	if (Second == LastPublishedSecond)
+	{
+		return;
+	}
+	LastPublishedSecond = Second;
+
+	Publish();
+}
+
+TStatId UNetBandwidthSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetBandwidthSubsystem, STATGROUP_Tickables);
+}
+
+void UNetBandwidthSubsystem::Deinitialize()
+{
+	// 世界销毁时它的所有连接都已关闭
+	FNetBandwidthStats& Stats = FNetBandwidthStats::Get();
+	for (const FName& Key : ConnectionKeys)
+	{
+		Stats.Remove(ENetBandwidthCategory::Connection, Key);
+	}
+	ConnectionKeys.Reset();
+
+	Super::Deinitialize();
+}
+
+void UNetBandwidthSubsystem::Publish()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NetBandwidthPublish);
+
+	FNetBandwidthStats& Stats = FNetBandwidthStats::Get();
+
+	// 连接统计每秒更新一次，按秒采样即可得到滚动平均。
+	// 按连接对象区分（同一地址重连或多个客户端共用地址时不合并），键中的地址只用于显示
+	TSet<FName> LiveConnectionKeys;
+	if (UNetDriver* Driver = GetWorld()->GetNetDriver())
+	{
+		auto SampleConnection = [&Stats, &LiveConnectionKeys](UNetConnection* Connection)
+		{
+			if (Connection)
+			{
+				const FName Key(*FString::Printf(TEXT("%s #%u"), *Connection->LowLevelGetRemoteAddress(true), Connection->GetUniqueID()));
+				LiveConnectionKeys.Add(Key);
+				Stats.Record(ENetBandwidthCategory::Connection, Key, static_cast<uint32>(Connection->OutBytesPerSecond) * 8);
+			}
+		};
+
+		SampleConnection(Driver->ServerConnection);
+		for (UNetConnection* Connection : Driver->ClientConnections)
+		{
+			SampleConnection(Connection);
+		}
+	}
+
+	// 已关闭的连接不再保留计数器
+	for (const FName& Key : ConnectionKeys)
+	{
+		if (!LiveConnectionKeys.Contains(Key))
+		{
+			Stats.Remove(ENetBandwidthCategory::Connection, Key);
+		}
+	}
+	ConnectionKeys = MoveTemp(LiveConnectionKeys);
+
+#if CSV_PROFILER
+	if (FCsvProfiler::Get()->IsCapturing())
+	{
+		const int64 Second = FNetBandwidthStats::GetCurrentSecond();
+		for (int32 CategoryIndex = 0; CategoryIndex < static_cast<int32>(ENetBandwidthCategory::Count); ++CategoryIndex)
+		{
+			for (const TPair<FName, FNetBandwidthCounter>& Pair : Stats.GetCounters(static_cast<ENetBandwidthCategory>(CategoryIndex)))
+			{
+				const FName StatName(*FString::Printf(TEXT("%s/%s"), NetBandwidth::CategoryNames[CategoryIndex], *Pair.Key.ToString()));
+				FCsvProfiler::RecordCustomStat(StatName, CSV_CATEGORY_INDEX(FPDNet), Pair.Value.GetBitsPerSecond(Second), ECsvCustomStatOp::Set);
+			}
+		}
+	}
+#endif
+}
+
+/** 控制台命令：输出带宽统计 */
+static FAutoConsoleCommand GNetBandwidthDumpCommand(
+	TEXT("fpd.NetBandwidth"),
+	TEXT("按属性、RPC、Actor类和连接输出最近10秒的平均发送带宽。可选参数：每类最多条数（默认20）"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 MaxEntries = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20;
+		FNetBandwidthStats::Get().Dump(MaxEntries);
+	}));
+
+/** 控制台命令：清空带宽统计 */
+static FAutoConsoleCommand GNetBandwidthResetCommand(
+	TEXT("fpd.NetBandwidth.Reset"),
+	TEXT("清空带宽统计"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FNetBandwidthStats::Get().Reset();
+	}));
@@ -0,0 +1,209 @@
+// NetBandwidthStats.h - 项目级网络带宽统计：按属性、RPC、Actor类和连接统计发送位数，滚动窗口计算速率
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NetBandwidthStats.generated.h"
+
+class FBitWriter;
+class UPackageMap;
+
+/**
+ * 带宽统计分类
+ */
+enum class ENetBandwidthCategory : uint8
+{
+	/** 复制属性 */
+	Property,
+	/** RPC（位数为参数载荷） */
+	Rpc,
+	/** 按Actor类汇总的属性和RPC */
+	ActorClass,
+	/** 每个连接的实际发送量（来自引擎的连接统计） */
+	Connection,
+	Count
+};
+
+/**
+ * 滚动窗口计数器 - 每秒一个桶，速率取最近 WindowSeconds 个完整秒的平均值
+ */
+struct FNetBandwidthCounter
+{
+	static constexpr int32 WindowSeconds = 10;
+
+	uint64 TotalBits = 0;
+	uint64 TotalCount = 0;
+
+	void Add(int64 Second, uint32 Bits, uint32 Count);
+
+	/** 滚动窗口内的平均位率（位/秒） */
+	float GetBitsPerSecond(int64 Second) const;
+
+	/** 滚动窗口内的平均次数（次/秒） */
+	float GetCountPerSecond(int64 Second) const;
+
+private:
+	uint32 BucketBits[WindowSeconds] = {};
+	uint32 BucketCounts[WindowSeconds] = {};
+	int64 BucketSecond[WindowSeconds] = {};
+};
+
+/**
+ * 带宽统计表 - 全局单例，只在游戏线程访问
+ *
+ * 自定义NetSerialize在写入时记录实际位数，RPC调用点用 FRpcScope 把载荷归入RPC，
+ * 普通属性在 PreReplication 中用 FPropertyTracker 按变化估算。关闭 fpd.NetBandwidth.Enable 后所有记录点只剩一次分支判断。
+ */
+class FNetBandwidthStats
+{
+public:
+	static FNetBandwidthStats& Get();
+
+	/** 是否启用统计 */
+	static bool IsEnabled();
+
+	/** 当前统计秒 */
+	static int64 GetCurrentSecond();
+
+	/** 记录一次发送 */
+	void Record(ENetBandwidthCategory Category, FName Key, uint32 Bits, uint32 Count = 1);
+
+	/** 获取某个分类的所有计数器 */
+	const TMap<FName, FNetBandwidthCounter>& GetCounters(ENetBandwidthCategory Category) const
+	{
+		return Counters[static_cast<int32>(Category)];
+	}
+
+	/** 删除一个计数器（例如连接关闭后） */
+	void Remove(ENetBandwidthCategory Category, FName Key);
+
+	/** 清空所有计数器 */
+	void Reset();
+
+	/** 把各分类按速率降序输出到日志 */
+	void Dump(int32 MaxEntriesPerCategory) const;
+
+private:
+	TMap<FName, FNetBandwidthCounter> Counters[static_cast<int32>(ENetBandwidthCategory::Count)];
+};
+
+namespace NetBandwidth
+{
+	/** 每次RPC调用除参数外的开销估算：函数句柄和载荷长度（打包整数），不含包头 */
+	constexpr uint32 RpcHeaderBits = 24;
+
+	/** 服务器上的客户端连接数（多播RPC和属性估算的接收者数量） */
+	int32 GetNumClientConnections(const AActor* Actor);
+
+	/**
+	 * 服务器：记录普通属性的一次变化
+	 *
+	 * 普通属性由引擎序列化，这里按值的位数乘以接收连接数估算（相关性剔除后的实际值只会更小）。
+	 * NumReceivers 为 INDEX_NONE 时发往所有客户端连接（只复制给拥有者的属性传1）。
+	 */
+	void RecordPropertyChange(const AActor* Actor, FName Property, uint32 Bits, int32 NumReceivers = INDEX_NONE);
+
+	/**
+	 * 普通属性的变化追踪 - 每个Actor一个，在 PreReplication 中对每个复制属性调用 Track
+	 *
+	 * 保存每个属性上次统计时的值哈希，值变化（包括首次复制）时记录一次。
+	 */
+	class FPropertyTracker
+	{
+	public:
+		template<typename ValueType>
+		void Track(const AActor* Actor, FName Property, const ValueType& Value, uint32 Bits = sizeof(ValueType) * 8, int32 NumReceivers = INDEX_NONE)
+		{
+			if (FNetBandwidthStats::IsEnabled())
+			{
+				TrackHash(Actor, Property, GetTypeHash(Value), Bits, NumReceivers);
+			}
+		}
+
+	private:
+		void TrackHash(const AActor* Actor, FName Property, uint32 ValueHash, uint32 Bits, int32 NumReceivers);
+
+		/** 属性名和上次统计时的值哈希 */
+		TArray<TPair<FName, uint32>, TInlineAllocator<8>> LastHashes;
+	};
+
+	/**
+	 * 自定义NetSerialize的统计作用域 - 写入时记录实际写入的位数
+	 *
+	 * 只统计带PackageMap的网络写入存档（即FBitWriter及其子类），其他存档忽略。
+	 * 在RPC作用域内时计入该RPC，否则计入属性。
+	 */
+	class FSerializeScope
+	{
+	public:
+		FSerializeScope(FArchive& InAr, UPackageMap* Map, FName InProperty, FName InOwnerClass);
+		~FSerializeScope();
+
+	private:
+		FBitWriter* Writer = nullptr;
+		FName Property;
+		FName OwnerClass;
+		int64 StartBits = 0;
+	};
+
+	/**
+	 * RPC调用统计作用域 - 包住RPC调用，调用期间序列化的参数位数计入该RPC
+	 *
+	 * 自定义NetSerialize的参数按实际序列化次数统计（引擎按连接序列化时已经是每个连接一次）；
+	 * 由引擎序列化的参数没有记录点，由调用方给出估算位数，按接收者数计。每次发送另加 RpcHeaderBits。
+	 */
+	class FRpcScope
+	{
+	public:
+		FRpcScope(const AActor* Actor, FName InRpc, int32 InNumReceivers = 1, uint32 InEstimatedPayloadBits = 0);
+		~FRpcScope();
+
+		/** 当前活动的RPC作用域 */
+		static FRpcScope* GetActive() { return Active; }
+
+		/** 记录一次参数序列化 */
+		void AddPayloadBits(uint32 Bits)
+		{
+			PayloadBits += Bits;
+			++NumSerializations;
+		}
+
+	private:
+		static FRpcScope* Active;
+
+		FRpcScope* Previous = nullptr;
+		FName Rpc;
+		FName OwnerClass;
+		int32 NumReceivers = 1;
+		uint32 EstimatedPayloadBits = 0;
+		uint32 PayloadBits = 0;
+		uint32 NumSerializations = 0;
+		bool bEnabled = false;
+	};
+}
+
+/**
+ * 带宽统计子系统 - 每秒采样一次连接发送量，并把各计数器的速率写入CSV分析器
+ */
+UCLASS()
+class UNetBandwidthSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UTickableWorldSubsystem
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+private:
+	/** 采样连接统计并发布CSV */
+	void Publish();
+
+	/** 上次发布的统计秒 */
+	int64 LastPublishedSecond = 0;
+
+	/** 本世界上次采样的连接计数器（连接关闭后删除） */
+	TSet<FName> ConnectionKeys;
+};
@@ -0,0 +1,299 @@
+// NetThreatPriority.cpp - 网络优先级模型实现
+
+#include "NetThreatPriority.h"
+#include "UE5FirstPersonDemo.h"
+#include "EnemyAICharacter.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogNetThreatPriority, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("NetPriority Evaluations"), STAT_NetPriorityEvaluations, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NetPriority Starved"), STAT_NetPriorityStarved, STATGROUP_FirstPersonDemo);
+
+float NetThreatPriority::GetEnemyStateWeight(EEnemyState State)
+{
+	switch (State)
+	{
+	case EEnemyState::Attack:
+		return 4.0f;
+
+	case EEnemyState::Chase:
+		return 2.5f;
+
+	case EEnemyState::Patrol:
+		return 1.0f;
+
+	case EEnemyState::Idle:
+		return 0.75f;
+
+	case EEnemyState::Dead:
+		return 0.5f;
+
+	default:
+		return 1.0f;
+	}
+}
+
+float NetThreatPriority::ComputeThreat(float StateWeight, bool bTargetsViewer, const FVector& ActorLocation,
+	const FVector& ViewPos, const FVector& ViewDir, bool bLowBandwidth)
+{
+	float Threat = StateWeight;
+
+	// 正在攻击或追逐当前观察者
+	if (bTargetsViewer)
+	{
+		Threat *= 3.0f;
+	}
+
+	// 距离衰减，带宽不足时衰减更快
+	const FVector ToActor = ActorLocation - ViewPos;
+	const float Distance = ToActor.Size();
+	const float Reference = bLowBandwidth ? ReferenceDistance * 0.5f : ReferenceDistance;
+	Threat *= FMath::Max(1.0f / (1.0f + FMath::Square(Distance / Reference)), 0.1f);
+
+	// 视野内提升，背后降低（近距离不区分）
+	if (Distance > CloseDistance)
+	{
+		const float Dot = FVector::DotProduct(ViewDir, ToActor / Distance);
+		Threat *= (Dot >= ViewConeCos) ? 1.5f : 0.6f;
+	}
+
+	return Threat;
+}
+
+float NetThreatPriority::ComputePriority(float BasePriority, float Threat, float TimeSinceSent)
+{
+	INC_DWORD_STAT(STAT_NetPriorityEvaluations);
+
+	float Priority = BasePriority * Threat * TimeSinceSent;
+
+	// 饥饿提升：长时间未更新的Actor优先级随时间线性增长
+	if (TimeSinceSent > StarvationThreshold)
+	{
+		INC_DWORD_STAT(STAT_NetPriorityStarved);
+		Priority *= 1.0f + (TimeSinceSent - StarvationThreshold) * 4.0f;
+	}
+
+	return Priority;
+}
+
+namespace NetPrioritySim
+{
+	/** 服务器网络帧率和模拟时长 */
+	constexpr float TickRate = 30.0f;
+	constexpr float Duration = 60.0f;
+
+	/** 与 AEnemyAICharacter 一致的更新频率和基础优先级 */
+	constexpr float EnemyNetUpdateFrequency = 15.0f;
+	constexpr float EnemyNetPriority = 3.0f;
+
+	/** 每次更新的字节数和每帧字节预算（约4.3KB/s，只够64个敌人所需更新的五分之一） */
+	constexpr int32 BytesPerUpdate = 24;
+	constexpr int32 TickByteBudget = 6 * BytesPerUpdate;
+
+	/** 任何Actor两次更新之间允许的最长间隔（秒） */
+	constexpr float MaxStarvation = 2.5f;
+
+	enum class EGroup : uint8
+	{
+		/** 近处、视野内、正在攻击观察者 */
+		HighThreat,
+		/** 中距离、视野内、正在追逐观察者 */
+		Targeting,
+		/** 巡逻，前后交替 */
+		Mid,
+		/** 远处、背后、空闲 */
+		Far,
+
+		Count
+	};
+
+	const TCHAR* GroupNames[] = { TEXT("high threat"), TEXT("targeting"), TEXT("mid"), TEXT("far") };
+
+	struct FSimActor
+	{
+		EGroup Group = EGroup::Far;
+		float Threat = 0.0f;
+		double LastSentTime = 0.0;
+		double NextUpdateTime = 0.0;
+		double MaxGap = 0.0;
+		int32 NumSent = 0;
+	};
+
+	/** 观察者在原点朝+X，按分组摆放敌人并计算威胁度 */
+	TArray<FSimActor> MakeActors()
+	{
+		TArray<FSimActor> Actors;
+
+		auto AddActor = [&Actors](EGroup Group, EEnemyState State, bool bTargetsViewer, const FVector& Location)
+		{
+			FSimActor& Actor = Actors.AddDefaulted_GetRef();
+			Actor.Group = Group;
+			Actor.Threat = NetThreatPriority::ComputeThreat(NetThreatPriority::GetEnemyStateWeight(State), bTargetsViewer,
+				Location, FVector::ZeroVector, FVector::ForwardVector, false);
+		};
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			AddActor(EGroup::HighThreat, EEnemyState::Attack, true, FVector(400.0f + 100.0f * Index, 0.0f, 0.0f));
+		}
+		for (int32 Index = 0; Index < 8; ++Index)
+		{
+			AddActor(EGroup::Targeting, EEnemyState::Chase, true, FVector(1500.0f + 200.0f * Index, 0.0f, 0.0f));
+		}
+		for (int32 Index = 0; Index < 20; ++Index)
+		{
+			const float Distance = 2500.0f + 300.0f * Index;
+			AddActor(EGroup::Mid, EEnemyState::Patrol, false, FVector((Index % 2 == 0) ? Distance : -Distance, 0.0f, 0.0f));
+		}
+		for (int32 Index = 0; Index < 32; ++Index)
+		{
+			AddActor(EGroup::Far, EEnemyState::Idle, false, FVector(-6000.0f - 500.0f * Index, 0.0f, 0.0f));
+		}
+
+		return Actors;
+	}
+
+	/**
+	 * 模拟一个连接的复制排序：每个网络帧收集到达更新间隔的Actor，按优先级从高到低在字节预算内发送，
+	 * 没发出去的下一帧继续竞争。bStarvationBoost 为false时用不带饥饿提升的优先级作对照。
+	 */
+	void Simulate(TArray<FSimActor>& Actors, bool bStarvationBoost)
+	{
+		const int32 NumTicks = FMath::RoundToInt(Duration * TickRate);
+		TArray<TPair<float, int32>> Candidates;
+
+		for (int32 Tick = 1; Tick <= NumTicks; ++Tick)
+		{
+			const double Now = Tick / TickRate;
+
+			Candidates.Reset();
+			for (int32 Index = 0; Index < Actors.Num(); ++Index)
+			{
+				const FSimActor& Actor = Actors[Index];
+				if (Now + UE_KINDA_SMALL_NUMBER < Actor.NextUpdateTime)
+				{
+					continue;
+				}
+
+				const float TimeSinceSent = static_cast<float>(Now - Actor.LastSentTime);
+				const float Priority = bStarvationBoost
+					? NetThreatPriority::ComputePriority(EnemyNetPriority, Actor.Threat, TimeSinceSent)
+					: EnemyNetPriority * Actor.Threat * TimeSinceSent;
+				Candidates.Emplace(Priority, Index);
+			}
+
+			Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+			{
+				return A.Key > B.Key;
+			});
+
+			int32 BytesSent = 0;
+			for (const TPair<float, int32>& Candidate : Candidates)
+			{
+				if (BytesSent + BytesPerUpdate > TickByteBudget)
+				{
+					break;
+				}
+				BytesSent += BytesPerUpdate;
+
+				FSimActor& Actor = Actors[Candidate.Value];
+				Actor.MaxGap = FMath::Max(Actor.MaxGap, Now - Actor.LastSentTime);
+				Actor.LastSentTime = Now;
+				Actor.NextUpdateTime = Now + 1.0 / EnemyNetUpdateFrequency;
+				++Actor.NumSent;
+			}
+		}
+
+		// 从最后一次发送到模拟结束也算一个间隔
+		for (FSimActor& Actor : Actors)
+		{
+			Actor.MaxGap = FMath::Max(Actor.MaxGap, Duration - Actor.LastSentTime);
+		}
+	}
+
+	/** 所有Actor中最长的更新间隔 */
+	double GetMaxGap(const TArray<FSimActor>& Actors)
+	{
+		double MaxGap = 0.0;
+		for (const FSimActor& Actor : Actors)
+		{
+			MaxGap = FMath::Max(MaxGap, Actor.MaxGap);
+		}
+		return MaxGap;
+	}
+}
+
+/** 控制台命令：网络优先级模拟，检查带宽不足时高威胁和以观察者为目标的敌人的更新频率，以及饥饿提升的效果 */
+static FAutoConsoleCommand GNetPrioritySimCommand(
+	TEXT("fpd.NetPrioritySim"),
+	TEXT("网络优先级模拟：64个敌人在固定的每帧字节预算下按 ComputePriority 排序复制，检查各组的更新频率和最长饥饿时间"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		using namespace NetPrioritySim;
+
+		TArray<FSimActor> Actors = MakeActors();
+		Simulate(Actors, true);
+
+		// 各组的最低和平均更新频率
+		constexpr int32 NumGroups = static_cast<int32>(EGroup::Count);
+		float MinRate[NumGroups];
+		float MeanRate[NumGroups] = {};
+		int32 NumInGroup[NumGroups] = {};
+		for (int32 Group = 0; Group < NumGroups; ++Group)
+		{
+			MinRate[Group] = TNumericLimits<float>::Max();
+		}
+		for (const FSimActor& Actor : Actors)
+		{
+			const int32 Group = static_cast<int32>(Actor.Group);
+			const float Rate = Actor.NumSent / Duration;
+			MinRate[Group] = FMath::Min(MinRate[Group], Rate);
+			MeanRate[Group] += Rate;
+			++NumInGroup[Group];
+		}
+		for (int32 Group = 0; Group < NumGroups; ++Group)
+		{
+			MeanRate[Group] /= FMath::Max(NumInGroup[Group], 1);
+			UE_LOG(LogNetThreatPriority, Display, TEXT("%s: %d actors, %.1f Hz min, %.1f Hz mean"),
+				GroupNames[Group], NumInGroup[Group], MinRate[Group], MeanRate[Group]);
+		}
+
+		int32 NumFailed = 0;
+
+		// 高威胁敌人基本不受带宽限制
+		const int32 HighThreat = static_cast<int32>(EGroup::HighThreat);
+		const bool bHighThreatPassed = MinRate[HighThreat] >= 0.9f * EnemyNetUpdateFrequency;
+		NumFailed += bHighThreatPassed ? 0 : 1;
+		UE_LOG(LogNetThreatPriority, Display, TEXT("%s high threat update rate: %.1f Hz (expected >= %.1f Hz)"),
+			bHighThreatPassed ? TEXT("PASS") : TEXT("FAIL"), MinRate[HighThreat], 0.9f * EnemyNetUpdateFrequency);
+
+		// 以观察者为目标的敌人至少保持三分之一的更新频率
+		const int32 Targeting = static_cast<int32>(EGroup::Targeting);
+		const bool bTargetingPassed = MinRate[Targeting] >= EnemyNetUpdateFrequency / 3.0f;
+		NumFailed += bTargetingPassed ? 0 : 1;
+		UE_LOG(LogNetThreatPriority, Display, TEXT("%s targeting update rate: %.1f Hz (expected >= %.1f Hz)"),
+			bTargetingPassed ? TEXT("PASS") : TEXT("FAIL"), MinRate[Targeting], EnemyNetUpdateFrequency / 3.0f);
+
+		// 平均频率按威胁度分组递减
+		bool bOrderPassed = true;
+		for (int32 Group = 1; Group < NumGroups; ++Group)
+		{
+			bOrderPassed &= MeanRate[Group] <= MeanRate[Group - 1];
+		}
+		NumFailed += bOrderPassed ? 0 : 1;
+		UE_LOG(LogNetThreatPriority, Display, TEXT("%s mean update rate decreases with threat"),
+			bOrderPassed ? TEXT("PASS") : TEXT("FAIL"));
+
+		// 饥饿提升：最远的敌人也在限定时间内得到更新，且比不带提升的对照组短
+		TArray<FSimActor> Unboosted = MakeActors();
+		Simulate(Unboosted, false);
+		const double MaxGap = GetMaxGap(Actors);
+		const double UnboostedMaxGap = GetMaxGap(Unboosted);
+		const bool bStarvationPassed = MaxGap <= MaxStarvation && MaxGap < UnboostedMaxGap;
+		NumFailed += bStarvationPassed ? 0 : 1;
+		UE_LOG(LogNetThreatPriority, Display, TEXT("%s starvation: longest gap %.2f s with boost, %.2f s without (limit %.2f s)"),
+			bStarvationPassed ? TEXT("PASS") : TEXT("FAIL"), MaxGap, UnboostedMaxGap, MaxStarvation);
+
+		UE_LOG(LogNetThreatPriority, Display, TEXT("Net priority simulation: %s"), NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+	}));
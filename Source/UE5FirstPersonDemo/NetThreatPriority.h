@@ -0,0 +1,39 @@
+// NetThreatPriority.h - 按游戏威胁度计算网络优先级，带宽不足时保证高威胁角色的更新频率
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EEnemyState : uint8;
+
+/**
+ * 网络优先级模型
+ *
+ * 引擎在带宽不足时按 GetNetPriority 的结果排序发送。传入的 Time 是该Actor距上次
+ * 复制到当前连接的时间，即每个连接各自的饥饿时间；这里在威胁度之上对长时间未更新的
+ * Actor做额外提升，避免远处角色被完全饿死。
+ */
+namespace NetThreatPriority
+{
+	/** 参考距离：超过后优先级按平方衰减 */
+	constexpr float ReferenceDistance = 1500.0f;
+
+	/** 近距离内忽略视野朝向 */
+	constexpr float CloseDistance = 500.0f;
+
+	/** 视野锥半角的余弦：半角60度，即整个视野锥120度（默认90度水平视野的屏幕对角约49度，留出转身余量） */
+	constexpr float ViewConeCos = 0.5f;
+
+	/** 超过此时间未更新视为饥饿（秒） */
+	constexpr float StarvationThreshold = 0.5f;
+
+	/** 敌人状态权重 */
+	float GetEnemyStateWeight(EEnemyState State);
+
+	/** 计算威胁度：状态权重 × 是否以观察者为目标 × 距离衰减 × 视野 */
+	float ComputeThreat(float StateWeight, bool bTargetsViewer, const FVector& ActorLocation,
+		const FVector& ViewPos, const FVector& ViewDir, bool bLowBandwidth);
+
+	/** 结合饥饿时间得到最终优先级 */
+	float ComputePriority(float BasePriority, float Threat, float TimeSinceSent);
+}
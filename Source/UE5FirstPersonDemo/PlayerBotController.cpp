@@ -0,0 +1,226 @@
+// PlayerBotController.cpp - 玩家机器人控制器实现
+
+#include "PlayerBotController.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "EnemyAICharacter.h"
+#include "Camera/CameraComponent.h"
+#include "EngineUtils.h"
+#include "Navigation/PathFollowingComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Player Bot Think"), STAT_PlayerBotThink, STATGROUP_FirstPersonDemo);
+
+APlayerBotController::APlayerBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// 机器人需要PlayerState才能参与计分
+	bWantsPlayerState = true;
+
+	EngageRange = 4000.0f;
+	PreferredRange = 1200.0f;
+	AimErrorDegrees = 3.0f;
+	TurnRate = 360.0f;
+	ReactionTime = 0.3f;
+	bTargetPlayers = false;
+
+	BotCharacter = nullptr;
+	TimeUntilThink = 0.0f;
+	TimeTargetVisible = 0.0f;
+	bTargetVisible = false;
+	AimOffset = FRotator::ZeroRotator;
+	StrafeDirection = 1.0f;
+	StrafeTimeLeft = 0.0f;
+	bDirectMovement = false;
+}
+
+void APlayerBotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	BotCharacter = Cast<AFirstPersonDemoCharacter>(InPawn);
+	Target.Reset();
+
+	// 错开各机器人的决策帧
+	TimeUntilThink = FMath::FRandRange(0.0f, ThinkInterval);
+}
+
+void APlayerBotController::OnUnPossess()
+{
+	if (BotCharacter)
+	{
+		BotCharacter->ApplyScriptedInput(FVector2D::ZeroVector, FVector2D::ZeroVector, false);
+	}
+
+	StopMovement();
+	BotCharacter = nullptr;
+
+	Super::OnUnPossess();
+}
+
+void APlayerBotController::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!BotCharacter || BotCharacter->IsDead())
+	{
+		return;
+	}
+
+	TimeUntilThink -= DeltaTime;
+	if (TimeUntilThink <= 0.0f)
+	{
+		TimeUntilThink = ThinkInterval;
+		Think();
+	}
+
+	AActor* CurrentTarget = Target.Get();
+	if (!CurrentTarget)
+	{
+		BotCharacter->ApplyScriptedInput(FVector2D::ZeroVector, FVector2D::ZeroVector, false);
+		return;
+	}
+
+	// 平滑转向目标（带误差）
+	const FVector EyeLocation = BotCharacter->FirstPersonCameraComponent->GetComponentLocation();
+	const FRotator DesiredRotation = (CurrentTarget->GetActorLocation() - EyeLocation).Rotation() + AimOffset;
+	const FRotator NewRotation = FMath::RInterpConstantTo(GetControlRotation(), DesiredRotation, DeltaTime, TurnRate);
+	SetControlRotation(NewRotation);
+
+	// 进入交战距离后左右横移；寻路不可用时直接向目标移动
+	FVector2D MoveVector = FVector2D::ZeroVector;
+	const float Distance = FVector::Dist(BotCharacter->GetActorLocation(), CurrentTarget->GetActorLocation());
+
+	if (Distance <= PreferredRange)
+	{
+		StrafeTimeLeft -= DeltaTime;
+		if (StrafeTimeLeft <= 0.0f)
+		{
+			StrafeDirection = -StrafeDirection;
+			StrafeTimeLeft = FMath::FRandRange(0.5f, 1.5f);
+		}
+		MoveVector.X = StrafeDirection;
+	}
+	else if (bDirectMovement)
+	{
+		MoveVector.Y = 1.0f;
+	}
+
+	// 看到目标超过反应时间且大致对准后开火
+	const float AimError = FMath::Abs(FRotator::NormalizeAxis(NewRotation.Yaw - DesiredRotation.Yaw));
+	const bool bWantsFire = bTargetVisible && TimeTargetVisible >= ReactionTime && Distance <= EngageRange && AimError < 10.0f;
+
+	if (bTargetVisible)
+	{
+		TimeTargetVisible += DeltaTime;
+	}
+
+	BotCharacter->ApplyScriptedInput(MoveVector, FVector2D::ZeroVector, bWantsFire);
+}
+
+void APlayerBotController::Think()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PlayerBotThink);
+
+	AActor* CurrentTarget = Target.Get();
+	if (!IsTargetAlive(CurrentTarget))
+	{
+		CurrentTarget = nullptr;
+	}
+
+	// 当前目标失效时重新选择
+	AActor* NewTarget = CurrentTarget ? CurrentTarget : SelectTarget();
+	if (NewTarget != CurrentTarget)
+	{
+		Target = NewTarget;
+		TimeTargetVisible = 0.0f;
+		bTargetVisible = false;
+
+		if (NewTarget)
+		{
+			bDirectMovement = MoveToActor(NewTarget, PreferredRange) == EPathFollowingRequestResult::Failed;
+		}
+	}
+
+	if (!NewTarget)
+	{
+		Wander();
+		return;
+	}
+
+	const bool bWasVisible = bTargetVisible;
+	bTargetVisible = LineOfSightTo(NewTarget);
+
+	// 每次重新看到目标时产生新的瞄准误差
+	if (bTargetVisible && !bWasVisible)
+	{
+		TimeTargetVisible = 0.0f;
+		AimOffset = FRotator(FMath::FRandRange(-AimErrorDegrees, AimErrorDegrees), FMath::FRandRange(-AimErrorDegrees, AimErrorDegrees), 0.0f);
+	}
+
+	// 目标离开后继续跟随
+	if (!bDirectMovement && GetMoveStatus() == EPathFollowingStatus::Idle
+		&& FVector::Dist(BotCharacter->GetActorLocation(), NewTarget->GetActorLocation()) > PreferredRange)
+	{
+		bDirectMovement = MoveToActor(NewTarget, PreferredRange) == EPathFollowingRequestResult::Failed;
+	}
+}
+
+void APlayerBotController::Wander()
+{
+	if (GetMoveStatus() != EPathFollowingStatus::Idle)
+	{
+		return;
+	}
+
+	const FVector Offset(FMath::FRandRange(-1500.0f, 1500.0f), FMath::FRandRange(-1500.0f, 1500.0f), 0.0f);
+	MoveToLocation(BotCharacter->GetActorLocation() + Offset);
+}
+
+AActor* APlayerBotController::SelectTarget() const
+{
+	const FVector Location = BotCharacter->GetActorLocation();
+
+	AActor* BestTarget = nullptr;
+	float BestDistanceSq = FMath::Square(EngageRange);
+
+	for (TActorIterator<AEnemyAICharacter> It(GetWorld()); It; ++It)
+	{
+		const float DistanceSq = FVector::DistSquared(Location, It->GetActorLocation());
+		if (DistanceSq < BestDistanceSq && !It->IsDead())
+		{
+			BestDistanceSq = DistanceSq;
+			BestTarget = *It;
+		}
+	}
+
+	if (bTargetPlayers)
+	{
+		for (TActorIterator<AFirstPersonDemoCharacter> It(GetWorld()); It; ++It)
+		{
+			const float DistanceSq = FVector::DistSquared(Location, It->GetActorLocation());
+			if (*It != BotCharacter && DistanceSq < BestDistanceSq && !It->IsDead())
+			{
+				BestDistanceSq = DistanceSq;
+				BestTarget = *It;
+			}
+		}
+	}
+
+	return BestTarget;
+}
+
+bool APlayerBotController::IsTargetAlive(const AActor* Actor)
+{
+	if (const AEnemyAICharacter* Enemy = Cast<AEnemyAICharacter>(Actor))
+	{
+		return !Enemy->IsDead();
+	}
+
+	if (const AFirstPersonDemoCharacter* Player = Cast<AFirstPersonDemoCharacter>(Actor))
+	{
+		return !Player->IsDead();
+	}
+
+	return false;
+}
@@ -0,0 +1,92 @@
+// PlayerBotController.h - 服务器端AI玩家机器人，用于无客户端的模拟压力测试
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "PlayerBotController.generated.h"
+
+class AFirstPersonDemoCharacter;
+
+/**
+ * 玩家机器人控制器 - 在服务器上控制 AFirstPersonDemoCharacter
+ *
+ * 选择最近的存活敌人（可选包括其他玩家），寻路接近后保持距离左右横移，
+ * 带反应时间和瞄准误差地转向目标并连射。射击走与监听服务器主机相同的权威射击路径，
+ * 伤害、死亡和重生都由游戏模式按真实玩家处理。
+ */
+UCLASS()
+class APlayerBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	APlayerBotController();
+
+	virtual void Tick(float DeltaTime) override;
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+protected:
+	/** 开始交战的距离 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	float EngageRange;
+
+	/** 交战时保持的距离 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	float PreferredRange;
+
+	/** 每次重新瞄准的随机误差（度） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	float AimErrorDegrees;
+
+	/** 转向速度（度/秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	float TurnRate;
+
+	/** 看到目标后开火前的反应时间 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	float ReactionTime;
+
+	/** 是否也攻击其他玩家（死斗） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bot)
+	bool bTargetPlayers;
+
+private:
+	/** 重新选择目标并检查视线的间隔 */
+	static constexpr float ThinkInterval = 0.25f;
+
+	/** 选择最近的有效目标 */
+	AActor* SelectTarget() const;
+
+	/** 目标是否存活 */
+	static bool IsTargetAlive(const AActor* Actor);
+
+	/** 周期性决策：选目标、寻路、检查视线 */
+	void Think();
+
+	/** 没有目标时随机游走 */
+	void Wander();
+
+	UPROPERTY()
+	AFirstPersonDemoCharacter* BotCharacter;
+
+	TWeakObjectPtr<AActor> Target;
+
+	float TimeUntilThink;
+
+	/** 目标持续可见的时间 */
+	float TimeTargetVisible;
+
+	bool bTargetVisible;
+
+	/** 当前瞄准误差 */
+	FRotator AimOffset;
+
+	/** 横移方向（-1 或 1）和剩余时间 */
+	float StrafeDirection;
+	float StrafeTimeLeft;
+
+	/** 寻路失败时直接朝目标移动 */
+	bool bDirectMovement;
+};
@@ -0,0 +1,573 @@
+// ProjectileSubsystem.cpp - 射弹子系统实现
+
+#include "ProjectileSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "FirstPersonDemoPlayerController.h"
+#include "LagCompensationSubsystem.h"
+#include "CombatAssetSubsystem.h"
+#include "VfxPoolSubsystem.h"
+#include "NetBandwidthStats.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/WorldSettings.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogProjectile, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Resolve"), STAT_ProjectileResolve, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Projectile Integrate"), STAT_ProjectileIntegrate, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Projectile Dispatch"), STAT_ProjectileDispatch, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Projectile Render"), STAT_ProjectileRender, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles In Flight"), STAT_ProjectilesInFlight, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Impacts"), STAT_ProjectileImpacts, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Spawns Sent"), STAT_ProjectileSpawnsSent, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Spawns Culled"), STAT_ProjectileSpawnsCulled, STATGROUP_FirstPersonDemo);
+
+namespace Projectiles
+{
+	/** 表现网格的缩放（引擎基础球体直径100） */
+	constexpr float RenderScale = 0.05f;
+
+	/** 服务器和客户端共用的时间基准 */
+	float GetSimulationTime(const UWorld* World)
+	{
+		const AGameStateBase* GameState = World->GetGameState();
+		return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	}
+
+	/** 场景遮挡走武器通道，角色由命中盒代理（服务器）或胶囊体（客户端）判定 */
+	FCollisionQueryParams MakeQueryParams(const AActor* Shooter)
+	{
+		static const FName NAME_ProjectileSweep(TEXT("ProjectileSweep"));
+
+		FCollisionQueryParams Params(NAME_ProjectileSweep, false);
+		Params.AddIgnoredActor(Shooter);
+		return Params;
+	}
+
+	/** 客户端表现用的角色胶囊体 */
+	struct FCapsuleTarget
+	{
+		const AActor* Actor = nullptr;
+		FVector Center = FVector::ZeroVector;
+		float Radius = 0.0f;
+		float HalfHeight = 0.0f;
+	};
+
+	/** 线段与竖直胶囊体求交，返回命中点到起点的距离 */
+	bool SegmentHitsCapsule(const FVector& Start, const FVector& End, const FCapsuleTarget& Target, float& OutDistance)
+	{
+		const FVector Axis(0.0f, 0.0f, FMath::Max(Target.HalfHeight - Target.Radius, 0.0f));
+
+		FVector PointOnSegment;
+		FVector PointOnAxis;
+		FMath::SegmentDistToSegmentSafe(Start, End, Target.Center - Axis, Target.Center + Axis, PointOnSegment, PointOnAxis);
+
+		if (FVector::DistSquared(PointOnSegment, PointOnAxis) > FMath::Square(Target.Radius))
+		{
+			return false;
+		}
+
+		OutDistance = FVector::Dist(Start, PointOnSegment);
+		return true;
+	}
+
+	const FName NAME_ClientReceiveProjectileSpawns(TEXT("ClientReceiveProjectileSpawns"));
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const float Now = Projectiles::GetSimulationTime(World);
+
+	if (Benchmark.bActive)
+	{
+		TickBenchmark(Now, DeltaTime);
+	}
+
+	// 先处理上一帧线段的扫掠结果，再推进并发出本帧的线段
+	ResolveSweeps(Now);
+	Integrate(Now);
+	DispatchSweeps();
+
+	if (World->GetNetMode() != NM_Client)
+	{
+		FlushSpawns();
+	}
+
+	UpdateRender();
+
+	INC_DWORD_STAT_BY(STAT_ProjectilesInFlight, Positions.Num());
+
+	if (Benchmark.bActive)
+	{
+		Benchmark.GameThreadSeconds += FPlatformTime::Seconds() - StartTime;
+		++Benchmark.NumFrames;
+	}
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void UProjectileSubsystem::Deinitialize()
+{
+	if (RenderInstances)
+	{
+		RenderInstances->DestroyComponent();
+		RenderInstances = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+int32 UProjectileSubsystem::ClearProjectiles()
+{
+	const int32 NumCleared = Positions.Num();
+
+	// 未取回的异步射线结果随句柄一起丢弃；实例化网格下一帧把多余的实例缩放为零
+	Origins.Reset();
+	Velocities.Reset();
+	Positions.Reset();
+	PreviousPositions.Reset();
+	SpawnTimes.Reset();
+	Damages.Reset();
+	Shooters.Reset();
+	TraceHandles.Reset();
+	PendingSpawns.Reset();
+
+	return NumCleared;
+}
+
+void UProjectileSubsystem::FireProjectile(AFirstPersonDemoCharacter* Shooter, const FVector& Origin, const FVector& Velocity, float SpawnTime, float Damage)
+{
+	FProjectileSpawn Spawn;
+	Spawn.Origin = Origin;
+	Spawn.Velocity = Velocity;
+	Spawn.SpawnTime = SpawnTime;
+	Spawn.Shooter = Shooter;
+
+	// 客户端的射弹只做预测表现，伤害只由服务器结算
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		AddProjectile(Spawn, 0.0f);
+		return;
+	}
+
+	if (AddProjectile(Spawn, Damage) != INDEX_NONE)
+	{
+		PendingSpawns.Add(Spawn);
+	}
+}
+
+void UProjectileSubsystem::ReceiveSpawns(const FProjectileSpawnBatch& Batch)
+{
+	for (const FProjectileSpawn& Spawn : Batch.Spawns)
+	{
+		AddProjectile(Spawn, 0.0f);
+	}
+}
+
+int32 UProjectileSubsystem::AddProjectile(const FProjectileSpawn& Spawn, float Damage)
+{
+	if (Positions.Num() >= MaxProjectiles)
+	{
+		return INDEX_NONE;
+	}
+
+	Origins.Add(Spawn.Origin);
+	Velocities.Add(Spawn.Velocity);
+	Positions.Add(Spawn.Origin);
+	PreviousPositions.Add(Spawn.Origin);
+	SpawnTimes.Add(Spawn.SpawnTime);
+	Damages.Add(Damage);
+	Shooters.Add(Spawn.Shooter);
+	return TraceHandles.AddDefaulted();
+}
+
+void UProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	Origins.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	SpawnTimes.RemoveAtSwap(Index, 1, false);
+	Damages.RemoveAtSwap(Index, 1, false);
+	Shooters.RemoveAtSwap(Index, 1, false);
+	TraceHandles.RemoveAtSwap(Index, 1, false);
+}
+
+void UProjectileSubsystem::ResolveSweeps(float Now)
+{
+	if (Positions.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileResolve);
+
+	UWorld* World = GetWorld();
+	const bool bAuthority = World->GetNetMode() != NM_Client;
+	const bool bPlayCosmetics = ShouldPlayCosmetics(World);
+	ULagCompensationSubsystem* LagCompensation = bAuthority ? World->GetSubsystem<ULagCompensationSubsystem>() : nullptr;
+	UVfxPoolSubsystem* VfxPool = bPlayCosmetics ? World->GetSubsystem<UVfxPoolSubsystem>() : nullptr;
+
+	// 客户端只与当前的角色胶囊体求交
+	TArray<Projectiles::FCapsuleTarget, TInlineAllocator<32>> Capsules;
+	if (!bAuthority)
+	{
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			const UCapsuleComponent* Capsule = It->GetCapsuleComponent();
+			if (Capsule && Capsule->IsCollisionEnabled())
+			{
+				Projectiles::FCapsuleTarget& Target = Capsules.AddDefaulted_GetRef();
+				Target.Actor = *It;
+				Target.Center = Capsule->GetComponentLocation();
+				Target.Radius = Capsule->GetScaledCapsuleRadius();
+				Target.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+			}
+		}
+	}
+
+	// 倒序遍历，交换删除不会影响尚未处理的射弹
+	FTraceDatum Datum;
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		if (!TraceHandles[Index].IsValid())
+		{
+			// 本帧新加入，尚未扫掠
+			continue;
+		}
+
+		const FVector& Start = PreviousPositions[Index];
+		const FVector& End = Positions[Index];
+		const AFirstPersonDemoCharacter* Shooter = Shooters[Index].Get();
+
+		float BlockingDistance = TNumericLimits<float>::Max();
+		FVector ImpactPoint = End;
+		if (World->QueryTraceData(TraceHandles[Index], Datum))
+		{
+			if (Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+			{
+				BlockingDistance = Datum.OutHits[0].Distance;
+				ImpactPoint = Datum.OutHits[0].ImpactPoint;
+			}
+		}
+		else
+		{
+			// 结果不可用（句柄已过期）时退回同步射线
+			FHitResult HitResult;
+			if (World->LineTraceSingleByChannel(HitResult, Start, End, TraceChannel_Weapon, Projectiles::MakeQueryParams(Shooter)))
+			{
+				BlockingDistance = HitResult.Distance;
+				ImpactPoint = HitResult.ImpactPoint;
+			}
+		}
+
+		bool bHitCharacter = false;
+		if (LagCompensation)
+		{
+			// 线段末端就是当前服务器时间，命中盒取最新一帧（射弹自身的时间已按客户端开火时刻推进，不再回溯）
+			FLagCompensatedHit RewoundHit;
+			if (LagCompensation->TraceRewound(Start, End, SweepTime, Shooter, RewoundHit) && RewoundHit.Distance <= BlockingDistance)
+			{
+				bHitCharacter = true;
+
+				AFirstPersonDemoCharacter* DamageShooter = Shooters[Index].Get();
+				if (DamageShooter && Damages[Index] > 0.0f)
+				{
+					DamageShooter->ApplyPointDamage(RewoundHit.Actor, Damages[Index] * RewoundHit.DamageMultiplier, RewoundHit.Location);
+				}
+			}
+		}
+		else
+		{
+			for (const Projectiles::FCapsuleTarget& Target : Capsules)
+			{
+				float Distance = 0.0f;
+				if (Target.Actor != Shooter && Projectiles::SegmentHitsCapsule(Start, End, Target, Distance) && Distance <= BlockingDistance)
+				{
+					bHitCharacter = true;
+					break;
+				}
+			}
+		}
+
+		if (bHitCharacter)
+		{
+			// 角色命中的特效由服务器的伤害路径通过装饰性事件发出
+			INC_DWORD_STAT(STAT_ProjectileImpacts);
+			RemoveProjectile(Index);
+		}
+		else if (BlockingDistance < TNumericLimits<float>::Max())
+		{
+			// 场景命中各端按相同轨迹各自播放
+			INC_DWORD_STAT(STAT_ProjectileImpacts);
+			if (VfxPool)
+			{
+				VfxPool->SpawnAtLocation(EPooledEffect::Impact, nullptr, ImpactPoint);
+			}
+			RemoveProjectile(Index);
+		}
+		else if (Now - SpawnTimes[Index] > MaxLifetime)
+		{
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+void UProjectileSubsystem::Integrate(float Now)
+{
+	if (Positions.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileIntegrate);
+
+	SweepTime = Now;
+
+	// 解析轨迹：位置只取决于生成参数和时间，不累积逐帧误差
+	const FVector HalfGravity(0.0f, 0.0f, GravityZ * 0.5f);
+	const int32 NumProjectiles = Positions.Num();
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		const float Time = FMath::Max(Now - SpawnTimes[Index], 0.0f);
+		PreviousPositions[Index] = Positions[Index];
+		Positions[Index] = Origins[Index] + Velocities[Index] * Time + HalfGravity * (Time * Time);
+	}
+}
+
+void UProjectileSubsystem::DispatchSweeps()
+{
+	if (Positions.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileDispatch);
+
+	UWorld* World = GetWorld();
+	for (int32 Index = 0; Index < Positions.Num(); ++Index)
+	{
+		TraceHandles[Index] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, PreviousPositions[Index], Positions[Index],
+			TraceChannel_Weapon, Projectiles::MakeQueryParams(Shooters[Index].Get()));
+	}
+}
+
+void UProjectileSubsystem::FlushSpawns()
+{
+	if (PendingSpawns.Num() == 0)
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		// 监听服务器的本地玩家直接看到服务器的模拟
+		AFirstPersonDemoPlayerController* DemoPC = Cast<AFirstPersonDemoPlayerController>(It->Get());
+		if (!DemoPC || DemoPC->IsLocalController())
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		DemoPC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		const APawn* OwnPawn = DemoPC->GetPawn();
+		const AActor* ViewTarget = DemoPC->GetViewTarget();
+
+		// 按到观察者的距离收集候选射弹
+		TArray<TPair<float, int32>, TInlineAllocator<64>> Candidates;
+		for (int32 Index = 0; Index < PendingSpawns.Num(); ++Index)
+		{
+			const AFirstPersonDemoCharacter* Shooter = PendingSpawns[Index].Shooter;
+
+			// 射击者自己的客户端已经预测生成
+			if (Shooter == OwnPawn)
+			{
+				continue;
+			}
+
+			// 射击者对该连接不相关时，客户端没有这个角色，也不需要它的射弹
+			if (Shooter && !Shooter->IsNetRelevantFor(DemoPC, ViewTarget, ViewLocation))
+			{
+				INC_DWORD_STAT(STAT_ProjectileSpawnsCulled);
+				continue;
+			}
+
+			Candidates.Emplace(FVector::DistSquared(ViewLocation, FVector(PendingSpawns[Index].Origin)), Index);
+		}
+
+		if (Candidates.Num() == 0)
+		{
+			continue;
+		}
+
+		// 每帧每个连接只发一个不超过MTU的批次，超出时保留最近的射弹（射弹的复制只影响表现）
+		if (Candidates.Num() > FProjectileSpawnBatch::MaxSpawns)
+		{
+			Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+			{
+				return A.Key < B.Key;
+			});
+
+			INC_DWORD_STAT_BY(STAT_ProjectileSpawnsCulled, Candidates.Num() - FProjectileSpawnBatch::MaxSpawns);
+			Candidates.SetNum(FProjectileSpawnBatch::MaxSpawns, false);
+		}
+
+		FProjectileSpawnBatch Batch;
+		Batch.Spawns.Reserve(Candidates.Num());
+		for (const TPair<float, int32>& Candidate : Candidates)
+		{
+			Batch.Spawns.Add(PendingSpawns[Candidate.Value]);
+		}
+
+		INC_DWORD_STAT_BY(STAT_ProjectileSpawnsSent, Batch.Spawns.Num());
+
+		NetBandwidth::FRpcScope RpcScope(DemoPC, Projectiles::NAME_ClientReceiveProjectileSpawns);
+		DemoPC->ClientReceiveProjectileSpawns(Batch);
+	}
+
+	PendingSpawns.Reset();
+}
+
+void UProjectileSubsystem::UpdateRender()
+{
+	UWorld* World = GetWorld();
+	if (!ShouldPlayCosmetics(World))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileRender);
+
+	// 网格由战斗资产子系统预加载，加载完成后才创建
+	if (!RenderInstances)
+	{
+		if (Positions.Num() == 0)
+		{
+			return;
+		}
+
+		UStaticMesh* Mesh = UCombatAssetSubsystem::Get<UStaticMesh>(World, ECombatAsset::ProjectileMesh);
+		if (!Mesh)
+		{
+			return;
+		}
+
+		RenderInstances = NewObject<UInstancedStaticMeshComponent>(World->GetWorldSettings());
+		RenderInstances->SetStaticMesh(Mesh);
+		RenderInstances->SetMobility(EComponentMobility::Movable);
+		RenderInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		RenderInstances->SetCastShadow(false);
+		RenderInstances->RegisterComponentWithWorld(World);
+	}
+
+	// 实例数只增不减，多余的实例缩放为零
+	const int32 NumInstances = RenderInstances->GetInstanceCount();
+	const int32 NumTransforms = FMath::Max(NumInstances, Positions.Num());
+	if (NumInstances == 0 && Positions.Num() == 0)
+	{
+		return;
+	}
+
+	RenderTransforms.Reset(NumTransforms);
+	const FVector Scale(Projectiles::RenderScale);
+	for (const FVector& Position : Positions)
+	{
+		RenderTransforms.Emplace(FQuat::Identity, Position, Scale);
+	}
+	for (int32 Index = Positions.Num(); Index < NumTransforms; ++Index)
+	{
+		RenderTransforms.Emplace(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	}
+
+	if (NumInstances < NumTransforms)
+	{
+		TArray<FTransform> NewInstances(RenderTransforms.GetData() + NumInstances, NumTransforms - NumInstances);
+		RenderInstances->AddInstances(NewInstances, false, true);
+	}
+
+	RenderInstances->BatchUpdateInstancesTransforms(0, RenderTransforms, true, true);
+}
+
+void UProjectileSubsystem::StartBenchmark(int32 Count, float Duration)
+{
+	Benchmark = FBenchmark();
+	Benchmark.Count = FMath::Clamp(Count, 1, MaxProjectiles);
+	Benchmark.Duration = FMath::Max(Duration, 1.0f);
+
+	// 从场景中的角色位置发射，射弹会与场景和角色实际发生扫掠
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		Benchmark.Origins.Add(It->GetActorLocation() + FVector(0.0f, 0.0f, 100.0f));
+	}
+	if (Benchmark.Origins.Num() == 0)
+	{
+		Benchmark.Origins.Add(FVector(0.0f, 0.0f, 200.0f));
+	}
+
+	Benchmark.bActive = true;
+
+	UE_LOG(LogProjectile, Display, TEXT("Projectile benchmark: %d projectiles in flight for %.0f s"), Benchmark.Count, Benchmark.Duration);
+}
+
+void UProjectileSubsystem::TickBenchmark(float Now, float DeltaTime)
+{
+	Benchmark.Elapsed += DeltaTime;
+	if (Benchmark.Elapsed >= Benchmark.Duration)
+	{
+		const double GameThreadMs = Benchmark.GameThreadSeconds * 1000.0;
+		UE_LOG(LogProjectile, Display, TEXT("Projectile benchmark: %d frames, %d in flight, game thread %.3f ms per frame"),
+			Benchmark.NumFrames, Positions.Num(), Benchmark.NumFrames > 0 ? GameThreadMs / Benchmark.NumFrames : 0.0);
+
+		Benchmark.bActive = false;
+		return;
+	}
+
+	// 补足到目标数量：无伤害、不复制，向上半球随机方向发射
+	FProjectileSpawn Spawn;
+	Spawn.SpawnTime = Now;
+	while (Positions.Num() < Benchmark.Count)
+	{
+		const FVector Direction = FMath::VRandCone(FVector::UpVector, FMath::DegreesToRadians(80.0f));
+		Spawn.Origin = Benchmark.Origins[FMath::RandHelper(Benchmark.Origins.Num())];
+		Spawn.Velocity = Direction * FMath::FRandRange(1500.0f, 4000.0f);
+
+		if (AddProjectile(Spawn, 0.0f) == INDEX_NONE)
+		{
+			break;
+		}
+	}
+}
+
+/** 控制台命令：射弹基准测试 */
+static FAutoConsoleCommandWithWorldAndArgs GProjectileBenchCommand(
+	TEXT("fpd.ProjectileBench"),
+	TEXT("射弹基准测试：fpd.ProjectileBench [数量=10000] [秒数=5]，结束时输出每帧游戏线程耗时"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UProjectileSubsystem* Projectiles = World ? World->GetSubsystem<UProjectileSubsystem>() : nullptr)
+		{
+			const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+			const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 5.0f;
+			Projectiles->StartBenchmark(Count, Duration);
+		}
+	}));
@@ -0,0 +1,155 @@
+// ProjectileSubsystem.h - 非Actor射弹：连续数组存储，每帧批量积分和异步扫掠，只复制生成参数
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/NetSerialization.h"
+#include "WorldCollision.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AFirstPersonDemoCharacter;
+class UInstancedStaticMeshComponent;
+
+/**
+ * 射弹生成参数 - 唯一需要复制的数据，轨迹由参数和时间确定
+ */
+USTRUCT()
+struct FProjectileSpawn
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Velocity;
+
+	/** 发射时的服务器时间 */
+	UPROPERTY()
+	float SpawnTime = 0.0f;
+
+	/** 射击者（客户端不与其碰撞，射击者自己的客户端已预测生成，不再接收） */
+	UPROPERTY()
+	TObjectPtr<AFirstPersonDemoCharacter> Shooter = nullptr;
+};
+
+/**
+ * 一次发给客户端的射弹生成批次
+ */
+USTRUCT()
+struct FProjectileSpawnBatch
+{
+	GENERATED_BODY()
+
+	/** 每个批次最多的射弹数（与装饰性事件批次相同，单个不可靠包不超过MTU） */
+	static constexpr int32 MaxSpawns = 24;
+
+	UPROPERTY()
+	TArray<FProjectileSpawn> Spawns;
+};
+
+/**
+ * 射弹子系统
+ *
+ * 射弹不是Actor，所有状态按字段存放在连续数组中。位置由生成参数解析计算
+ * （Origin + Velocity * t + 重力 * t² / 2），与帧率无关，服务器和客户端得到相同的轨迹。
+ * 每帧把本帧经过的线段作为武器通道的异步射线一次性发出，下一帧取回结果：
+ * 服务器用命中盒代理在当前服务器时间（即线段末端的时刻，不回溯）判定角色命中，通过现有伤害路径结算；
+ * 客户端只做表现，与角色胶囊体求交后停止，命中特效由服务器的装饰性事件给出。
+ */
+UCLASS()
+class UProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 射弹最长存活时间（秒） */
+	static constexpr float MaxLifetime = 3.0f;
+
+	/** 射弹数量上限 */
+	static constexpr int32 MaxProjectiles = 16384;
+
+	/** 重力加速度（与默认世界重力一致） */
+	static constexpr float GravityZ = -980.0f;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+	/** 发射射弹：服务器上造成伤害并复制给客户端；客户端上只做本地预测表现 */
+	void FireProjectile(AFirstPersonDemoCharacter* Shooter, const FVector& Origin, const FVector& Velocity, float SpawnTime, float Damage);
+
+	/** 客户端：接收服务器复制的射弹 */
+	void ReceiveSpawns(const FProjectileSpawnBatch& Batch);
+
+	/** 当前飞行中的射弹数 */
+	int32 GetNumProjectiles() const { return Positions.Num(); }
+
+	/** 服务器：丢弃所有飞行中的射弹和待复制的生成参数（比赛软重置时），返回丢弃的射弹数 */
+	int32 ClearProjectiles();
+
+	/** 基准测试：保持Count个无伤害射弹飞行Duration秒 */
+	void StartBenchmark(int32 Count, float Duration);
+
+private:
+	/** 添加一个射弹，返回索引（达到上限时返回INDEX_NONE） */
+	int32 AddProjectile(const FProjectileSpawn& Spawn, float Damage);
+
+	/** 交换删除一个射弹 */
+	void RemoveProjectile(int32 Index);
+
+	/** 取回上一帧的扫掠结果，处理命中和超时 */
+	void ResolveSweeps(float Now);
+
+	/** 按解析轨迹推进所有射弹 */
+	void Integrate(float Now);
+
+	/** 发出本帧线段的异步射线 */
+	void DispatchSweeps();
+
+	/** 服务器：把本帧的生成参数发给射击者与之相关的客户端，每个连接一个批次 */
+	void FlushSpawns();
+
+	/** 更新实例化网格 */
+	void UpdateRender();
+
+	/** 基准测试每帧补足射弹 */
+	void TickBenchmark(float Now, float DeltaTime);
+
+	/** 射弹状态（各数组按索引对应） */
+	TArray<FVector> Origins;
+	TArray<FVector> Velocities;
+	TArray<FVector> Positions;
+	TArray<FVector> PreviousPositions;
+	TArray<float> SpawnTimes;
+	TArray<float> Damages;
+	TArray<TWeakObjectPtr<AFirstPersonDemoCharacter>> Shooters;
+	TArray<FTraceHandle> TraceHandles;
+
+	/** 本帧线段末端对应的时间（即本帧的模拟时间，服务器在此时刻检测命中盒） */
+	float SweepTime = 0.0f;
+
+	/** 服务器：本帧待复制的生成参数 */
+	TArray<FProjectileSpawn> PendingSpawns;
+
+	/** 表现用的实例化网格（专用服务器不创建） */
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> RenderInstances;
+
+	/** 每帧复用的实例变换 */
+	TArray<FTransform> RenderTransforms;
+
+	/** 基准测试状态 */
+	struct FBenchmark
+	{
+		bool bActive = false;
+		int32 Count = 0;
+		float Duration = 0.0f;
+		float Elapsed = 0.0f;
+		int32 NumFrames = 0;
+		double GameThreadSeconds = 0.0;
+		TArray<FVector> Origins;
+	};
+	FBenchmark Benchmark;
+};
@@ -0,0 +1,361 @@
+// RpcRateLimiter.cpp - RPC令牌桶限流实现
+
+#include "RpcRateLimiter.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRpcLimiter, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPC Accepted"), STAT_RpcAccepted, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPC Dropped"), STAT_RpcDropped, STATGROUP_FirstPersonDemo);
+
+void FRpcTokenBucket::Configure(float InRefillRate, float InCapacity)
+{
+	RefillRate = InRefillRate;
+	Capacity = InCapacity;
+	Tokens = InCapacity;
+}
+
+bool FRpcTokenBucket::TryConsume(double Now)
+{
+	Tokens = FMath::Min(Capacity, Tokens + static_cast<float>(Now - LastRefillTime) * RefillRate);
+	LastRefillTime = Now;
+
+	if (Tokens < 1.0f)
+	{
+		++NumDropped;
+		INC_DWORD_STAT(STAT_RpcDropped);
+		return false;
+	}
+
+	Tokens -= 1.0f;
+	++NumAccepted;
+	INC_DWORD_STAT(STAT_RpcAccepted);
+	return true;
+}
+
+FRpcRateLimiter::FRpcRateLimiter()
+{
+	FireBatches.Configure(FireBatchRate, FireBatchBurst);
+}
+
+void FRpcRateLimiter::ConfigureFireRate(float FireRate)
+{
+	if (FireRate <= 0.0f || FMath::IsNearlyEqual(FireRate, ConfiguredFireRate))
+	{
+		return;
+	}
+
+	ConfiguredFireRate = FireRate;
+	Shots.Configure(FireRateSlack / FireRate, ShotBurst);
+}
+
+int32 FRpcRateLimiter::ProcessFireBatch(const FFireCommandBatch& Batch, double Now, uint16& InOutLastProcessedSequence,
+	TFunctionRef<void(const FFireCommand&)> ResolveShot)
+{
+	// 超额的包在任何检测之前丢弃
+	if (!FireBatches.TryConsume(Now))
+	{
+		return 0;
+	}
+
+	int32 NumResolved = 0;
+	for (const FFireCommand& Command : Batch.Commands)
+	{
+		// 跳过已处理过的冗余命令
+		if (!IsFireSequenceNewer(Command.Sequence, InOutLastProcessedSequence))
+		{
+			continue;
+		}
+
+		// 超出射速时停止：该命令及之后的命令不确认，客户端重发，令牌恢复后再处理或过期
+		if (!Shots.TryConsume(Now))
+		{
+			break;
+		}
+
+		InOutLastProcessedSequence = Command.Sequence;
+		ResolveShot(Command);
+		++NumResolved;
+	}
+
+	return NumResolved;
+}
+
+/** 控制台命令：输出每个角色的限流计数 */
+static FAutoConsoleCommandWithWorld GRpcLimiterStatsCommand(
+	TEXT("fpd.RpcLimiterStats"),
+	TEXT("输出每个角色的射击RPC限流计数（通过/丢弃）"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		for (TActorIterator<AFirstPersonDemoCharacter> It(World); It; ++It)
+		{
+			const FRpcRateLimiter& Limiter = It->GetFireRateLimiter();
+			UE_LOG(LogRpcLimiter, Display, TEXT("%s: FireBatches %u accepted / %u dropped, Shots %u accepted / %u dropped"),
+				*It->GetName(),
+				Limiter.FireBatches.NumAccepted, Limiter.FireBatches.NumDropped,
+				Limiter.Shots.NumAccepted, Limiter.Shots.NumDropped);
+		}
+	}));
+
+namespace RpcFloodTest
+{
+	constexpr double Duration = 10.0;
+	constexpr double FrameInterval = 1.0 / 60.0;
+	constexpr float FireRate = 0.1f;
+
+	/** 洪泛客户端每帧发送的命令包数：8个约为射速的48倍，17个约为102倍 */
+	constexpr int32 FloodBatchesPerFrame[] = { 8, 17 };
+
+	struct FResult
+	{
+		int32 NumFired = 0;
+		int32 NumResolved = 0;
+		int32 NumBatchesSent = 0;
+	};
+
+	/**
+	 * 模拟一个客户端向服务器限流器发送射击命令
+	 * bFlood 时每帧开火并发送 BatchesPerFrame 个命令包，否则按 FireRate 开火、由命令流决定何时发送；
+	 * 命令包有 LossRate 的概率丢失，确认延迟 AckDelayFrames 帧到达客户端。
+	 */
+	FResult Simulate(bool bFlood, int32 BatchesPerFrame, float LossRate, int32 AckDelayFrames)
+	{
+		FRandomStream Random(33);
+		FRpcRateLimiter Limiter;
+		Limiter.ConfigureFireRate(FireRate);
+
+		FFireCommandStream Stream;
+		uint16 LastProcessed = 0;
+		TArray<uint16> AckHistory;
+		FResult Result;
+
+		auto SendBatch = [&](double Now)
+		{
+			FFireCommandBatch Batch;
+			if (!Stream.BuildBatch(static_cast<float>(Now), static_cast<float>(Now), Batch))
+			{
+				return;
+			}
+
+			++Result.NumBatchesSent;
+			if (Random.FRand() >= LossRate)
+			{
+				Result.NumResolved += Limiter.ProcessFireBatch(Batch, Now, LastProcessed, [](const FFireCommand&) {});
+			}
+		};
+
+		double NextShotTime = 0.0;
+		for (double Now = 0.0; Now < Duration; Now += FrameInterval)
+		{
+			// 确认延迟若干帧到达客户端
+			AckHistory.Add(LastProcessed);
+			if (AckHistory.Num() > AckDelayFrames)
+			{
+				Stream.Acknowledge(AckHistory[AckHistory.Num() - 1 - AckDelayFrames]);
+			}
+
+			if (bFlood)
+			{
+				// 每个包都带一发新射击，无视重发间隔
+				for (int32 BatchIndex = 0; BatchIndex < BatchesPerFrame; ++BatchIndex)
+				{
+					Stream.Add(FVector::ZeroVector, FVector::ForwardVector, static_cast<float>(Now));
+					++Result.NumFired;
+					SendBatch(Now);
+				}
+				continue;
+			}
+
+			if (Now >= NextShotTime)
+			{
+				NextShotTime += FireRate;
+				Stream.Add(FVector::ZeroVector, FVector::ForwardVector, static_cast<float>(Now));
+				++Result.NumFired;
+			}
+			SendBatch(Now);
+		}
+
+		return Result;
+	}
+}
+
+namespace RpcFloodTiming
+{
+	/** 每个倍数持续的时间（秒） */
+	constexpr float PhaseDuration = 5.0f;
+
+	/** 相对武器射速的洪泛倍数 */
+	constexpr float Multipliers[] = { 1.0f, 48.0f, 100.0f };
+
+	/** 限流加判定每帧允许的平均耗时（毫秒） */
+	constexpr double MaxMeanFrameMs = 0.25;
+
+	/**
+	 * 在真实角色上计时：每帧按倍数生成射击命令包（每包一发新射击），逐个交给 ProcessFireBatch，
+	 * 计时包括限流、去重和 ServerResolveShot（命中扫描在本帧末批量检测，不计入）。
+	 */
+	struct FState
+	{
+		TWeakObjectPtr<AFirstPersonDemoCharacter> Character;
+		int32 Phase = 0;
+		float PhaseTime = 0.0f;
+		double PendingShots = 0.0;
+		uint16 NextSequence = 0;
+		int32 NumFrames = 0;
+		int32 NumBatches = 0;
+		int32 NumResolved = 0;
+		double TotalMs = 0.0;
+		double MaxMs = 0.0;
+		int32 NumFailed = 0;
+
+		void StartPhase(int32 InPhase)
+		{
+			const AFirstPersonDemoCharacter* Target = Character.Get();
+			Phase = InPhase;
+			PhaseTime = 0.0f;
+			PendingShots = 0.0;
+			NextSequence = Target ? static_cast<uint16>(Target->GetLastProcessedFireSequence() + 1) : 0;
+			NumFrames = 0;
+			NumBatches = 0;
+			NumResolved = 0;
+			TotalMs = 0.0;
+			MaxMs = 0.0;
+		}
+	};
+
+	/** 每帧调用，返回false时结束 */
+	bool Tick(FState& State, float DeltaTime)
+	{
+		AFirstPersonDemoCharacter* Character = State.Character.Get();
+		if (!Character)
+		{
+			UE_LOG(LogRpcLimiter, Warning, TEXT("FAIL RPC flood timing: character was destroyed"));
+			return false;
+		}
+
+		const float Multiplier = Multipliers[State.Phase];
+		State.PhaseTime += DeltaTime;
+		State.PendingShots += DeltaTime * Multiplier / Character->FireRate;
+
+		const FVector Origin = Character->GetPawnViewLocation();
+		const FVector Direction = Character->GetBaseAimRotation().Vector();
+		const float Now = Character->GetWorld()->GetTimeSeconds();
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (; State.PendingShots >= 1.0; State.PendingShots -= 1.0)
+		{
+			FFireCommandBatch Batch;
+			Batch.MatchEpoch = Character->GetFireMatchEpoch();
+			FFireCommand& Command = Batch.Commands.AddDefaulted_GetRef();
+			Command.Sequence = State.NextSequence++;
+			Command.ClientFireTime = Now;
+			Command.Origin = Origin;
+			Command.Direction = Direction;
+
+			State.NumResolved += Character->ProcessFireBatch(Batch);
+			++State.NumBatches;
+		}
+		const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		++State.NumFrames;
+		State.TotalMs += FrameMs;
+		State.MaxMs = FMath::Max(State.MaxMs, FrameMs);
+
+		if (State.PhaseTime < PhaseDuration)
+		{
+			return true;
+		}
+
+		// 限流允许的射击数上限：突发容量 + 持续时间内补充的令牌
+		const int32 MaxAllowedShots = FMath::FloorToInt(FRpcRateLimiter::ShotBurst + State.PhaseTime * FRpcRateLimiter::FireRateSlack / Character->FireRate);
+		const double MeanMs = State.TotalMs / FMath::Max(State.NumFrames, 1);
+		const bool bPassed = MeanMs <= MaxMeanFrameMs && State.NumResolved <= MaxAllowedShots;
+		State.NumFailed += bPassed ? 0 : 1;
+		UE_LOG(LogRpcLimiter, Display, TEXT("%s %.0fx fire rate: %d batches, %d resolved (limit %d), %.4f ms mean / %.4f ms max per frame (limit %.2f ms mean)"),
+			bPassed ? TEXT("PASS") : TEXT("FAIL"), Multiplier, State.NumBatches, State.NumResolved, MaxAllowedShots,
+			MeanMs, State.MaxMs, MaxMeanFrameMs);
+
+		if (State.Phase + 1 < static_cast<int32>(UE_ARRAY_COUNT(Multipliers)))
+		{
+			State.StartPhase(State.Phase + 1);
+			return true;
+		}
+
+		UE_LOG(LogRpcLimiter, Display, TEXT("RPC flood timing: %s"), State.NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+		return false;
+	}
+}
+
+/** 控制台命令：射击RPC洪泛测试，检查正常客户端的射击全部被处理、洪泛客户端被限制在射速之内，并在服务器角色上计时 */
+static FAutoConsoleCommandWithWorld GRpcFloodTestCommand(
+	TEXT("fpd.RpcFloodTest"),
+	TEXT("射击RPC限流测试：模拟正常开火（含丢包）和每帧大量开火的客户端，检查处理的射击数；服务器上有存活角色时再按1/48/100倍射速计时"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		using namespace RpcFloodTest;
+
+		// 限流允许的射击数上限：突发容量 + 持续时间内补充的令牌
+		const int32 MaxAllowedShots = FMath::FloorToInt(FRpcRateLimiter::ShotBurst + Duration * FRpcRateLimiter::FireRateSlack / FireRate);
+
+		int32 NumFailed = 0;
+
+		// 正常客户端：按射速开火，10%丢包，确认延迟6帧；所有射击都应被处理（只有最后几发可能还在途中）
+		const FResult Honest = Simulate(false, 1, 0.1f, 6);
+		const bool bHonestPassed = Honest.NumResolved >= Honest.NumFired - 1;
+		NumFailed += bHonestPassed ? 0 : 1;
+		UE_LOG(LogRpcLimiter, Display, TEXT("%s honest client: %d fired, %d resolved, %d batches"),
+			bHonestPassed ? TEXT("PASS") : TEXT("FAIL"), Honest.NumFired, Honest.NumResolved, Honest.NumBatchesSent);
+
+		// 洪泛客户端：每帧多个命令包，每个包一发新射击
+		for (int32 BatchesPerFrame : FloodBatchesPerFrame)
+		{
+			const FResult Flood = Simulate(true, BatchesPerFrame, 0.0f, 6);
+			const bool bFloodPassed = Flood.NumResolved <= MaxAllowedShots;
+			NumFailed += bFloodPassed ? 0 : 1;
+			UE_LOG(LogRpcLimiter, Display, TEXT("%s flooding client (%d batches/frame, %.0fx fire rate): %d fired, %d resolved (limit %d), %d batches"),
+				bFloodPassed ? TEXT("PASS") : TEXT("FAIL"), BatchesPerFrame, BatchesPerFrame * FireRate / FrameInterval,
+				Flood.NumFired, Flood.NumResolved, MaxAllowedShots, Flood.NumBatchesSent);
+		}
+
+		UE_LOG(LogRpcLimiter, Display, TEXT("RPC flood test: %s"), NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+
+		// 计时需要服务器上的存活角色（专用服务器用 -bots=1 生成）
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		AFirstPersonDemoCharacter* Character = nullptr;
+		for (TActorIterator<AFirstPersonDemoCharacter> It(World); It; ++It)
+		{
+			if (!It->IsDead())
+			{
+				Character = *It;
+				break;
+			}
+		}
+
+		if (!Character)
+		{
+			UE_LOG(LogRpcLimiter, Display, TEXT("RPC flood timing skipped: no living character on the server"));
+			return;
+		}
+
+		TSharedRef<RpcFloodTiming::FState> State = MakeShared<RpcFloodTiming::FState>();
+		State->Character = Character;
+		State->StartPhase(0);
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([State](float DeltaTime)
+		{
+			return RpcFloodTiming::Tick(*State, DeltaTime);
+		}));
+	}));
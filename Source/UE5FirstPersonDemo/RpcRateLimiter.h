@@ -0,0 +1,82 @@
+// RpcRateLimiter.h - 服务器RPC令牌桶限流，超额调用在任何射线检测之前被廉价丢弃
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireCommandStream.h"
+#include "Templates/Function.h"
+
+/**
+ * 令牌桶
+ *
+ * 以 RefillRate 个/秒补充令牌，最多累积 Capacity 个。每次调用消耗一个令牌，
+ * 没有令牌时拒绝。
+ */
+struct FRpcTokenBucket
+{
+	/** 桶容量（允许的突发数量） */
+	float Capacity = 10.0f;
+
+	/** 每秒补充的令牌数 */
+	float RefillRate = 10.0f;
+
+	/** 当前令牌数 */
+	float Tokens = 10.0f;
+
+	/** 上次补充时间 */
+	double LastRefillTime = 0.0;
+
+	/** 累计通过/丢弃次数 */
+	uint32 NumAccepted = 0;
+	uint32 NumDropped = 0;
+
+	/** 设置速率，桶保持满 */
+	void Configure(float InRefillRate, float InCapacity);
+
+	/** 尝试消耗一个令牌 */
+	bool TryConsume(double Now);
+};
+
+/**
+ * 每个角色的射击RPC限流器
+ *
+ * 挂在角色上而不是玩家控制器上，任何控制器（包括其他类型的控制器）驱动的角色都受限。
+ */
+struct FRpcRateLimiter
+{
+	/** 射击间隔之外允许的余量（网络抖动会让射击成堆到达） */
+	static constexpr float FireRateSlack = 1.25f;
+
+	/** 射击突发容量 */
+	static constexpr float ShotBurst = 6.0f;
+
+	/** 射击命令包：每帧最多一个新包，未确认时每50ms重发一次 */
+	static constexpr float FireBatchRate = 30.0f;
+	static constexpr float FireBatchBurst = 10.0f;
+
+	/** 射击命令包调用次数 */
+	FRpcTokenBucket FireBatches;
+
+	/** 实际射击次数（与武器射速绑定） */
+	FRpcTokenBucket Shots;
+
+	/** 当前射速对应的射击间隔 */
+	float ConfiguredFireRate = 0.0f;
+
+	FRpcRateLimiter();
+
+	/** 根据武器射击间隔调整射击令牌桶 */
+	void ConfigureFireRate(float FireRate);
+
+	/**
+	 * 服务器：按序处理命令包中的新命令
+	 *
+	 * 超额的命令包直接丢弃；射击令牌不足时停止处理，只确认已处理的命令，其余由客户端重发。
+	 * 返回本包处理的射击数。
+	 */
+	int32 ProcessFireBatch(const FFireCommandBatch& Batch, double Now, uint16& InOutLastProcessedSequence,
+		TFunctionRef<void(const FFireCommand&)> ResolveShot);
+
+	/** 是否有被丢弃的调用 */
+	uint32 GetNumDropped() const { return FireBatches.NumDropped + Shots.NumDropped; }
+};
@@ -0,0 +1,351 @@
+// ScoreLeaderboard.cpp - 排行榜索引实现与基准测试
+
+#include "ScoreLeaderboard.h"
+#include "FirstPersonDemoGameState.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLeaderboard, Log, All);
+
+FScoreLeaderboard::FScoreLeaderboard()
+	: Random(0x5C0DE)
+{
+}
+
+void FScoreLeaderboard::Update(int32 PlayerId, int32 Score)
+{
+	if (const int32* ExistingNode = PlayerNodes.Find(PlayerId))
+	{
+		const FNode& Node = Nodes[*ExistingNode];
+		if (Node.Score == Score)
+		{
+			return;
+		}
+
+		Root = Erase(Root, Node.Score, PlayerId);
+		FreeNodes.Add(*ExistingNode);
+	}
+
+	const int32 NewNode = AllocateNode();
+	FNode& Node = Nodes[NewNode];
+	Node.Score = Score;
+	Node.PlayerId = PlayerId;
+	Node.Priority = Random.GetUnsignedInt();
+	PlayerNodes.Add(PlayerId, NewNode);
+
+	int32 Left = INDEX_NONE;
+	int32 Right = INDEX_NONE;
+	Split(Root, Score, PlayerId, Left, Right);
+	Root = Merge(Merge(Left, NewNode), Right);
+
+	UpdateLeader();
+}
+
+void FScoreLeaderboard::Remove(int32 PlayerId)
+{
+	int32 NodeIndex = INDEX_NONE;
+	if (!PlayerNodes.RemoveAndCopyValue(PlayerId, NodeIndex))
+	{
+		return;
+	}
+
+	Root = Erase(Root, Nodes[NodeIndex].Score, PlayerId);
+	FreeNodes.Add(NodeIndex);
+
+	UpdateLeader();
+}
+
+void FScoreLeaderboard::Reset()
+{
+	Nodes.Reset();
+	FreeNodes.Reset();
+	PlayerNodes.Reset();
+	Root = INDEX_NONE;
+	LeaderPlayerId = INDEX_NONE;
+}
+
+int32 FScoreLeaderboard::GetRank(int32 PlayerId) const
+{
+	const int32* NodeIndex = PlayerNodes.Find(PlayerId);
+	if (!NodeIndex)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Score = Nodes[*NodeIndex].Score;
+
+	// 从根向下查找，累计排在前面的节点数
+	int32 Rank = 0;
+	int32 Current = Root;
+	while (Current != INDEX_NONE)
+	{
+		const FNode& Node = Nodes[Current];
+		if (Node.PlayerId == PlayerId)
+		{
+			return Rank + SizeOf(Node.Left);
+		}
+
+		if (IsBefore(Node, Score, PlayerId))
+		{
+			Rank += SizeOf(Node.Left) + 1;
+			Current = Node.Right;
+		}
+		else
+		{
+			Current = Node.Left;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+int32 FScoreLeaderboard::GetPlayerAtRank(int32 Rank) const
+{
+	if (Rank < 0 || Rank >= SizeOf(Root))
+	{
+		return INDEX_NONE;
+	}
+
+	int32 Current = Root;
+	while (Current != INDEX_NONE)
+	{
+		const FNode& Node = Nodes[Current];
+		const int32 LeftSize = SizeOf(Node.Left);
+		if (Rank < LeftSize)
+		{
+			Current = Node.Left;
+		}
+		else if (Rank == LeftSize)
+		{
+			return Node.PlayerId;
+		}
+		else
+		{
+			Rank -= LeftSize + 1;
+			Current = Node.Right;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void FScoreLeaderboard::GetTopPlayers(int32 Count, TArray<int32>& OutPlayerIds) const
+{
+	OutPlayerIds.Reset();
+	Count = FMath::Min(Count, SizeOf(Root));
+	if (Count <= 0)
+	{
+		return;
+	}
+	OutPlayerIds.Reserve(Count);
+
+	// 中序遍历，取够Count个即停止
+	TArray<int32, TInlineAllocator<64>> Stack;
+	int32 Current = Root;
+	while ((Current != INDEX_NONE || Stack.Num() > 0) && OutPlayerIds.Num() < Count)
+	{
+		while (Current != INDEX_NONE)
+		{
+			Stack.Push(Current);
+			Current = Nodes[Current].Left;
+		}
+
+		Current = Stack.Pop(false);
+		OutPlayerIds.Add(Nodes[Current].PlayerId);
+		Current = Nodes[Current].Right;
+	}
+}
+
+int32 FScoreLeaderboard::Merge(int32 A, int32 B)
+{
+	if (A == INDEX_NONE)
+	{
+		return B;
+	}
+	if (B == INDEX_NONE)
+	{
+		return A;
+	}
+
+	if (Nodes[A].Priority > Nodes[B].Priority)
+	{
+		Nodes[A].Right = Merge(Nodes[A].Right, B);
+		UpdateSize(A);
+		return A;
+	}
+
+	Nodes[B].Left = Merge(A, Nodes[B].Left);
+	UpdateSize(B);
+	return B;
+}
+
+void FScoreLeaderboard::Split(int32 InRoot, int32 Score, int32 PlayerId, int32& OutLeft, int32& OutRight)
+{
+	if (InRoot == INDEX_NONE)
+	{
+		OutLeft = INDEX_NONE;
+		OutRight = INDEX_NONE;
+		return;
+	}
+
+	if (IsBefore(Nodes[InRoot], Score, PlayerId))
+	{
+		int32 SplitLeft = INDEX_NONE;
+		Split(Nodes[InRoot].Right, Score, PlayerId, SplitLeft, OutRight);
+		Nodes[InRoot].Right = SplitLeft;
+		OutLeft = InRoot;
+	}
+	else
+	{
+		int32 SplitRight = INDEX_NONE;
+		Split(Nodes[InRoot].Left, Score, PlayerId, OutLeft, SplitRight);
+		Nodes[InRoot].Left = SplitRight;
+		OutRight = InRoot;
+	}
+
+	UpdateSize(InRoot);
+}
+
+int32 FScoreLeaderboard::Erase(int32 InRoot, int32 Score, int32 PlayerId)
+{
+	if (InRoot == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	FNode& Node = Nodes[InRoot];
+	if (Node.PlayerId == PlayerId)
+	{
+		return Merge(Node.Left, Node.Right);
+	}
+
+	if (IsBefore(Node, Score, PlayerId))
+	{
+		const int32 NewRight = Erase(Node.Right, Score, PlayerId);
+		Nodes[InRoot].Right = NewRight;
+	}
+	else
+	{
+		const int32 NewLeft = Erase(Node.Left, Score, PlayerId);
+		Nodes[InRoot].Left = NewLeft;
+	}
+
+	UpdateSize(InRoot);
+	return InRoot;
+}
+
+void FScoreLeaderboard::UpdateLeader()
+{
+	int32 Current = Root;
+	while (Current != INDEX_NONE && Nodes[Current].Left != INDEX_NONE)
+	{
+		Current = Nodes[Current].Left;
+	}
+
+	LeaderPlayerId = Current != INDEX_NONE ? Nodes[Current].PlayerId : INDEX_NONE;
+}
+
+int32 FScoreLeaderboard::AllocateNode()
+{
+	if (FreeNodes.Num() > 0)
+	{
+		const int32 NodeIndex = FreeNodes.Pop(false);
+		Nodes[NodeIndex] = FNode();
+		return NodeIndex;
+	}
+
+	return Nodes.AddDefaulted();
+}
+
+/** 控制台命令：排行榜基准测试，对比原先的“线性查找 + 复制整表排序”与增量索引，并校验结果一致 */
+static FAutoConsoleCommand GLeaderboardBenchCommand(
+	TEXT("fpd.LeaderboardBench"),
+	TEXT("排行榜基准测试：fpd.LeaderboardBench [玩家数=1000] [更新次数=20000]，输出两种方式的每次更新耗时"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumPlayers = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000, 1);
+		const int32 NumUpdates = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20000, 1);
+
+		// 两种方式使用相同的更新序列：随机玩家获得击杀分
+		FRandomStream Random(1000);
+		TArray<TPair<int32, int32>> Updates;
+		Updates.Reserve(NumUpdates);
+		TArray<int32> Scores;
+		Scores.SetNumZeroed(NumPlayers);
+		for (int32 Index = 0; Index < NumUpdates; ++Index)
+		{
+			const int32 PlayerId = Random.RandHelper(NumPlayers);
+			Scores[PlayerId] += Random.RandRange(1, 3) * 50;
+			Updates.Emplace(PlayerId, Scores[PlayerId]);
+		}
+
+		// 原方式：按名字线性查找，每次更新复制整个数组并排序
+		TArray<FPlayerScoreData> PlayerScores;
+		TArray<FPlayerScoreData> SortedPlayerScores;
+		for (int32 PlayerId = 0; PlayerId < NumPlayers; ++PlayerId)
+		{
+			FPlayerScoreData& ScoreData = PlayerScores.AddDefaulted_GetRef();
+			ScoreData.PlayerName = FString::Printf(TEXT("Player%d"), PlayerId);
+			ScoreData.PlayerId = PlayerId;
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for (const TPair<int32, int32>& Update : Updates)
+		{
+			const FString PlayerName = FString::Printf(TEXT("Player%d"), Update.Key);
+			for (FPlayerScoreData& ScoreData : PlayerScores)
+			{
+				if (ScoreData.PlayerName == PlayerName)
+				{
+					ScoreData.Score = Update.Value;
+					break;
+				}
+			}
+
+			SortedPlayerScores = PlayerScores;
+			SortedPlayerScores.Sort([](const FPlayerScoreData& A, const FPlayerScoreData& B)
+			{
+				return A.Score > B.Score || (A.Score == B.Score && A.PlayerId < B.PlayerId);
+			});
+		}
+		const double OldSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// 增量索引
+		FScoreLeaderboard Leaderboard;
+		for (int32 PlayerId = 0; PlayerId < NumPlayers; ++PlayerId)
+		{
+			Leaderboard.Update(PlayerId, 0);
+		}
+
+		StartTime = FPlatformTime::Seconds();
+		for (const TPair<int32, int32>& Update : Updates)
+		{
+			Leaderboard.Update(Update.Key, Update.Value);
+		}
+		const double NewSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// 查询耗时：每个玩家的排名 + 前10名
+		TArray<int32> TopPlayers;
+		StartTime = FPlatformTime::Seconds();
+		int64 RankSum = 0;
+		for (int32 PlayerId = 0; PlayerId < NumPlayers; ++PlayerId)
+		{
+			RankSum += Leaderboard.GetRank(PlayerId);
+		}
+		Leaderboard.GetTopPlayers(10, TopPlayers);
+		const double QuerySeconds = FPlatformTime::Seconds() - StartTime;
+
+		// 校验：排名、前10名和领先者与完整排序一致
+		bool bMatches = Leaderboard.GetLeader() == SortedPlayerScores[0].PlayerId;
+		for (int32 Rank = 0; Rank < SortedPlayerScores.Num() && bMatches; ++Rank)
+		{
+			bMatches = Leaderboard.GetRank(SortedPlayerScores[Rank].PlayerId) == Rank
+				&& Leaderboard.GetPlayerAtRank(Rank) == SortedPlayerScores[Rank].PlayerId
+				&& (Rank >= TopPlayers.Num() || TopPlayers[Rank] == SortedPlayerScores[Rank].PlayerId);
+		}
+
+		UE_LOG(LogLeaderboard, Display, TEXT("Leaderboard benchmark: %d players, %d updates"), NumPlayers, NumUpdates);
+		UE_LOG(LogLeaderboard, Display, TEXT("  Linear find + copy + sort: %.3f us/update"), OldSeconds * 1e6 / NumUpdates);
+		UE_LOG(LogLeaderboard, Display, TEXT("  Incremental ranked index:  %.3f us/update, %.3f us/rank query (rank sum %lld)"),
+			NewSeconds * 1e6 / NumUpdates, QuerySeconds * 1e6 / NumPlayers, RankSum);
+		UE_LOG(LogLeaderboard, Display, TEXT("  Ranking check: %s"), bMatches ? TEXT("matches full sort") : TEXT("MISMATCH"));
+	}));
@@ -0,0 +1,95 @@
+// ScoreLeaderboard.h - 增量排行榜索引：按玩家ID更新分数，O(log n)排名与前K名查询
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 排行榜索引
+ *
+ * 节点池中的顺序统计Treap，按（分数降序, 玩家ID升序）排列，每个节点记录子树大小。
+ * 更新分数只删除并重新插入一个节点，不复制、不整体排序；领先者在每次修改后缓存。
+ * - 更新 / 删除：O(log n)
+ * - 领先者：O(1)
+ * - 玩家排名、指定名次：O(log n)
+ * - 前K名：O(log n + K)
+ */
+class FScoreLeaderboard
+{
+public:
+	FScoreLeaderboard();
+
+	/** 设置玩家分数（不存在时插入） */
+	void Update(int32 PlayerId, int32 Score);
+
+	/** 移除玩家 */
+	void Remove(int32 PlayerId);
+
+	/** 清空 */
+	void Reset();
+
+	/** 玩家数 */
+	int32 Num() const { return PlayerNodes.Num(); }
+
+	/** 是否包含玩家 */
+	bool Contains(int32 PlayerId) const { return PlayerNodes.Contains(PlayerId); }
+
+	/** 领先玩家ID（为空时返回INDEX_NONE） */
+	int32 GetLeader() const { return LeaderPlayerId; }
+
+	/** 玩家排名（从0开始，不存在时返回INDEX_NONE） */
+	int32 GetRank(int32 PlayerId) const;
+
+	/** 指定名次的玩家ID（从0开始，越界时返回INDEX_NONE） */
+	int32 GetPlayerAtRank(int32 Rank) const;
+
+	/** 按名次输出前Count名的玩家ID */
+	void GetTopPlayers(int32 Count, TArray<int32>& OutPlayerIds) const;
+
+private:
+	struct FNode
+	{
+		int32 Score = 0;
+		int32 PlayerId = INDEX_NONE;
+		uint32 Priority = 0;
+		int32 Left = INDEX_NONE;
+		int32 Right = INDEX_NONE;
+		int32 Size = 1;
+	};
+
+	/** 节点A是否排在（Score, PlayerId）之前 */
+	static bool IsBefore(const FNode& Node, int32 Score, int32 PlayerId)
+	{
+		return Node.Score > Score || (Node.Score == Score && Node.PlayerId < PlayerId);
+	}
+
+	int32 SizeOf(int32 Node) const { return Node == INDEX_NONE ? 0 : Nodes[Node].Size; }
+	void UpdateSize(int32 Node) { Nodes[Node].Size = 1 + SizeOf(Nodes[Node].Left) + SizeOf(Nodes[Node].Right); }
+
+	/** 合并两棵树（A的所有节点排在B之前） */
+	int32 Merge(int32 A, int32 B);
+
+	/** 按键拆分：Left为排在（Score, PlayerId）之前的节点，Right为其余节点 */
+	void Split(int32 Root, int32 Score, int32 PlayerId, int32& OutLeft, int32& OutRight);
+
+	/** 从子树中删除指定键的节点，返回新的子树根 */
+	int32 Erase(int32 Root, int32 Score, int32 PlayerId);
+
+	/** 重新缓存领先者 */
+	void UpdateLeader();
+
+	int32 AllocateNode();
+
+	/** 节点池 */
+	TArray<FNode> Nodes;
+	TArray<int32> FreeNodes;
+
+	/** 玩家ID到节点的索引 */
+	TMap<int32, int32> PlayerNodes;
+
+	int32 Root = INDEX_NONE;
+	int32 LeaderPlayerId = INDEX_NONE;
+
+	/** 固定种子，结果可复现 */
+	FRandomStream Random;
+};
@@ -0,0 +1,32 @@
+// SpawnPointComponent.cpp - 出生点组件实现
+
+#include "SpawnPointComponent.h"
+#include "SpawnPointSubsystem.h"
+#include "Engine/World.h"
+
+USpawnPointComponent::USpawnPointComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	Type = ESpawnPointType::Enemy;
+}
+
+void USpawnPointComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (USpawnPointSubsystem* SpawnPoints = GetWorld()->GetSubsystem<USpawnPointSubsystem>())
+	{
+		SpawnPoints->RegisterSpawnPoint(this);
+	}
+}
+
+void USpawnPointComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USpawnPointSubsystem* SpawnPoints = GetWorld()->GetSubsystem<USpawnPointSubsystem>())
+	{
+		SpawnPoints->UnregisterSpawnPoint(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,32 @@
+// SpawnPointComponent.h - 出生点组件：挂在出生点Actor上，开始时注册到出生点子系统，结束时注销
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SpawnPointManifest.h"
+#include "SpawnPointComponent.generated.h"
+
+/**
+ * 出生点组件
+ *
+ * 取代 "EnemySpawn" / "PlayerStart" 标签：游戏模式不再遍历整个世界查找带标签的Actor，
+ * 而是从 USpawnPointSubsystem 读取已注册的出生点。World Partition单元流入时其中的出生点
+ * 自动注册，流出时注销。
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class USpawnPointComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USpawnPointComponent();
+
+	/** 出生点类型 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Spawn)
+	ESpawnPointType Type;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -0,0 +1,213 @@
+// SpawnPointManifest.cpp - 出生点清单实现与编辑器烘焙
+
+#include "SpawnPointManifest.h"
+#include "SpawnPointComponent.h"
+#include "ThreatMapSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+#if WITH_EDITOR
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/WorldPartitionActorDesc.h"
+#include "WorldPartition/WorldPartitionHelpers.h"
+#endif
+
+const FPrimaryAssetType USpawnPointManifest::PrimaryAssetType(TEXT("SpawnPointManifest"));
+const TCHAR* USpawnPointManifest::AssetSuffix = TEXT("_SpawnPoints");
+
+FPrimaryAssetId USpawnPointManifest::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+bool USpawnPointManifest::HasValidSight() const
+{
+	return SightCellSize == UThreatMapSubsystem::CellSize && SightRadius == UThreatMapSubsystem::SightRadius;
+}
+
+void FSpawnPointLocationSet::Add(ESpawnPointType Type, const FVector& Location, int32 Index)
+{
+	Cells.Add(GetCell(Location), FItem{ Type, Location, Index });
+}
+
+int32 FSpawnPointLocationSet::FindNear(ESpawnPointType Type, const FVector& Location) const
+{
+	// 格子边长等于匹配距离，距离内的点一定在相邻的27个格子中
+	const FIntVector Cell = GetCell(Location);
+	for (int32 Z = -1; Z <= 1; ++Z)
+	{
+		for (int32 Y = -1; Y <= 1; ++Y)
+		{
+			for (int32 X = -1; X <= 1; ++X)
+			{
+				for (auto It = Cells.CreateConstKeyIterator(Cell + FIntVector(X, Y, Z)); It; ++It)
+				{
+					const FItem& Item = It.Value();
+					if (Item.Type == Type && FVector::DistSquared(Item.Location, Location) <= FMath::Square(MergeTolerance))
+					{
+						return Item.Index;
+					}
+				}
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+FIntVector FSpawnPointLocationSet::GetCell(const FVector& Location)
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / MergeTolerance),
+		FMath::FloorToInt(Location.Y / MergeTolerance),
+		FMath::FloorToInt(Location.Z / MergeTolerance));
+}
+
+#if WITH_EDITOR
+bool USpawnPointManifest::MakeEntry(const AActor* Actor, FSpawnPointEntry& OutEntry)
+{
+	static const FName EnemySpawnTag(TEXT("EnemySpawn"));
+	static const FName PlayerStartTag(TEXT("PlayerStart"));
+
+	OutEntry = FSpawnPointEntry();
+	OutEntry.Location = Actor->GetActorLocation();
+
+	// 组件优先，其次兼容尚未迁移的标签
+	if (const USpawnPointComponent* SpawnPoint = Actor->FindComponentByClass<USpawnPointComponent>())
+	{
+		OutEntry.Type = SpawnPoint->Type;
+	}
+	else if (Actor->ActorHasTag(EnemySpawnTag))
+	{
+		OutEntry.Type = ESpawnPointType::Enemy;
+	}
+	else if (Actor->ActorHasTag(PlayerStartTag))
+	{
+		OutEntry.Type = ESpawnPointType::Player;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+void USpawnPointManifest::Validate(UWorld* World, int32& OutNumMissing, int32& OutNumStale) const
+{
+	OutNumMissing = 0;
+	OutNumStale = 0;
+	if (!World)
+	{
+		return;
+	}
+
+	FSpawnPointLocationSet ManifestPoints;
+	for (int32 Index = 0; Index < SpawnPoints.Num(); ++Index)
+	{
+		ManifestPoints.Add(SpawnPoints[Index].Type, SpawnPoints[Index].Location, Index);
+	}
+
+	FSpawnPointLocationSet WorldPoints;
+	int32 NumWorldPoints = 0;
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		FSpawnPointEntry Entry;
+		if (MakeEntry(*It, Entry))
+		{
+			WorldPoints.Add(Entry.Type, Entry.Location, NumWorldPoints++);
+			if (ManifestPoints.FindNear(Entry.Type, Entry.Location) == INDEX_NONE)
+			{
+				++OutNumMissing;
+			}
+		}
+	}
+
+	// World Partition地图只加载了部分Actor，清单中的点找不到Actor不代表已删除
+	if (!World->GetWorldPartition())
+	{
+		for (const FSpawnPointEntry& Entry : SpawnPoints)
+		{
+			if (WorldPoints.FindNear(Entry.Type, Entry.Location) == INDEX_NONE)
+			{
+				++OutNumStale;
+			}
+		}
+	}
+}
+
+void USpawnPointManifest::Rebuild(UWorld* World)
+{
+	SpawnPoints.Reset();
+	SightCellSize = 0.0f;
+	SightRadius = 0;
+	if (!World)
+	{
+		return;
+	}
+
+	auto AddActor = [this](const AActor* Actor)
+	{
+		FSpawnPointEntry Entry;
+		if (MakeEntry(Actor, Entry))
+		{
+			SpawnPoints.Add(Entry);
+		}
+	};
+
+	// 全部几何体加载时检测敌人生成点的视线，运行时的影响图直接使用
+	auto BakeSight = [this, World]()
+	{
+		for (FSpawnPointEntry& Entry : SpawnPoints)
+		{
+			if (Entry.Type == ESpawnPointType::Enemy)
+			{
+				UThreatMapSubsystem::TraceSight(World, Entry.Location, Entry.SightMask);
+			}
+		}
+		SightCellSize = UThreatMapSubsystem::CellSize;
+		SightRadius = UThreatMapSubsystem::SightRadius;
+	};
+
+	if (UWorldPartition* WorldPartition = World->GetWorldPartition())
+	{
+		// 加载全部Actor并保持引用，未加载单元中的出生点也会收录，视线检测也不会穿过未加载的几何体
+		FWorldPartitionHelpers::FForEachActorWithLoadingParams Params;
+		Params.bKeepReferences = true;
+		Params.OnReleasingActorReferences = BakeSight;
+
+		FWorldPartitionHelpers::ForEachActorWithLoading(WorldPartition, [&AddActor](const FWorldPartitionActorDesc* ActorDesc)
+		{
+			if (const AActor* Actor = ActorDesc->GetActor())
+			{
+				AddActor(Actor);
+			}
+			return true;
+		}, Params);
+	}
+	else
+	{
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			AddActor(*It);
+		}
+		BakeSight();
+	}
+
+	// 排序后内容与Actor加载顺序无关，重复烘焙不产生差异
+	SpawnPoints.Sort([](const FSpawnPointEntry& A, const FSpawnPointEntry& B)
+	{
+		if (A.Type != B.Type)
+		{
+			return A.Type < B.Type;
+		}
+		if (A.Location.X != B.Location.X)
+		{
+			return A.Location.X < B.Location.X;
+		}
+		if (A.Location.Y != B.Location.Y)
+		{
+			return A.Location.Y < B.Location.Y;
+		}
+		return A.Location.Z < B.Location.Z;
+	});
+}
+#endif
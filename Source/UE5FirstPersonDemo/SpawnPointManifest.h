@@ -0,0 +1,121 @@
+// SpawnPointManifest.h - 出生点清单：在编辑器中为地图烘焙的全部出生点，运行时先于任何单元流送可用
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SpawnPointManifest.generated.h"
+
+/**
+ * 出生点类型
+ */
+UENUM(BlueprintType)
+enum class ESpawnPointType : uint8
+{
+	/** 敌人生成点（原 "EnemySpawn" 标签） */
+	Enemy,
+	/** 玩家出生点（原 "PlayerStart" 标签） */
+	Player
+};
+
+/**
+ * 一个出生点
+ */
+USTRUCT(BlueprintType)
+struct FSpawnPointEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Spawn)
+	ESpawnPointType Type = ESpawnPointType::Enemy;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Spawn)
+	FVector Location = FVector::ZeroVector;
+
+	/** 敌人生成点的视线掩码（按 UThreatMapSubsystem::GetSightOffsets 的顺序每位一个格子，空表示未烘焙） */
+	UPROPERTY()
+	TArray<uint64> SightMask;
+};
+
+/**
+ * 按距离匹配出生点的集合
+ *
+ * 以匹配距离为边长的空间哈希，查询时检查相邻的格子，落在量化边界两侧的同一个点也能匹配。
+ */
+class FSpawnPointLocationSet
+{
+public:
+	/** 两个同类型的点距离不超过此值时视为同一个点 */
+	static constexpr float MergeTolerance = 10.0f;
+
+	void Add(ESpawnPointType Type, const FVector& Location, int32 Index);
+
+	/** 同类型且距离不超过 MergeTolerance 的点的索引，没有时返回INDEX_NONE */
+	int32 FindNear(ESpawnPointType Type, const FVector& Location) const;
+
+private:
+	struct FItem
+	{
+		ESpawnPointType Type;
+		FVector Location;
+		int32 Index;
+	};
+
+	static FIntVector GetCell(const FVector& Location);
+
+	TMultiMap<FIntVector, FItem> Cells;
+};
+
+/**
+ * 出生点清单 - 主数据资产
+ *
+ * 每张地图一份，命名为 <地图名>_SpawnPoints，放在 USpawnPointSubsystem 配置的目录下。
+ * 在编辑器中用 fpd.BakeSpawnManifest 从地图烘焙（World Partition地图会逐个加载全部Actor），
+ * 资产管理器按 AlwaysCook 规则随游戏烘焙。保存或烘焙地图时与地图中的出生点比较，过期时输出警告。
+ * 运行时在世界初始化时加载，
+ * 因此未流送单元中的出生点在比赛初始化时同样可用。
+ * 烘焙时全部Actor保持加载，同时为敌人生成点检测威胁影响图的视线，运行时不再做这些射线检测。
+ */
+UCLASS(BlueprintType)
+class USpawnPointManifest : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** 主资产类型 */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	/** 清单资产名后缀 */
+	static const TCHAR* AssetSuffix;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+#if WITH_EDITOR
+	/** 从编辑器世界重建清单：带出生点组件或旧标签的Actor都会收录 */
+	void Rebuild(UWorld* World);
+
+	/**
+	 * 与编辑器世界中已加载的出生点比较：OutNumMissing 为世界中有、清单中没有的点，
+	 * OutNumStale 为清单中有、世界中已不存在的点（World Partition地图未加载的Actor无法确认，只统计前者）
+	 */
+	void Validate(UWorld* World, int32& OutNumMissing, int32& OutNumStale) const;
+
+	/** Actor对应的出生点（带出生点组件或旧标签），不是出生点时返回false */
+	static bool MakeEntry(const AActor* Actor, FSpawnPointEntry& OutEntry);
+#endif
+
+	/** 烘焙的视线是否与当前影响图的格子大小和视线半径一致 */
+	bool HasValidSight() const;
+
+	/** 全部出生点 */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Spawn)
+	TArray<FSpawnPointEntry> SpawnPoints;
+
+	/** 烘焙视线时的格子边长（0表示没有烘焙视线） */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Spawn)
+	float SightCellSize = 0.0f;
+
+	/** 烘焙视线时的视线半径（格） */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Spawn)
+	int32 SightRadius = 0;
+};
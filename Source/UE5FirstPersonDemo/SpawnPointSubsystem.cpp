@@ -0,0 +1,310 @@
+// SpawnPointSubsystem.cpp - 出生点注册表实现、清单烘焙与初始化基准测试
+
+#include "SpawnPointSubsystem.h"
+#include "SpawnPointComponent.h"
+#include "ThreatMapSubsystem.h"
+#include "FirstPersonDemoGameMode.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/PackageName.h"
+
+#if WITH_EDITOR
+#include "Misc/DelayedAutoRegister.h"
+#include "UObject/ObjectSaveContext.h"
+#include "UObject/SavePackage.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogSpawnPoints, Log, All);
+
+USpawnPointSubsystem::USpawnPointSubsystem()
+{
+	ManifestDirectory = TEXT("/Game/Data/SpawnPoints");
+}
+
+void USpawnPointSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// 清单很小，在世界初始化时同步加载；地图没有烘焙清单时只使用运行时注册的点
+	const FString PackageName = GetManifestPackageName(GetWorld());
+	if (!PackageName.IsEmpty() && FPackageName::DoesPackageExist(PackageName))
+	{
+		const FString ObjectPath = PackageName + TEXT(".") + FPackageName::GetShortName(PackageName);
+		Manifest = LoadObject<USpawnPointManifest>(nullptr, *ObjectPath);
+	}
+
+	// 视线按格子大小和视线半径烘焙，参数改变后需要重新烘焙
+	if (Manifest && Manifest->HasValidSight())
+	{
+		for (int32 Index = 0; Index < Manifest->SpawnPoints.Num(); ++Index)
+		{
+			const FSpawnPointEntry& Entry = Manifest->SpawnPoints[Index];
+			if (Entry.Type == ESpawnPointType::Enemy && Entry.SightMask.Num() == UThreatMapSubsystem::GetNumSightWords())
+			{
+				BakedSightIndices.Add(Entry.Location, Index);
+			}
+		}
+	}
+	else if (Manifest)
+	{
+		UE_LOG(LogSpawnPoints, Warning, TEXT("Spawn point manifest %s has no sight baked for the current threat map settings; run fpd.BakeSpawnManifest"), *PackageName);
+	}
+
+	UE_LOG(LogSpawnPoints, Log, TEXT("Spawn point manifest %s: %d points, %d with baked sight"),
+		*PackageName, Manifest ? Manifest->SpawnPoints.Num() : 0, BakedSightIndices.Num());
+}
+
+void USpawnPointSubsystem::Deinitialize()
+{
+	RegisteredPoints.Reset();
+	BakedSightIndices.Reset();
+	Manifest = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool USpawnPointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USpawnPointSubsystem::RegisterSpawnPoint(USpawnPointComponent* SpawnPoint)
+{
+	if (!SpawnPoint || !SpawnPoint->GetOwner())
+	{
+		return;
+	}
+
+	FSpawnPointEntry& Entry = RegisteredPoints.FindOrAdd(SpawnPoint);
+	Entry.Type = SpawnPoint->Type;
+	Entry.Location = SpawnPoint->GetOwner()->GetActorLocation();
+}
+
+void USpawnPointSubsystem::UnregisterSpawnPoint(USpawnPointComponent* SpawnPoint)
+{
+	RegisteredPoints.Remove(SpawnPoint);
+}
+
+void USpawnPointSubsystem::GetSpawnLocations(ESpawnPointType Type, TArray<FVector>& OutLocations) const
+{
+	OutLocations.Reset();
+
+	FSpawnPointLocationSet ManifestLocations;
+	if (Manifest)
+	{
+		for (const FSpawnPointEntry& Entry : Manifest->SpawnPoints)
+		{
+			if (Entry.Type == Type)
+			{
+				ManifestLocations.Add(Type, Entry.Location, OutLocations.Add(Entry.Location));
+			}
+		}
+	}
+
+	// 清单之外的点：烘焙之后新增的，或运行时生成的出生点（按距离匹配清单中的点）
+	int32 NumUnbaked = 0;
+	for (const TPair<TWeakObjectPtr<USpawnPointComponent>, FSpawnPointEntry>& Pair : RegisteredPoints)
+	{
+		if (Pair.Value.Type == Type && ManifestLocations.FindNear(Type, Pair.Value.Location) == INDEX_NONE)
+		{
+			OutLocations.Add(Pair.Value.Location);
+			++NumUnbaked;
+		}
+	}
+
+	if (Manifest && NumUnbaked > 0)
+	{
+		UE_LOG(LogSpawnPoints, Warning, TEXT("%d registered %s spawn points are not in the manifest, it is out of date; run fpd.BakeSpawnManifest"),
+			NumUnbaked, Type == ESpawnPointType::Enemy ? TEXT("enemy") : TEXT("player"));
+	}
+}
+
+const TArray<uint64>* USpawnPointSubsystem::FindBakedSight(const FVector& Location) const
+{
+	const int32* Index = BakedSightIndices.Find(Location);
+	return Index ? &Manifest->SpawnPoints[*Index].SightMask : nullptr;
+}
+
+FString USpawnPointSubsystem::GetManifestPackageName(const UWorld* World)
+{
+	if (!World)
+	{
+		return FString();
+	}
+
+	const FString MapName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()));
+	return GetDefault<USpawnPointSubsystem>()->ManifestDirectory / (MapName + USpawnPointManifest::AssetSuffix);
+}
+
+#if WITH_EDITOR
+namespace SpawnManifestValidation
+{
+	/** 保存或烘焙地图时检查出生点清单是否与地图一致，过期的清单会让运行时漏掉或多出出生点 */
+	void OnPreSaveWorld(UWorld* World, FObjectPreSaveContext SaveContext)
+	{
+		if (!World || World->IsGameWorld())
+		{
+			return;
+		}
+
+		// 没有烘焙清单的地图只使用运行时注册的点，无需检查
+		const FString PackageName = USpawnPointSubsystem::GetManifestPackageName(World);
+		if (PackageName.IsEmpty() || !FPackageName::DoesPackageExist(PackageName))
+		{
+			return;
+		}
+
+		const FString ObjectPath = PackageName + TEXT(".") + FPackageName::GetShortName(PackageName);
+		const USpawnPointManifest* Manifest = LoadObject<USpawnPointManifest>(nullptr, *ObjectPath);
+		if (!Manifest)
+		{
+			return;
+		}
+
+		int32 NumMissing = 0;
+		int32 NumStale = 0;
+		Manifest->Validate(World, NumMissing, NumStale);
+		if (NumMissing > 0 || NumStale > 0 || !Manifest->HasValidSight())
+		{
+			UE_LOG(LogSpawnPoints, Warning, TEXT("Spawn point manifest %s is out of date (%d spawn points not in the manifest, %d no longer in the map, sight %s); run fpd.BakeSpawnManifest"),
+				*PackageName, NumMissing, NumStale, Manifest->HasValidSight() ? TEXT("valid") : TEXT("not baked for the current threat map settings"));
+		}
+	}
+
+	static FDelayedAutoRegisterHelper RegisterPreSaveWorld(EDelayedRegisterRunPhase::EndOfEngineInit, []()
+	{
+		FWorldDelegates::OnPreSaveWorldWithContext.AddStatic(&OnPreSaveWorld);
+	});
+}
+
+/** 控制台命令：在编辑器中为当前地图烘焙出生点清单 */
+static FAutoConsoleCommandWithWorldAndArgs GBakeSpawnManifestCommand(
+	TEXT("fpd.BakeSpawnManifest"),
+	TEXT("为当前编辑器地图烘焙出生点清单（World Partition地图会逐个加载全部Actor）"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->WorldType != EWorldType::Editor)
+		{
+			UE_LOG(LogSpawnPoints, Warning, TEXT("fpd.BakeSpawnManifest must run on an editor world"));
+			return;
+		}
+
+		const FString PackageName = USpawnPointSubsystem::GetManifestPackageName(World);
+		const FString AssetName = FPackageName::GetShortName(PackageName);
+
+		UPackage* Package = CreatePackage(*PackageName);
+		Package->FullyLoad();
+
+		USpawnPointManifest* Manifest = FindObject<USpawnPointManifest>(Package, *AssetName);
+		if (!Manifest)
+		{
+			Manifest = NewObject<USpawnPointManifest>(Package, *AssetName, RF_Public | RF_Standalone);
+		}
+
+		Manifest->Rebuild(World);
+		Manifest->MarkPackageDirty();
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+		const bool bSaved = UPackage::SavePackage(Package, Manifest, *Filename, SaveArgs);
+
+		UE_LOG(LogSpawnPoints, Display, TEXT("Baked %d spawn points into %s (%s)"),
+			Manifest->SpawnPoints.Num(), *PackageName, bSaved ? TEXT("saved") : TEXT("SAVE FAILED"));
+	}));
+#endif
+
+/** 控制台命令：在生成的大量Actor中对比标签扫描和注册表查询，并测量比赛初始化耗时 */
+static FAutoConsoleCommandWithWorldAndArgs GSpawnPointBenchCommand(
+	TEXT("fpd.SpawnPointBench"),
+	TEXT("出生点查询基准测试：fpd.SpawnPointBench [填充Actor数=100000] [出生点数=200]，结束时销毁生成的Actor"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USpawnPointSubsystem* SpawnPointSubsystem = World ? World->GetSubsystem<USpawnPointSubsystem>() : nullptr;
+		if (!SpawnPointSubsystem || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		const int32 NumFiller = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000, 0);
+		const int32 NumSpawnPoints = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 200, 0);
+
+		// 生成一张“大地图”：大量无组件的填充Actor，加上同时带标签和组件的出生点
+		TArray<AActor*> Generated;
+		Generated.Reserve(NumFiller + NumSpawnPoints);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 Index = 0; Index < NumFiller; ++Index)
+		{
+			Generated.Add(World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams));
+		}
+
+		FRandomStream Random(49);
+		for (int32 Index = 0; Index < NumSpawnPoints; ++Index)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+			USceneComponent* Root = NewObject<USceneComponent>(Actor);
+			Actor->SetRootComponent(Root);
+			Root->RegisterComponent();
+			Actor->SetActorLocation(FVector(Random.FRandRange(-20000.0f, 20000.0f), Random.FRandRange(-20000.0f, 20000.0f), 100.0f));
+
+			const ESpawnPointType Type = Index % 4 == 0 ? ESpawnPointType::Player : ESpawnPointType::Enemy;
+			Actor->Tags.Add(Type == ESpawnPointType::Player ? FName(TEXT("PlayerStart")) : FName(TEXT("EnemySpawn")));
+
+			USpawnPointComponent* SpawnPoint = NewObject<USpawnPointComponent>(Actor);
+			SpawnPoint->Type = Type;
+			SpawnPoint->RegisterComponent();
+
+			Generated.Add(Actor);
+		}
+
+		// 原方式：两次全世界标签扫描
+		TArray<AActor*> FoundActors;
+		double StartTime = FPlatformTime::Seconds();
+		UGameplayStatics::GetAllActorsWithTag(World, FName("EnemySpawn"), FoundActors);
+		const int32 TagEnemySpawns = FoundActors.Num();
+		UGameplayStatics::GetAllActorsWithTag(World, FName("PlayerStart"), FoundActors);
+		const int32 TagPlayerStarts = FoundActors.Num();
+		const double TagScanSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// 注册表查询
+		TArray<FVector> Locations;
+		StartTime = FPlatformTime::Seconds();
+		SpawnPointSubsystem->GetSpawnLocations(ESpawnPointType::Enemy, Locations);
+		const int32 RegistryEnemySpawns = Locations.Num();
+		SpawnPointSubsystem->GetSpawnLocations(ESpawnPointType::Player, Locations);
+		const int32 RegistryPlayerStarts = Locations.Num();
+		const double RegistrySeconds = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogSpawnPoints, Display, TEXT("Spawn point benchmark: %d generated actors, %d spawn points"), Generated.Num(), NumSpawnPoints);
+		UE_LOG(LogSpawnPoints, Display, TEXT("  Tag scan x2:    %.3f ms (%d enemy, %d player)"), TagScanSeconds * 1000.0, TagEnemySpawns, TagPlayerStarts);
+		UE_LOG(LogSpawnPoints, Display, TEXT("  Registry query: %.3f ms (%d enemy, %d player)"), RegistrySeconds * 1000.0, RegistryEnemySpawns, RegistryPlayerStarts);
+
+		// 比赛初始化全程（只在等待开局时执行，不打断进行中的比赛）
+		AFirstPersonDemoGameMode* GameMode = World->GetAuthGameMode<AFirstPersonDemoGameMode>();
+		const bool bTimeInitializeGame = GameMode && GameMode->GetGameState() == EGameState::Waiting;
+		if (bTimeInitializeGame)
+		{
+			StartTime = FPlatformTime::Seconds();
+			GameMode->InitializeGame();
+			UE_LOG(LogSpawnPoints, Display, TEXT("  InitializeGame: %.3f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		}
+
+		for (AActor* Actor : Generated)
+		{
+			if (Actor)
+			{
+				Actor->Destroy();
+			}
+		}
+
+		// 生成的出生点已注销，按地图原有的出生点重新初始化
+		if (bTimeInitializeGame)
+		{
+			GameMode->InitializeGame();
+		}
+	}));
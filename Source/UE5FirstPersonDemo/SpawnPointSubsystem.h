@@ -0,0 +1,69 @@
+// SpawnPointSubsystem.h - 出生点注册表：烘焙清单加上运行时注册的出生点组件，取代全世界的标签扫描
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SpawnPointManifest.h"
+#include "SpawnPointSubsystem.generated.h"
+
+class USpawnPointComponent;
+
+/**
+ * 出生点子系统
+ *
+ * 世界初始化时加载本地图的出生点清单（先于任何Actor的BeginPlay和单元流送），
+ * 出生点组件在BeginPlay时注册、EndPlay时注销。查询只遍历出生点本身：
+ * 先取清单中的点，再补上清单之外注册的点（按距离去重），与世界中的Actor数量无关。
+ */
+UCLASS(Config = Game)
+class USpawnPointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	USpawnPointSubsystem();
+
+	// UWorldSubsystem
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** 注册出生点组件 */
+	void RegisterSpawnPoint(USpawnPointComponent* SpawnPoint);
+
+	/** 注销出生点组件 */
+	void UnregisterSpawnPoint(USpawnPointComponent* SpawnPoint);
+
+	/** 指定类型的全部出生点位置 */
+	void GetSpawnLocations(ESpawnPointType Type, TArray<FVector>& OutLocations) const;
+
+	/** 清单中该位置敌人生成点烘焙的视线掩码（没有烘焙或烘焙参数已过期时返回空） */
+	const TArray<uint64>* FindBakedSight(const FVector& Location) const;
+
+	/** 是否有出生点（清单或已注册） */
+	bool HasSpawnPoints() const { return (Manifest && Manifest->SpawnPoints.Num() > 0) || RegisteredPoints.Num() > 0; }
+
+	/** 已注册的出生点组件数 */
+	int32 GetNumRegistered() const { return RegisteredPoints.Num(); }
+
+	/** 地图对应的清单包名：<ManifestDirectory>/<地图名>_SpawnPoints */
+	static FString GetManifestPackageName(const UWorld* World);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** 清单所在目录（DefaultGame.ini 配置） */
+	UPROPERTY(Config)
+	FString ManifestDirectory;
+
+private:
+	/** 本地图的清单（没有烘焙时为空） */
+	UPROPERTY(Transient)
+	TObjectPtr<USpawnPointManifest> Manifest;
+
+	/** 清单中带有效视线的敌人生成点：位置 -> 清单索引 */
+	TMap<FVector, int32> BakedSightIndices;
+
+	/** 运行时注册的出生点 */
+	TMap<TWeakObjectPtr<USpawnPointComponent>, FSpawnPointEntry> RegisteredPoints;
+};
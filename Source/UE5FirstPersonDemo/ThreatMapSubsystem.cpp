@@ -0,0 +1,540 @@
+// ThreatMapSubsystem.cpp - 威胁影响图实现
+
+#include "ThreatMapSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "FirstPersonDemoCharacter.h"
+#include "EnemyAICharacter.h"
+#include "SpawnPointSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogThreatMap, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Threat Map Gather"), STAT_ThreatMapGather, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Threat Map Update (worker)"), STAT_ThreatMapUpdate, STATGROUP_FirstPersonDemo);
+DECLARE_CYCLE_STAT(TEXT("Threat Map Build"), STAT_ThreatMapBuild, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Threat Map Moves"), STAT_ThreatMapMoves, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Threat Map Sight Traces"), STAT_ThreatMapSightTraces, STATGROUP_FirstPersonDemo);
+
+namespace ThreatMapTuning
+{
+	/** 视线检测的眼睛高度 */
+	constexpr float EyeHeight = 150.0f;
+
+	/** 出生点评分中敌人影响的权重（其他玩家为1） */
+	constexpr int32 EnemyThreatWeight = 2;
+}
+
+void UThreatMapSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client || GridSizeX == 0)
+	{
+		return;
+	}
+
+	GatherMoves();
+
+	if (!UpdateTask.IsCompleted())
+	{
+		return;
+	}
+
+	// 取走上次更新的结果
+	if (bUpdateInFlight)
+	{
+		Swap(Candidates, WorkerCandidates);
+		NextPlayerStart = 0;
+		NextEnemySpawn = 0;
+		bUpdateInFlight = false;
+	}
+
+	if (PendingMoves.Num() == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_ThreatMapMoves, PendingMoves.Num());
+
+	Swap(InFlightMoves, PendingMoves);
+	PendingMoves.Reset();
+	bUpdateInFlight = true;
+
+	UpdateTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ThreatMapUpdate);
+		ApplyMoves(State, InFlightMoves);
+		RankCandidates(State, WorkerCandidates);
+	});
+}
+
+TStatId UThreatMapSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UThreatMapSubsystem, STATGROUP_Tickables);
+}
+
+void UThreatMapSubsystem::Deinitialize()
+{
+	UpdateTask.Wait();
+
+	Super::Deinitialize();
+}
+
+void UThreatMapSubsystem::Build(const TArray<FVector>& PlayerStarts, const TArray<FVector>& EnemySpawns)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ThreatMapBuild);
+
+	// 工作线程不能在重建期间访问状态
+	UpdateTask.Wait();
+	bUpdateInFlight = false;
+
+	State = FGridState();
+	Candidates = FCandidates();
+	WorkerCandidates = FCandidates();
+	PendingMoves.Reset();
+	InFlightMoves.Reset();
+	Agents.Reset();
+	GridSizeX = 0;
+	GridSizeY = 0;
+
+	if (PlayerStarts.Num() == 0 && EnemySpawns.Num() == 0)
+	{
+		return;
+	}
+
+	// 网格覆盖所有候选点，外扩视线和影响半径
+	FBox2D Bounds(ForceInit);
+	for (const FVector& Point : PlayerStarts)
+	{
+		Bounds += FVector2D(Point);
+	}
+	for (const FVector& Point : EnemySpawns)
+	{
+		Bounds += FVector2D(Point);
+	}
+	Bounds = Bounds.ExpandBy((SightRadius + InfluenceRadius) * CellSize);
+
+	// 网格与世界格子对齐，烘焙的视线掩码与候选点集合无关
+	GridOriginCell = GetWorldCell(FVector(Bounds.Min, 0.0f));
+	const FIntPoint MaxCell = GetWorldCell(FVector(Bounds.Max, 0.0f));
+	const FIntPoint FullSize = MaxCell - GridOriginCell + FIntPoint(1, 1);
+
+	// 候选点分布超出网格上限时两侧平均裁掉（格子边长不变，烘焙的视线仍然有效），网格外的点归入最近的边缘格子
+	if (FullSize.X > MaxGridDimension || FullSize.Y > MaxGridDimension)
+	{
+		GridOriginCell.X += FMath::Max(FullSize.X - MaxGridDimension, 0) / 2;
+		GridOriginCell.Y += FMath::Max(FullSize.Y - MaxGridDimension, 0) / 2;
+	}
+	GridSizeX = FMath::Clamp(FullSize.X, 1, MaxGridDimension);
+	GridSizeY = FMath::Clamp(FullSize.Y, 1, MaxGridDimension);
+
+	const int32 NumCells = GridSizeX * GridSizeY;
+	State.SizeX = GridSizeX;
+	State.SizeY = GridSizeY;
+	State.PlayerInfluence.SetNumZeroed(NumCells);
+	State.EnemyInfluence.SetNumZeroed(NumCells);
+	State.CellWatchers.SetNum(NumCells);
+	State.VisiblePlayers.SetNumZeroed(EnemySpawns.Num());
+
+	int32 NumClamped = 0;
+	for (const FVector& Point : PlayerStarts)
+	{
+		NumClamped += GetCellIndex(Point) == INDEX_NONE ? 1 : 0;
+		State.PlayerStartCells.Add(GetClampedCellIndex(Point));
+	}
+
+	// 视线：烘焙的掩码优先，其次上次Build检测过的，只有新出现的点才做射线检测
+	const TArray<FIntPoint>& SightOffsets = GetSightOffsets();
+	TMap<FVector, TArray<uint64>> PreviousCache = MoveTemp(SightCache);
+	SightCache.Reset();
+	int32 NumTraced = 0;
+
+	for (int32 SpawnIndex = 0; SpawnIndex < EnemySpawns.Num(); ++SpawnIndex)
+	{
+		NumClamped += GetCellIndex(EnemySpawns[SpawnIndex]) == INDEX_NONE ? 1 : 0;
+		const int32 SpawnCell = GetClampedCellIndex(EnemySpawns[SpawnIndex]);
+		State.EnemySpawnCells.Add(SpawnCell);
+
+		// 归入边缘格子的点视线只覆盖该格子，进入该格子的玩家都视为能看到它
+		State.CellWatchers[SpawnCell].Add(SpawnIndex);
+
+		const FIntPoint SpawnWorldCell = GetWorldCell(EnemySpawns[SpawnIndex]);
+		const TArray<uint64>& SightMask = FindOrTraceSight(EnemySpawns[SpawnIndex], PreviousCache, NumTraced);
+		for (int32 Bit = 0; Bit < SightOffsets.Num(); ++Bit)
+		{
+			if (SightMask[Bit / 64] & (1ull << (Bit % 64)))
+			{
+				const int32 Cell = GetCellIndex(SpawnWorldCell + SightOffsets[Bit]);
+				if (Cell != INDEX_NONE)
+				{
+					State.CellWatchers[Cell].Add(SpawnIndex);
+				}
+			}
+		}
+	}
+
+	// 第一批候选在游戏线程上直接排出，开局后的第一次生成就能避开玩家视线
+	GatherMoves();
+	ApplyMoves(State, PendingMoves);
+	PendingMoves.Reset();
+	RankCandidates(State, Candidates);
+	NextPlayerStart = 0;
+	NextEnemySpawn = 0;
+
+	UE_LOG(LogThreatMap, Log, TEXT("Threat map built: %dx%d cells, %d player starts, %d enemy spawns, %d sight traces"),
+		GridSizeX, GridSizeY, PlayerStarts.Num(), EnemySpawns.Num(), NumTraced * SightOffsets.Num());
+
+	if (NumClamped > 0)
+	{
+		UE_LOG(LogThreatMap, Warning, TEXT("Threat map needs %dx%d cells but is capped at %dx%d (%.0f units per side); %d spawn points outside the grid were clamped to its edge and rank less accurately"),
+			FullSize.X, FullSize.Y, MaxGridDimension, MaxGridDimension, MaxGridDimension * CellSize, NumClamped);
+	}
+
+	// 运行时检测只能看到已流送的单元，未加载的几何体不遮挡（偏向判为可见，不会在玩家眼前生成，但会少用一些点）
+	if (NumTraced > 0 && GetWorld()->GetWorldPartition())
+	{
+		UE_LOG(LogThreatMap, Warning, TEXT("%d enemy spawns have no baked sight and were traced against loaded cells only; run fpd.BakeSpawnManifest"), NumTraced);
+	}
+}
+
+const TArray<uint64>& UThreatMapSubsystem::FindOrTraceSight(const FVector& SpawnLocation, TMap<FVector, TArray<uint64>>& PreviousCache, int32& OutNumTraced)
+{
+	if (const USpawnPointSubsystem* SpawnPoints = GetWorld()->GetSubsystem<USpawnPointSubsystem>())
+	{
+		if (const TArray<uint64>* BakedSight = SpawnPoints->FindBakedSight(SpawnLocation))
+		{
+			return *BakedSight;
+		}
+	}
+
+	if (const TArray<uint64>* CachedSight = SightCache.Find(SpawnLocation))
+	{
+		return *CachedSight;
+	}
+
+	if (TArray<uint64>* PreviousSight = PreviousCache.Find(SpawnLocation))
+	{
+		return SightCache.Add(SpawnLocation, MoveTemp(*PreviousSight));
+	}
+
+	++OutNumTraced;
+	TArray<uint64>& Traced = SightCache.Add(SpawnLocation);
+	TraceSight(GetWorld(), SpawnLocation, Traced);
+	return Traced;
+}
+
+const TArray<FIntPoint>& UThreatMapSubsystem::GetSightOffsets()
+{
+	static const TArray<FIntPoint> Offsets = []()
+	{
+		TArray<FIntPoint> Result;
+		for (int32 Y = -SightRadius; Y <= SightRadius; ++Y)
+		{
+			for (int32 X = -SightRadius; X <= SightRadius; ++X)
+			{
+				if ((X != 0 || Y != 0) && X * X + Y * Y <= SightRadius * SightRadius)
+				{
+					Result.Add(FIntPoint(X, Y));
+				}
+			}
+		}
+		return Result;
+	}();
+	return Offsets;
+}
+
+FIntPoint UThreatMapSubsystem::GetWorldCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UThreatMapSubsystem::TraceSight(const UWorld* World, const FVector& SpawnLocation, TArray<uint64>& OutMask)
+{
+	const TArray<FIntPoint>& Offsets = GetSightOffsets();
+	OutMask.Init(0, GetNumSightWords());
+	if (!World)
+	{
+		return;
+	}
+
+	// 从生成点的眼睛高度到各格子中心（同一高度）
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ThreatMapSight), false);
+	const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+	const FVector Eye = SpawnLocation + FVector(0.0f, 0.0f, ThreatMapTuning::EyeHeight);
+	const FIntPoint SpawnCell = GetWorldCell(SpawnLocation);
+
+	for (int32 Bit = 0; Bit < Offsets.Num(); ++Bit)
+	{
+		const FIntPoint Cell = SpawnCell + Offsets[Bit];
+		const FVector Target((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, Eye.Z);
+		if (!World->LineTraceTestByObjectType(Eye, Target, ObjectParams, QueryParams))
+		{
+			OutMask[Bit / 64] |= 1ull << (Bit % 64);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ThreatMapSightTraces, Offsets.Num());
+}
+
+int32 UThreatMapSubsystem::ChoosePlayerStart()
+{
+	if (Candidates.NumSafestPlayerStarts == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// 同一批结果内连续重生的玩家分散到同样安全的点上
+	return Candidates.PlayerStarts[NextPlayerStart++ % Candidates.NumSafestPlayerStarts];
+}
+
+int32 UThreatMapSubsystem::ChooseEnemySpawn()
+{
+	if (Candidates.EnemySpawns.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	return Candidates.EnemySpawns[NextEnemySpawn++ % Candidates.EnemySpawns.Num()];
+}
+
+int32 UThreatMapSubsystem::GetCellIndex(const FIntPoint& WorldCell) const
+{
+	const int32 X = WorldCell.X - GridOriginCell.X;
+	const int32 Y = WorldCell.Y - GridOriginCell.Y;
+	if (X < 0 || Y < 0 || X >= GridSizeX || Y >= GridSizeY)
+	{
+		return INDEX_NONE;
+	}
+	return Y * GridSizeX + X;
+}
+
+int32 UThreatMapSubsystem::GetClampedCellIndex(const FVector& Location) const
+{
+	if (GridSizeX == 0 || GridSizeY == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const FIntPoint WorldCell = GetWorldCell(Location);
+	const int32 X = FMath::Clamp(WorldCell.X - GridOriginCell.X, 0, GridSizeX - 1);
+	const int32 Y = FMath::Clamp(WorldCell.Y - GridOriginCell.Y, 0, GridSizeY - 1);
+	return Y * GridSizeX + X;
+}
+
+void UThreatMapSubsystem::GatherMoves()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ThreatMapGather);
+
+	++FrameCounter;
+
+	UWorld* World = GetWorld();
+	for (TActorIterator<AFirstPersonDemoCharacter> It(World); It; ++It)
+	{
+		if (!It->IsDead())
+		{
+			TrackAgent(*It, true);
+		}
+	}
+	for (TActorIterator<AEnemyAICharacter> It(World); It; ++It)
+	{
+		if (!It->IsDead())
+		{
+			TrackAgent(*It, false);
+		}
+	}
+
+	// 本帧没有出现的角色（死亡或销毁）从影响图中移除
+	for (auto It = Agents.CreateIterator(); It; ++It)
+	{
+		const FTrackedAgent& Agent = It.Value();
+		if (Agent.LastSeenFrame == FrameCounter)
+		{
+			continue;
+		}
+
+		if (Agent.Cell != INDEX_NONE)
+		{
+			FAgentMove& Move = PendingMoves.AddDefaulted_GetRef();
+			Move.OldCell = Agent.Cell;
+			Move.bPlayer = Agent.bPlayer;
+		}
+		It.RemoveCurrent();
+	}
+}
+
+void UThreatMapSubsystem::TrackAgent(APawn* Pawn, bool bPlayer)
+{
+	FTrackedAgent& Agent = Agents.FindOrAdd(Pawn);
+	Agent.LastSeenFrame = FrameCounter;
+	Agent.bPlayer = bPlayer;
+
+	// 网格外的角色也盖印到边缘格子，归入边缘的候选点仍能感知附近的角色
+	const int32 Cell = GetClampedCellIndex(Pawn->GetActorLocation());
+	if (Cell == Agent.Cell)
+	{
+		return;
+	}
+
+	FAgentMove& Move = PendingMoves.AddDefaulted_GetRef();
+	Move.OldCell = Agent.Cell;
+	Move.NewCell = Cell;
+	Move.bPlayer = bPlayer;
+	Agent.Cell = Cell;
+}
+
+void UThreatMapSubsystem::ApplyMoves(FGridState& Grid, TConstArrayView<FAgentMove> Moves)
+{
+	for (const FAgentMove& Move : Moves)
+	{
+		TArray<int32>& Influence = Move.bPlayer ? Grid.PlayerInfluence : Grid.EnemyInfluence;
+		if (Move.OldCell != INDEX_NONE)
+		{
+			Stamp(Grid, Influence, Move.OldCell, -1);
+		}
+		if (Move.NewCell != INDEX_NONE)
+		{
+			Stamp(Grid, Influence, Move.NewCell, 1);
+		}
+
+		if (!Move.bPlayer)
+		{
+			continue;
+		}
+
+		// 玩家离开或进入某个格子时，能看到该格子的敌人生成点视线内玩家数随之变化
+		if (Move.OldCell != INDEX_NONE)
+		{
+			for (int32 SpawnIndex : Grid.CellWatchers[Move.OldCell])
+			{
+				--Grid.VisiblePlayers[SpawnIndex];
+			}
+		}
+		if (Move.NewCell != INDEX_NONE)
+		{
+			for (int32 SpawnIndex : Grid.CellWatchers[Move.NewCell])
+			{
+				++Grid.VisiblePlayers[SpawnIndex];
+			}
+		}
+	}
+}
+
+void UThreatMapSubsystem::Stamp(const FGridState& Grid, TArray<int32>& Influence, int32 Cell, int32 Sign)
+{
+	// 影响值随切比雪夫距离线性衰减：中心为 InfluenceRadius + 1，边缘为1
+	const int32 CellX = Cell % Grid.SizeX;
+	const int32 CellY = Cell / Grid.SizeX;
+	for (int32 Y = FMath::Max(CellY - InfluenceRadius, 0); Y <= FMath::Min(CellY + InfluenceRadius, Grid.SizeY - 1); ++Y)
+	{
+		for (int32 X = FMath::Max(CellX - InfluenceRadius, 0); X <= FMath::Min(CellX + InfluenceRadius, Grid.SizeX - 1); ++X)
+		{
+			const int32 Distance = FMath::Max(FMath::Abs(X - CellX), FMath::Abs(Y - CellY));
+			Influence[Y * Grid.SizeX + X] += Sign * (InfluenceRadius + 1 - Distance);
+		}
+	}
+}
+
+void UThreatMapSubsystem::RankCandidates(const FGridState& Grid, FCandidates& OutCandidates)
+{
+	auto InfluenceAt = [](const TArray<int32>& Influence, int32 Cell)
+	{
+		return Cell != INDEX_NONE ? Influence[Cell] : 0;
+	};
+
+	// 玩家出生点：威胁最低的在前
+	TArray<TPair<int32, int32>, TInlineAllocator<64>> Scored;
+	for (int32 Index = 0; Index < Grid.PlayerStartCells.Num(); ++Index)
+	{
+		const int32 Cell = Grid.PlayerStartCells[Index];
+		const int32 Threat = InfluenceAt(Grid.EnemyInfluence, Cell) * ThreatMapTuning::EnemyThreatWeight + InfluenceAt(Grid.PlayerInfluence, Cell);
+		Scored.Emplace(Threat, Index);
+	}
+	Scored.Sort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B)
+	{
+		return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+	});
+
+	OutCandidates.PlayerStarts.Reset();
+	OutCandidates.NumSafestPlayerStarts = 0;
+	for (int32 Rank = 0; Rank < FMath::Min(Scored.Num(), MaxCandidates); ++Rank)
+	{
+		OutCandidates.PlayerStarts.Add(Scored[Rank].Value);
+		if (Scored[Rank].Key == Scored[0].Key)
+		{
+			++OutCandidates.NumSafestPlayerStarts;
+		}
+	}
+
+	// 敌人生成点：不在玩家视线内；优先玩家影响大的（离玩家近），其次敌人影响小的
+	TArray<int32, TInlineAllocator<64>> Unseen;
+	bool bAnyNearPlayers = false;
+	for (int32 Index = 0; Index < Grid.EnemySpawnCells.Num(); ++Index)
+	{
+		const int32 Cell = Grid.EnemySpawnCells[Index];
+		if (Cell != INDEX_NONE && Grid.VisiblePlayers[Index] == 0)
+		{
+			Unseen.Add(Index);
+			bAnyNearPlayers |= Grid.PlayerInfluence[Cell] > 0;
+		}
+	}
+	Unseen.Sort([&Grid](int32 A, int32 B)
+	{
+		const int32 CellA = Grid.EnemySpawnCells[A];
+		const int32 CellB = Grid.EnemySpawnCells[B];
+		if (Grid.PlayerInfluence[CellA] != Grid.PlayerInfluence[CellB])
+		{
+			return Grid.PlayerInfluence[CellA] > Grid.PlayerInfluence[CellB];
+		}
+		if (Grid.EnemyInfluence[CellA] != Grid.EnemyInfluence[CellB])
+		{
+			return Grid.EnemyInfluence[CellA] < Grid.EnemyInfluence[CellB];
+		}
+		return A < B;
+	});
+
+	OutCandidates.EnemySpawns.Reset();
+	for (int32 Index : Unseen)
+	{
+		// 有玩家附近的点时只发布这些点
+		if (OutCandidates.EnemySpawns.Num() >= MaxCandidates
+			|| (bAnyNearPlayers && Grid.PlayerInfluence[Grid.EnemySpawnCells[Index]] == 0))
+		{
+			break;
+		}
+		OutCandidates.EnemySpawns.Add(Index);
+	}
+
+	// 所有生成点都在玩家视线内时，退而选择看到的玩家最少的点，其次离玩家远的
+	if (OutCandidates.EnemySpawns.Num() == 0)
+	{
+		TArray<int32, TInlineAllocator<64>> Watched;
+		for (int32 Index = 0; Index < Grid.EnemySpawnCells.Num(); ++Index)
+		{
+			if (Grid.EnemySpawnCells[Index] != INDEX_NONE)
+			{
+				Watched.Add(Index);
+			}
+		}
+		Watched.Sort([&Grid](int32 A, int32 B)
+		{
+			if (Grid.VisiblePlayers[A] != Grid.VisiblePlayers[B])
+			{
+				return Grid.VisiblePlayers[A] < Grid.VisiblePlayers[B];
+			}
+			const int32 InfluenceA = Grid.PlayerInfluence[Grid.EnemySpawnCells[A]];
+			const int32 InfluenceB = Grid.PlayerInfluence[Grid.EnemySpawnCells[B]];
+			return InfluenceA != InfluenceB ? InfluenceA < InfluenceB : A < B;
+		});
+
+		for (int32 Rank = 0; Rank < FMath::Min(Watched.Num(), MaxCandidates); ++Rank)
+		{
+			if (Grid.VisiblePlayers[Watched[Rank]] != Grid.VisiblePlayers[Watched[0]])
+			{
+				break;
+			}
+			OutCandidates.EnemySpawns.Add(Watched[Rank]);
+		}
+	}
+}
@@ -0,0 +1,173 @@
+// ThreatMapSubsystem.h - 威胁影响图：在工作线程上增量维护玩家和敌人的分布，O(1)选择出生点和敌人生成点
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "ThreatMapSubsystem.generated.h"
+
+class APawn;
+
+/**
+ * 威胁影响图子系统（服务器）
+ *
+ * 比赛初始化时按候选点的范围建立粗粒度二维网格（格子与世界坐标对齐），并取得每个敌人生成点的视线：
+ * 视线半径内哪些格子能看到它（只检测静态几何体）。视线优先使用出生点清单中烘焙的掩码
+ * （烘焙时加载全部单元）；清单之外的点在运行时检测一次并按位置缓存，重新开局不再检测。
+ *
+ * 游戏线程每帧只记录跨格移动的角色（旧格子、新格子），工作线程把这些移动增量地
+ * 盖印到玩家和敌人的影响值上，同时更新每个敌人生成点视线内的玩家数，然后排出候选：
+ * - 玩家出生点：敌人影响（权重2）加其他玩家影响最低的点
+ * - 敌人生成点：没有玩家能看到、且在玩家影响范围内的点，离玩家越近越优先
+ * 游戏线程在任务完成后取走结果，选择时只读取已排好的候选，O(1)。
+ */
+UCLASS()
+class UThreatMapSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 格子边长 */
+	static constexpr float CellSize = 800.0f;
+
+	/** 影响半径（格） */
+	static constexpr int32 InfluenceRadius = 3;
+
+	/** 预计算视线的半径（格），更远的玩家视为看不到 */
+	static constexpr int32 SightRadius = 6;
+
+	/** 网格每边的最大格数 */
+	static constexpr int32 MaxGridDimension = 256;
+
+	/** 每类发布的候选数 */
+	static constexpr int32 MaxCandidates = 8;
+
+	/** 视线半径内的格子偏移（不含中心格）；视线掩码按此顺序每位对应一个偏移 */
+	static const TArray<FIntPoint>& GetSightOffsets();
+
+	/** 视线掩码的uint64个数 */
+	static int32 GetNumSightWords() { return FMath::DivideAndRoundUp(GetSightOffsets().Num(), 64); }
+
+	/** 位置所在的世界格子坐标 */
+	static FIntPoint GetWorldCell(const FVector& Location);
+
+	/** 从生成点向视线半径内各格子中心做射线检测，输出视线掩码（只有静态几何体遮挡） */
+	static void TraceSight(const UWorld* World, const FVector& SpawnLocation, TArray<uint64>& OutMask);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+	/** 服务器：设置候选点，重建网格、取得敌人生成点的视线并按当前角色位置排出第一批候选（比赛初始化时调用） */
+	void Build(const TArray<FVector>& PlayerStarts, const TArray<FVector>& EnemySpawns);
+
+	/** 最安全的玩家出生点索引；同样安全的点之间轮换，尚无结果时返回INDEX_NONE */
+	int32 ChoosePlayerStart();
+
+	/** 玩家附近且不在玩家视线内的敌人生成点索引（都在视线内时取看到的玩家最少的点）；候选之间轮换，没有生成点时返回INDEX_NONE */
+	int32 ChooseEnemySpawn();
+
+private:
+	/** 一个角色的跨格移动；INDEX_NONE表示出现或消失 */
+	struct FAgentMove
+	{
+		int32 OldCell = INDEX_NONE;
+		int32 NewCell = INDEX_NONE;
+		bool bPlayer = false;
+	};
+
+	/** 游戏线程记录的角色所在格子 */
+	struct FTrackedAgent
+	{
+		int32 Cell = INDEX_NONE;
+		bool bPlayer = false;
+		uint32 LastSeenFrame = 0;
+	};
+
+	/** 影响图状态：更新任务运行期间只由工作线程访问 */
+	struct FGridState
+	{
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+
+		/** 各格子的玩家和敌人影响值（整数盖印，增减不会累积误差） */
+		TArray<int32> PlayerInfluence;
+		TArray<int32> EnemyInfluence;
+
+		/** 候选点所在格子 */
+		TArray<int32> PlayerStartCells;
+		TArray<int32> EnemySpawnCells;
+
+		/** 每个格子：能看到该格子的敌人生成点 */
+		TArray<TArray<int32>> CellWatchers;
+
+		/** 每个敌人生成点：视线内的玩家数 */
+		TArray<int32> VisiblePlayers;
+	};
+
+	/** 排好的候选 */
+	struct FCandidates
+	{
+		/** 玩家出生点，最安全的在前 */
+		TArray<int32> PlayerStarts;
+
+		/** 与最安全的点同样安全的数量 */
+		int32 NumSafestPlayerStarts = 0;
+
+		/** 敌人生成点，最合适的在前 */
+		TArray<int32> EnemySpawns;
+	};
+
+	/** 位置所在格子（网格外返回INDEX_NONE） */
+	int32 GetCellIndex(const FVector& Location) const { return GetCellIndex(GetWorldCell(Location)); }
+
+	/** 世界格子对应的网格格子（网格外返回INDEX_NONE） */
+	int32 GetCellIndex(const FIntPoint& WorldCell) const;
+
+	/** 位置所在格子，网格外的位置归入最近的边缘格子（尚未Build时返回INDEX_NONE） */
+	int32 GetClampedCellIndex(const FVector& Location) const;
+
+	/** 敌人生成点的视线掩码：烘焙的、上次Build缓存的，或者现在检测 */
+	const TArray<uint64>& FindOrTraceSight(const FVector& SpawnLocation, TMap<FVector, TArray<uint64>>& PreviousCache, int32& OutNumTraced);
+
+	/** 记录本帧跨格、出现和消失的角色 */
+	void GatherMoves();
+
+	/** 记录一个存活角色的位置 */
+	void TrackAgent(APawn* Pawn, bool bPlayer);
+
+	/** 工作线程：应用移动并重新排出候选 */
+	static void ApplyMoves(FGridState& Grid, TConstArrayView<FAgentMove> Moves);
+	static void Stamp(const FGridState& Grid, TArray<int32>& Influence, int32 Cell, int32 Sign);
+	static void RankCandidates(const FGridState& Grid, FCandidates& OutCandidates);
+
+	/** 网格原点的世界格子坐标和网格尺寸（游戏线程计算格子用，Build之后不变） */
+	FIntPoint GridOriginCell = FIntPoint::ZeroValue;
+	int32 GridSizeX = 0;
+	int32 GridSizeY = 0;
+
+	FGridState State;
+
+	/** 工作线程写入的候选和游戏线程使用的候选 */
+	FCandidates WorkerCandidates;
+	FCandidates Candidates;
+
+	/** 等待下次更新的移动、正在更新的移动 */
+	TArray<FAgentMove> PendingMoves;
+	TArray<FAgentMove> InFlightMoves;
+
+	TMap<TWeakObjectPtr<APawn>, FTrackedAgent> Agents;
+
+	/** 运行时检测的视线掩码（按生成点位置，只保留最近一次Build用到的点） */
+	TMap<FVector, TArray<uint64>> SightCache;
+
+	UE::Tasks::FTask UpdateTask;
+
+	/** 任务结果尚未取走 */
+	bool bUpdateInFlight = false;
+
+	uint32 FrameCounter = 0;
+	int32 NextPlayerStart = 0;
+	int32 NextEnemySpawn = 0;
+};
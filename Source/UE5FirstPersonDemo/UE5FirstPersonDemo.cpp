@@ -2,11 +2,19 @@
 
 #include "UE5FirstPersonDemo.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/World.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UE5FirstPersonDemo, "UE5FirstPersonDemo" );
 
 DEFINE_LOG_CATEGORY(LogGameplay);
 
+#if !UE_SERVER
+bool ShouldPlayCosmetics(const UWorld* World)
+{
+	return World && World->GetNetMode() != NM_DedicatedServer;
+}
+#endif
+
 UE5FirstPersonDemo::UE5FirstPersonDemo()
 {
 }
@@ -3,6 +3,26 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** 项目性能统计分组（stat FirstPersonDemo） */
+DECLARE_STATS_GROUP(TEXT("FirstPersonDemo"), STATGROUP_FirstPersonDemo, STATCAT_Advanced);
+
+/** 武器射线通道（DefaultEngine.ini 中的 Weapon）：只有环境的简化碰撞阻挡，角色由命中盒代理判定 */
+#define TraceChannel_Weapon ECC_GameTraceChannel1
+
+class UWorld;
+
+/**
+ * 是否播放装饰性表现（音效、特效、蒙太奇、布娃娃）
+ * 专用服务器构建中恒为false，调用处的装饰性分支被编译器整体剔除；
+ * 其他构建在以专用服务器模式运行时跳过。权威逻辑不得放在此判断之后。
+ */
+#if UE_SERVER
+inline bool ShouldPlayCosmetics(const UWorld* World) { return false; }
+#else
+bool ShouldPlayCosmetics(const UWorld* World);
+#endif
 
 class UE5FIRSTPERSONDEMO_API UE5FirstPersonDemo
 {
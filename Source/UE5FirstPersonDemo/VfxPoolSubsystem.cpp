@@ -0,0 +1,363 @@
+// VfxPoolSubsystem.cpp - 特效池实现
+
+#include "VfxPoolSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "CombatAssetSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVfxPool, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("VFX Spawned"), STAT_VfxSpawned, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("VFX Stolen"), STAT_VfxStolen, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("VFX Culled"), STAT_VfxCulled, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("VFX Components Created"), STAT_VfxComponentsCreated, STATGROUP_FirstPersonDemo);
+
+namespace VfxPool
+{
+	/** 各类型的池容量（每个后端） */
+	constexpr int32 PoolSize[] =
+	{
+		16,		// Muzzle
+		32		// Impact
+	};
+	static_assert(UE_ARRAY_COUNT(PoolSize) == static_cast<int32>(EPooledEffect::Count), "每种特效类型都需要池容量");
+
+	/** 各类型的剔除距离 */
+	constexpr float CullDistance[] =
+	{
+		5000.0f,	// Muzzle
+		4000.0f		// Impact
+	};
+	static_assert(UE_ARRAY_COUNT(CullDistance) == static_cast<int32>(EPooledEffect::Count), "每种特效类型都需要剔除距离");
+
+	/** 资产对应的后端 */
+	EVfxBackend GetBackend(const UFXSystemAsset* Asset)
+	{
+		return Asset->IsA<UParticleSystem>() ? EVfxBackend::Cascade : EVfxBackend::Niagara;
+	}
+
+	/** 创建一个未激活、不自动销毁的组件 */
+	UFXSystemComponent* CreateComponent(EVfxBackend Backend, AActor* Owner)
+	{
+		if (Backend == EVfxBackend::Cascade)
+		{
+			UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(Owner);
+			Component->bAutoDestroy = false;
+			return Component;
+		}
+
+		UNiagaraComponent* Component = NewObject<UNiagaraComponent>(Owner);
+		Component->SetAutoDestroy(false);
+		return Component;
+	}
+
+	/** 立即停止（抢占时） */
+	void DeactivateImmediate(UFXSystemComponent* Component)
+	{
+		if (UNiagaraComponent* Niagara = Cast<UNiagaraComponent>(Component))
+		{
+			Niagara->DeactivateImmediate();
+		}
+		else if (UParticleSystemComponent* Cascade = Cast<UParticleSystemComponent>(Component))
+		{
+			Cascade->DeactivateImmediate();
+		}
+	}
+
+	/** 设置资产（同一类型通常使用同一个资产，只在不同时才重新初始化） */
+	void SetAsset(UFXSystemComponent* Component, UFXSystemAsset* Asset)
+	{
+		if (UNiagaraComponent* Niagara = Cast<UNiagaraComponent>(Component))
+		{
+			if (Niagara->GetAsset() != Asset)
+			{
+				Niagara->SetAsset(CastChecked<UNiagaraSystem>(Asset));
+			}
+		}
+		else if (UParticleSystemComponent* Cascade = Cast<UParticleSystemComponent>(Component))
+		{
+			if (Cascade->Template != Asset)
+			{
+				Cascade->SetTemplate(CastChecked<UParticleSystem>(Asset));
+			}
+		}
+	}
+}
+
+void UVfxPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Pools.SetNum(static_cast<int32>(EPooledEffect::Count) * static_cast<int32>(EVfxBackend::Count));
+}
+
+void UVfxPoolSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (!ShouldPlayCosmetics(&InWorld))
+	{
+		return;
+	}
+
+	// 预先创建全部组件，之后比赛中不再分配
+	AWorldSettings* PoolOwner = InWorld.GetWorldSettings();
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EPooledEffect::Count); ++TypeIndex)
+	{
+		for (int32 BackendIndex = 0; BackendIndex < static_cast<int32>(EVfxBackend::Count); ++BackendIndex)
+		{
+			FVfxPool& Pool = GetPool(static_cast<EPooledEffect>(TypeIndex), static_cast<EVfxBackend>(BackendIndex));
+			for (int32 Index = 0; Index < VfxPool::PoolSize[TypeIndex]; ++Index)
+			{
+				UFXSystemComponent* Component = VfxPool::CreateComponent(static_cast<EVfxBackend>(BackendIndex), PoolOwner);
+				Component->SetAutoActivate(false);
+				Component->SetUsingAbsoluteLocation(false);
+				Component->RegisterComponentWithWorld(&InWorld);
+
+				Pool.Components.Add(Component);
+				Pool.LastUsedTime.Add(0.0);
+				++NumComponentsCreated;
+			}
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_VfxComponentsCreated, NumComponentsCreated);
+}
+
+void UVfxPoolSubsystem::Deinitialize()
+{
+	for (FVfxPool& Pool : Pools)
+	{
+		for (UFXSystemComponent* Component : Pool.Components)
+		{
+			if (IsValid(Component))
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	Pools.Reset();
+	DEC_DWORD_STAT_BY(STAT_VfxComponentsCreated, NumComponentsCreated);
+	NumComponentsCreated = 0;
+
+	Super::Deinitialize();
+}
+
+UFXSystemComponent* UVfxPoolSubsystem::SpawnAttached(EPooledEffect Type, UFXSystemAsset* Asset, USceneComponent* Parent, FName SocketName)
+{
+	if (!Parent || !ShouldSpawn(Type, Parent->GetSocketLocation(SocketName)))
+	{
+		return nullptr;
+	}
+
+	UFXSystemComponent* Component = Acquire(Type, Asset);
+	if (Component)
+	{
+		Component->AttachToComponent(Parent, FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketName);
+		Component->Activate(true);
+	}
+	return Component;
+}
+
+UFXSystemComponent* UVfxPoolSubsystem::SpawnAtLocation(EPooledEffect Type, UFXSystemAsset* Asset, const FVector& Location, const FRotator& Rotation)
+{
+	if (!ShouldSpawn(Type, Location))
+	{
+		return nullptr;
+	}
+
+	UFXSystemComponent* Component = Acquire(Type, Asset);
+	if (Component)
+	{
+		Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		Component->SetWorldLocationAndRotation(Location, Rotation);
+		Component->Activate(true);
+	}
+	return Component;
+}
+
+bool UVfxPoolSubsystem::IsPooledComponent(const UFXSystemComponent* Component) const
+{
+	for (const FVfxPool& Pool : Pools)
+	{
+		if (Pool.Components.Contains(Component))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UVfxPoolSubsystem::ShouldSpawn(EPooledEffect Type, const FVector& Location) const
+{
+	// 专用服务器上池为空
+	if (NumComponentsCreated == 0)
+	{
+		return false;
+	}
+
+	// 只有本地观察者能看到特效
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (!PC || !PC->IsLocalController())
+	{
+		return false;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	if (FVector::DistSquared(ViewLocation, Location) > FMath::Square(VfxPool::CullDistance[static_cast<int32>(Type)]))
+	{
+		INC_DWORD_STAT(STAT_VfxCulled);
+		return false;
+	}
+
+	return true;
+}
+
+UFXSystemComponent* UVfxPoolSubsystem::Acquire(EPooledEffect Type, UFXSystemAsset* Asset)
+{
+	if (!Asset)
+	{
+		Asset = GetDefaultAsset(Type);
+		if (!Asset)
+		{
+			return nullptr;
+		}
+	}
+
+	FVfxPool& Pool = GetPool(Type, VfxPool::GetBackend(Asset));
+
+	// 优先使用空闲组件，否则抢占最久未使用的
+	int32 ChosenIndex = INDEX_NONE;
+	double OldestTime = TNumericLimits<double>::Max();
+	for (int32 Index = 0; Index < Pool.Components.Num(); ++Index)
+	{
+		if (!Pool.Components[Index]->IsActive())
+		{
+			ChosenIndex = Index;
+			break;
+		}
+
+		if (Pool.LastUsedTime[Index] < OldestTime)
+		{
+			OldestTime = Pool.LastUsedTime[Index];
+			ChosenIndex = Index;
+		}
+	}
+
+	UFXSystemComponent* Component = Pool.Components[ChosenIndex];
+	if (Component->IsActive())
+	{
+		VfxPool::DeactivateImmediate(Component);
+		INC_DWORD_STAT(STAT_VfxStolen);
+	}
+
+	VfxPool::SetAsset(Component, Asset);
+
+	Pool.LastUsedTime[ChosenIndex] = GetWorld()->GetTimeSeconds();
+	INC_DWORD_STAT(STAT_VfxSpawned);
+
+	return Component;
+}
+
+UFXSystemAsset* UVfxPoolSubsystem::GetDefaultAsset(EPooledEffect Type) const
+{
+	switch (Type)
+	{
+	case EPooledEffect::Muzzle:
+		return UCombatAssetSubsystem::Get<UFXSystemAsset>(GetWorld(), ECombatAsset::MuzzleEffect);
+	case EPooledEffect::Impact:
+		return UCombatAssetSubsystem::Get<UFXSystemAsset>(GetWorld(), ECombatAsset::ImpactEffect);
+	default:
+		return nullptr;
+	}
+}
+
+/** 控制台命令：特效池分配测试，持续交火后检查没有创建新的特效组件 */
+static FAutoConsoleCommandWithWorldAndArgs GVfxPoolTestCommand(
+	TEXT("fpd.VfxPoolTest"),
+	TEXT("特效池分配测试：fpd.VfxPoolTest [每种类型的播放次数=2000]，在本地观察者前方连续播放默认枪口和命中特效，检查组件数量不变且全部来自池"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UVfxPoolSubsystem* VfxPoolSubsystem = World ? World->GetSubsystem<UVfxPoolSubsystem>() : nullptr;
+		const APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+		if (!VfxPoolSubsystem || !PC || !PC->IsLocalController())
+		{
+			UE_LOG(LogVfxPool, Warning, TEXT("VFX pool test needs a world with a local player"));
+			return;
+		}
+
+		const int32 NumSpawns = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2000, 1);
+
+		// 世界中的特效组件总数（池外的分配也会计入）
+		auto CountWorldComponents = [World]()
+		{
+			int32 Count = 0;
+			for (TObjectIterator<UFXSystemComponent> It; It; ++It)
+			{
+				Count += (It->GetWorld() == World) ? 1 : 0;
+			}
+			return Count;
+		};
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const FVector EffectLocation = ViewLocation + ViewRotation.Vector() * 200.0f;
+
+		const int32 CreatedBefore = VfxPoolSubsystem->GetNumComponentsCreated();
+		const int32 WorldComponentsBefore = CountWorldComponents();
+		bool bAllPassed = true;
+		int32 NumTypesTested = 0;
+
+		for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EPooledEffect::Count); ++TypeIndex)
+		{
+			int32 NumPlayed = 0;
+			int32 NumOutsidePool = 0;
+			for (int32 Spawn = 0; Spawn < NumSpawns; ++Spawn)
+			{
+				if (UFXSystemComponent* Component = VfxPoolSubsystem->SpawnAtLocation(static_cast<EPooledEffect>(TypeIndex), nullptr, EffectLocation))
+				{
+					++NumPlayed;
+					NumOutsidePool += VfxPoolSubsystem->IsPooledComponent(Component) ? 0 : 1;
+				}
+			}
+
+			// 没有默认资产的类型（例如枪口火焰只由角色蓝图指定）无法测试
+			if (NumPlayed == 0)
+			{
+				UE_LOG(LogVfxPool, Display, TEXT("SKIP: effect type %d has no default effect asset"), TypeIndex);
+				continue;
+			}
+
+			const bool bPassed = NumPlayed == NumSpawns && NumOutsidePool == 0;
+			bAllPassed &= bPassed;
+			++NumTypesTested;
+			UE_LOG(LogVfxPool, Display, TEXT("%s: effect type %d played %d/%d, %d components outside the pool"),
+				bPassed ? TEXT("PASS") : TEXT("FAIL"), TypeIndex, NumPlayed, NumSpawns, NumOutsidePool);
+		}
+
+		if (NumTypesTested == 0)
+		{
+			bAllPassed = false;
+			UE_LOG(LogVfxPool, Display, TEXT("FAIL: no effect type has a default asset to test"));
+		}
+
+		const int32 CreatedAfter = VfxPoolSubsystem->GetNumComponentsCreated();
+		const int32 WorldComponentsAfter = CountWorldComponents();
+		const bool bNoAllocations = CreatedAfter == CreatedBefore && WorldComponentsAfter == WorldComponentsBefore;
+		bAllPassed &= bNoAllocations;
+		UE_LOG(LogVfxPool, Display, TEXT("%s: pool components %d -> %d, effect components in world %d -> %d"),
+			bNoAllocations ? TEXT("PASS") : TEXT("FAIL"), CreatedBefore, CreatedAfter, WorldComponentsBefore, WorldComponentsAfter);
+
+		UE_LOG(LogVfxPool, Display, TEXT("VFX pool test: %s"), bAllPassed ? TEXT("all passed") : TEXT("FAILED"));
+	}));
@@ -0,0 +1,100 @@
+// VfxPoolSubsystem.h - 枪口和命中特效的组件池：固定容量、LRU抢占、距离剔除（Niagara与Cascade）
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VfxPoolSubsystem.generated.h"
+
+class UFXSystemAsset;
+class UFXSystemComponent;
+class USceneComponent;
+
+/**
+ * 池化特效类型
+ */
+enum class EPooledEffect : uint8
+{
+	Muzzle,
+	Impact,
+	Count
+};
+
+/**
+ * 特效后端（内容可能仍是Cascade粒子系统，迁移到Niagara前两者都要支持）
+ */
+enum class EVfxBackend : uint8
+{
+	Niagara,
+	Cascade,
+	Count
+};
+
+/**
+ * 单一类型、单一后端的组件池
+ */
+USTRUCT()
+struct FVfxPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<UFXSystemComponent>> Components;
+
+	/** 每个组件上次被使用的时间（LRU抢占） */
+	TArray<double> LastUsedTime;
+};
+
+/**
+ * 特效池子系统
+ *
+ * 世界开始时为每种类型、每个后端预先创建固定数量的组件，之后只激活和复位，不再创建或销毁。
+ * 池满时抢占最久未使用的组件；超出该类型剔除距离（相对本地观察者）的特效直接跳过。
+ * 特效资产可以是Niagara系统或Cascade粒子系统，按资产类型选择对应的池。
+ * 专用服务器上不创建任何组件。
+ */
+UCLASS()
+class UVfxPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** 在组件插槽上播放（枪口火焰）；Asset 为空时使用战斗资产集中的默认特效，返回使用的组件 */
+	UFXSystemComponent* SpawnAttached(EPooledEffect Type, UFXSystemAsset* Asset, USceneComponent* Parent, FName SocketName);
+
+	/** 在世界位置播放（命中特效）；Asset 为空时使用战斗资产集中的默认特效，返回使用的组件 */
+	UFXSystemComponent* SpawnAtLocation(EPooledEffect Type, UFXSystemAsset* Asset, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator);
+
+	/** 世界开始后创建的组件总数（比赛中应保持不变） */
+	int32 GetNumComponentsCreated() const { return NumComponentsCreated; }
+
+	/** 组件是否属于池 */
+	bool IsPooledComponent(const UFXSystemComponent* Component) const;
+
+private:
+	/** 是否需要播放（有本地观察者且在剔除距离内） */
+	bool ShouldSpawn(EPooledEffect Type, const FVector& Location) const;
+
+	/** 取得一个可用组件并设置资产，池满时抢占最久未使用的 */
+	UFXSystemComponent* Acquire(EPooledEffect Type, UFXSystemAsset* Asset);
+
+	/** 该类型的默认特效资产 */
+	UFXSystemAsset* GetDefaultAsset(EPooledEffect Type) const;
+
+	/** 类型和后端对应的池 */
+	FVfxPool& GetPool(EPooledEffect Type, EVfxBackend Backend)
+	{
+		return Pools[static_cast<int32>(Type) * static_cast<int32>(EVfxBackend::Count) + static_cast<int32>(Backend)];
+	}
+
+	UPROPERTY()
+	TArray<FVfxPool> Pools;
+
+	/** 创建的组件总数 */
+	int32 NumComponentsCreated = 0;
+};
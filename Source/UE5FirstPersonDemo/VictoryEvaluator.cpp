@@ -0,0 +1,84 @@
+// VictoryEvaluator.cpp - 各胜利条件的评估器
+
+#include "VictoryEvaluator.h"
+#include "FirstPersonDemoCharacter.h"
+
+namespace VictoryEvaluators
+{
+	/** 达到目标分数：只检查得分变化的玩家 */
+	class FScoreEvaluator : public FVictoryEvaluator
+	{
+	public:
+		explicit FScoreEvaluator(int32 InTargetScore) : TargetScore(InTargetScore) {}
+
+		virtual FVictoryDecision OnPlayerStatsChanged(AFirstPersonDemoCharacter* Player) override
+		{
+			return Player->Score >= TargetScore ? FVictoryDecision::Win(Player) : FVictoryDecision::Continue();
+		}
+
+	private:
+		int32 TargetScore;
+	};
+
+	/** 达到目标击杀数：只检查击杀变化的玩家 */
+	class FKillCountEvaluator : public FVictoryEvaluator
+	{
+	public:
+		explicit FKillCountEvaluator(int32 InTargetKillCount) : TargetKillCount(InTargetKillCount) {}
+
+		virtual FVictoryDecision OnPlayerStatsChanged(AFirstPersonDemoCharacter* Player) override
+		{
+			return Player->KillCount >= TargetKillCount ? FVictoryDecision::Win(Player) : FVictoryDecision::Continue();
+		}
+
+	private:
+		int32 TargetKillCount;
+	};
+
+	/** 时间限制：时间到时最高分玩家获胜 */
+	class FTimeLimitEvaluator : public FVictoryEvaluator
+	{
+	public:
+		virtual FVictoryDecision OnTimeExpired() override
+		{
+			return FVictoryDecision::HighestScorerWins();
+		}
+	};
+
+	/** 生存模式：最后一波清空时最高分玩家获胜 */
+	class FSurvivalEvaluator : public FVictoryEvaluator
+	{
+	public:
+		explicit FSurvivalEvaluator(int32 InMaxWaves) : MaxWaves(InMaxWaves) {}
+
+		virtual FVictoryDecision OnWaveCleared(int32 Wave) override
+		{
+			return Wave >= MaxWaves ? FVictoryDecision::HighestScorerWins() : FVictoryDecision::Continue();
+		}
+
+	private:
+		int32 MaxWaves;
+	};
+}
+
+TSharedRef<FVictoryEvaluator> FVictoryEvaluator::Create(EVictoryCondition Condition, int32 TargetScore, int32 TargetKillCount, int32 MaxWaves)
+{
+	switch (Condition)
+	{
+	case EVictoryCondition::Score:
+		return MakeShared<VictoryEvaluators::FScoreEvaluator>(TargetScore);
+
+	case EVictoryCondition::KillCount:
+		return MakeShared<VictoryEvaluators::FKillCountEvaluator>(TargetKillCount);
+
+	case EVictoryCondition::TimeLimit:
+		return MakeShared<VictoryEvaluators::FTimeLimitEvaluator>();
+
+	case EVictoryCondition::Survival:
+		return MakeShared<VictoryEvaluators::FSurvivalEvaluator>(MaxWaves);
+
+	default:
+		// 团队死斗尚无胜利规则
+		return MakeShared<FVictoryEvaluator>();
+	}
+}
@@ -0,0 +1,48 @@
+// VictoryEvaluator.h - 胜利条件评估器：每种胜利条件只响应与之相关的比赛事件
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirstPersonDemoGameMode.h"
+
+class AFirstPersonDemoCharacter;
+
+/**
+ * 评估结果
+ */
+struct FVictoryDecision
+{
+	/** 比赛是否结束 */
+	bool bGameOver = false;
+
+	/** 胜者；比赛结束且为空时由游戏模式取当前最高分玩家 */
+	AFirstPersonDemoCharacter* Winner = nullptr;
+
+	static FVictoryDecision Continue() { return FVictoryDecision(); }
+	static FVictoryDecision Win(AFirstPersonDemoCharacter* InWinner) { FVictoryDecision Decision; Decision.bGameOver = true; Decision.Winner = InWinner; return Decision; }
+	static FVictoryDecision HighestScorerWins() { FVictoryDecision Decision; Decision.bGameOver = true; return Decision; }
+};
+
+/**
+ * 胜利条件评估器基类
+ *
+ * 游戏模式不再每帧扫描，只在比赛输入变化时通知评估器：玩家得分或击杀变化、敌人死亡、
+ * 波次清空、时间到。默认不结束比赛，各胜利条件只重写自己关心的事件，评估都是O(1)。
+ */
+class FVictoryEvaluator
+{
+public:
+	virtual ~FVictoryEvaluator() = default;
+
+	/** 创建指定胜利条件的评估器 */
+	static TSharedRef<FVictoryEvaluator> Create(EVictoryCondition Condition, int32 TargetScore, int32 TargetKillCount, int32 MaxWaves);
+
+	/** 玩家得分或击杀数变化 */
+	virtual FVictoryDecision OnPlayerStatsChanged(AFirstPersonDemoCharacter* Player) { return FVictoryDecision::Continue(); }
+
+	/** 一波敌人全部死亡 */
+	virtual FVictoryDecision OnWaveCleared(int32 Wave) { return FVictoryDecision::Continue(); }
+
+	/** 比赛时间到 */
+	virtual FVictoryDecision OnTimeExpired() { return FVictoryDecision::Continue(); }
+};
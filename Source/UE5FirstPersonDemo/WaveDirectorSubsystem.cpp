@@ -0,0 +1,400 @@
+// WaveDirectorSubsystem.cpp - 波次导演实现与帧时间预算测试
+
+#include "WaveDirectorSubsystem.h"
+#include "UE5FirstPersonDemo.h"
+#include "EnemyAICharacter.h"
+#include "FirstPersonDemoGameMode.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogWaveDirector, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Wave Director Tick"), STAT_WaveDirectorTick, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Spawned"), STAT_WaveSpawned, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Spawns Deferred"), STAT_WaveDeferred, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Spawns Thinned"), STAT_WaveThinned, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Spawn Retries"), STAT_WaveRetries, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wave Spawns Failed"), STAT_WaveFailed, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wave Spawn Queue"), STAT_WaveQueued, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wave Live Enemies"), STAT_WaveLive, STATGROUP_FirstPersonDemo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wave Live Enemy Cap"), STAT_WaveLiveCap, STATGROUP_FirstPersonDemo);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Wave Frame Work ms"), STAT_WaveFrameMs, STATGROUP_FirstPersonDemo);
+
+static int32 GWaveDirectorEnabled = 1;
+static FAutoConsoleVariableRef CVarWaveDirectorEnabled(
+	TEXT("fpd.WaveDirector.Enable"),
+	GWaveDirectorEnabled,
+	TEXT("是否按帧时间预算分摊生成（0 = 到期的敌人立即全部生成，不限制存活数量）"));
+
+static int32 GWaveMaxSpawnsPerFrame = 2;
+static FAutoConsoleVariableRef CVarWaveMaxSpawnsPerFrame(
+	TEXT("fpd.WaveDirector.MaxSpawnsPerFrame"),
+	GWaveMaxSpawnsPerFrame,
+	TEXT("每帧最多生成的敌人数"));
+
+static float GWaveFrameBudgetMs = 25.0f;
+static FAutoConsoleVariableRef CVarWaveFrameBudgetMs(
+	TEXT("fpd.WaveDirector.FrameBudgetMs"),
+	GWaveFrameBudgetMs,
+	TEXT("服务器帧工作时间预算（毫秒），超出时暂停生成并收缩存活上限"));
+
+static int32 GWaveMaxLiveEnemies = 64;
+static FAutoConsoleVariableRef CVarWaveMaxLiveEnemies(
+	TEXT("fpd.WaveDirector.MaxLiveEnemies"),
+	GWaveMaxLiveEnemies,
+	TEXT("存活敌人上限的最大值"));
+
+static int32 GWaveMinLiveEnemies = 4;
+static FAutoConsoleVariableRef CVarWaveMinLiveEnemies(
+	TEXT("fpd.WaveDirector.MinLiveEnemies"),
+	GWaveMinLiveEnemies,
+	TEXT("存活敌人上限的最小值（超出预算时也不低于此值）"));
+
+static float GWaveMaxDeferSeconds = 15.0f;
+static FAutoConsoleVariableRef CVarWaveMaxDeferSeconds(
+	TEXT("fpd.WaveDirector.MaxDeferSeconds"),
+	GWaveMaxDeferSeconds,
+	TEXT("超出预算时，到期后顺延超过此时间的生成请求被舍弃"));
+
+namespace WaveDirector
+{
+	/** 帧时间的指数平滑系数 */
+	constexpr float FrameSmoothing = 0.1f;
+
+	/** 生成耗时的指数平滑系数 */
+	constexpr float SpawnCostSmoothing = 0.25f;
+
+	/** 存活上限的调整间隔（秒） */
+	constexpr float CapAdjustInterval = 0.25f;
+
+	/** 帧时间低于预算的这一比例时才放宽上限，避免在预算附近来回摆动 */
+	constexpr float GrowThreshold = 0.85f;
+
+	/** 生成失败（例如生成点被占用）后的重试间隔（秒）和最多重试次数 */
+	constexpr float SpawnRetryDelay = 1.0f;
+	constexpr int32 MaxSpawnRetries = 3;
+}
+
+void UWaveDirectorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// 只有服务器生成敌人
+	UWorld* World = GetWorld();
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_WaveDirectorTick);
+
+	// 本帧读到的是上一帧的工作时间：帧间隔减去限帧等待
+	const float FrameMs = FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0) * 1000.0;
+	const float Now = World->GetTimeSeconds();
+
+	LiveEnemies.RemoveAllSwap([](const TWeakObjectPtr<AEnemyAICharacter>& Enemy)
+	{
+		return !Enemy.IsValid() || Enemy->IsDead();
+	});
+
+	UpdateBudget(DeltaTime, FrameMs);
+
+	if (BudgetTest.bActive)
+	{
+		TickBudgetTest(DeltaTime, FrameMs);
+	}
+
+	const int32 NumQueuedBefore = SpawnQueue.Num();
+	ThinQueue(Now);
+	bSpawnedLastFrame = SpawnDueRequests(Now) > 0;
+
+	// 队列清空时波次可能已经结束：舍弃的请求不会产生敌人，也就不会有敌人死亡触发检查
+	if (NumQueuedBefore > 0 && SpawnQueue.Num() == 0)
+	{
+		if (AFirstPersonDemoGameMode* GameMode = World->GetAuthGameMode<AFirstPersonDemoGameMode>())
+		{
+			GameMode->OnSpawnQueueDrained();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_WaveQueued, SpawnQueue.Num());
+	SET_DWORD_STAT(STAT_WaveLive, LiveEnemies.Num());
+	SET_DWORD_STAT(STAT_WaveLiveCap, LiveEnemyCap);
+	SET_FLOAT_STAT(STAT_WaveFrameMs, SmoothedFrameMs);
+}
+
+TStatId UWaveDirectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWaveDirectorSubsystem, STATGROUP_Tickables);
+}
+
+void UWaveDirectorSubsystem::QueueWave(int32 Count, float SpawnInterval)
+{
+	if (Count <= 0)
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	SpawnQueue.Reserve(SpawnQueue.Num() + Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FSpawnRequest& Request = SpawnQueue.AddDefaulted_GetRef();
+		Request.DueTime = Now + Index * FMath::Max(SpawnInterval, 0.0f);
+	}
+
+	// 上一波的请求可能仍在队列中
+	SpawnQueue.StableSort([](const FSpawnRequest& A, const FSpawnRequest& B)
+	{
+		return A.DueTime < B.DueTime;
+	});
+}
+
+void UWaveDirectorSubsystem::ClearQueue()
+{
+	SpawnQueue.Reset();
+}
+
+void UWaveDirectorSubsystem::UpdateBudget(float DeltaTime, float FrameMs)
+{
+	const int32 MaxLive = FMath::Max(GWaveMaxLiveEnemies, 1);
+	const int32 MinLive = FMath::Clamp(GWaveMinLiveEnemies, 0, MaxLive);
+
+	// 第一帧直接取测量值，上限从最大值开始
+	if (!bBudgetInitialized)
+	{
+		bBudgetInitialized = true;
+		SmoothedFrameMs = FrameMs;
+		LiveEnemyCap = MaxLive;
+	}
+	SmoothedFrameMs += (FrameMs - SmoothedFrameMs) * WaveDirector::FrameSmoothing;
+	LiveEnemyCap = FMath::Clamp(LiveEnemyCap, MinLive, MaxLive);
+
+	TimeSinceCapAdjust += DeltaTime;
+	if (TimeSinceCapAdjust < WaveDirector::CapAdjustInterval)
+	{
+		return;
+	}
+	TimeSinceCapAdjust = 0.0f;
+
+	const int32 NumLive = LiveEnemies.Num();
+	if (SmoothedFrameMs > GWaveFrameBudgetMs)
+	{
+		// 超出预算：收缩到当前存活数以下约10%，新敌人等待旧敌人死亡
+		const int32 Current = FMath::Min(LiveEnemyCap, NumLive);
+		const int32 NewCap = FMath::Max(MinLive, Current - FMath::Max(Current / 10, 1));
+		if (NewCap != LiveEnemyCap)
+		{
+			UE_LOG(LogWaveDirector, Verbose, TEXT("Over budget (%.2f ms > %.2f ms): live cap %d -> %d"), SmoothedFrameMs, GWaveFrameBudgetMs, LiveEnemyCap, NewCap);
+			LiveEnemyCap = NewCap;
+		}
+	}
+	else if (SmoothedFrameMs < GWaveFrameBudgetMs * WaveDirector::GrowThreshold && NumLive >= LiveEnemyCap && LiveEnemyCap < MaxLive)
+	{
+		// 有余量且上限确实挡住了生成时才放宽
+		++LiveEnemyCap;
+		UE_LOG(LogWaveDirector, Verbose, TEXT("Under budget (%.2f ms): live cap raised to %d"), SmoothedFrameMs, LiveEnemyCap);
+	}
+}
+
+int32 UWaveDirectorSubsystem::SpawnDueRequests(float Now)
+{
+	int32 NumDue = 0;
+	while (NumDue < SpawnQueue.Num() && SpawnQueue[NumDue].DueTime <= Now)
+	{
+		++NumDue;
+	}
+	if (NumDue == 0)
+	{
+		return 0;
+	}
+
+	int32 NumAllowed = NumDue;
+	if (GWaveDirectorEnabled)
+	{
+		// 每帧上限、存活上限和剩余预算可容纳的生成数，取最小值
+		const int32 RoomUnderCap = FMath::Max(LiveEnemyCap - LiveEnemies.Num(), 0);
+		const float RemainingMs = GWaveFrameBudgetMs - SmoothedFrameMs;
+		const int32 AffordableSpawns = RemainingMs > 0.0f ? FMath::FloorToInt(RemainingMs / FMath::Max(SpawnCostMs, 0.01f)) : 0;
+		NumAllowed = FMath::Min3(NumDue, FMath::Max(GWaveMaxSpawnsPerFrame, 1), FMath::Min(RoomUnderCap, AffordableSpawns));
+
+		// 场上没有敌人时至少生成一个，保证波次能推进（此时超出预算的不是敌人）
+		if (LiveEnemies.Num() == 0)
+		{
+			NumAllowed = FMath::Max(NumAllowed, 1);
+		}
+	}
+
+	int32 NumSpawned = 0;
+	TArray<FSpawnRequest, TInlineAllocator<4>> Retries;
+	for (int32 Index = 0; Index < NumAllowed; ++Index)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		AEnemyAICharacter* Enemy = SpawnEnemy();
+		const float CostMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		if (Enemy)
+		{
+			SpawnCostMs += (CostMs - SpawnCostMs) * WaveDirector::SpawnCostSmoothing;
+			LiveEnemies.Add(Enemy);
+			++NumSpawned;
+			continue;
+		}
+
+		// 生成失败时稍后重试；多次失败（例如没有敌人类或生成点）后舍弃，由队列清空时的检查结束波次
+		const FSpawnRequest& Request = SpawnQueue[Index];
+		if (Request.NumRetries < WaveDirector::MaxSpawnRetries)
+		{
+			FSpawnRequest& Retry = Retries.Add_GetRef(Request);
+			Retry.DueTime = Now + WaveDirector::SpawnRetryDelay;
+			++Retry.NumRetries;
+			INC_DWORD_STAT(STAT_WaveRetries);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_WaveFailed);
+			UE_LOG(LogWaveDirector, Warning, TEXT("Dropped an enemy spawn after %d failed attempts"), Request.NumRetries + 1);
+		}
+	}
+
+	SpawnQueue.RemoveAt(0, NumAllowed, false);
+
+	// 到期但本帧未生成的请求顺延，只在第一次顺延时计数
+	int32 NumNewlyDeferred = 0;
+	for (int32 Index = 0; Index < NumDue - NumAllowed; ++Index)
+	{
+		if (!SpawnQueue[Index].bDeferred)
+		{
+			SpawnQueue[Index].bDeferred = true;
+			++NumNewlyDeferred;
+		}
+	}
+
+	// 重试的请求按新的到期时间放回队列
+	if (Retries.Num() > 0)
+	{
+		SpawnQueue.Append(Retries);
+		SpawnQueue.StableSort([](const FSpawnRequest& A, const FSpawnRequest& B)
+		{
+			return A.DueTime < B.DueTime;
+		});
+	}
+
+	if (BudgetTest.bActive)
+	{
+		BudgetTest.NumSpawned += NumSpawned;
+	}
+
+	INC_DWORD_STAT_BY(STAT_WaveSpawned, NumSpawned);
+	INC_DWORD_STAT_BY(STAT_WaveDeferred, NumNewlyDeferred);
+
+	return NumSpawned;
+}
+
+void UWaveDirectorSubsystem::ThinQueue(float Now)
+{
+	// 只在超出预算且场上仍有敌人时舍弃，场上的敌人死亡后波次照常结束
+	if (!GWaveDirectorEnabled || SmoothedFrameMs <= GWaveFrameBudgetMs || LiveEnemies.Num() == 0)
+	{
+		return;
+	}
+
+	const float Deadline = Now - GWaveMaxDeferSeconds;
+	int32 NumThinned = 0;
+	while (NumThinned < SpawnQueue.Num() && SpawnQueue[NumThinned].DueTime < Deadline)
+	{
+		++NumThinned;
+	}
+	if (NumThinned == 0)
+	{
+		return;
+	}
+
+	SpawnQueue.RemoveAt(0, NumThinned, false);
+
+	if (BudgetTest.bActive)
+	{
+		BudgetTest.NumThinned += NumThinned;
+	}
+
+	INC_DWORD_STAT_BY(STAT_WaveThinned, NumThinned);
+	UE_LOG(LogWaveDirector, Verbose, TEXT("Thinned %d spawns deferred longer than %.1f s"), NumThinned, GWaveMaxDeferSeconds);
+}
+
+AEnemyAICharacter* UWaveDirectorSubsystem::SpawnEnemy()
+{
+	if (AFirstPersonDemoGameMode* GameMode = GetWorld()->GetAuthGameMode<AFirstPersonDemoGameMode>())
+	{
+		return GameMode->SpawnEnemy();
+	}
+	return nullptr;
+}
+
+void UWaveDirectorSubsystem::StartBudgetTest(int32 Count, float Duration)
+{
+	BudgetTest = FBudgetTest();
+	BudgetTest.bActive = true;
+	BudgetTest.Duration = Duration;
+
+	// 所有请求立即到期：最坏情况
+	QueueWave(Count, 0.0f);
+
+	UE_LOG(LogWaveDirector, Display, TEXT("Wave director budget test: %d enemies queued, %.1f s, budget %.1f ms"), Count, Duration, GWaveFrameBudgetMs);
+}
+
+void UWaveDirectorSubsystem::TickBudgetTest(float DeltaTime, float FrameMs)
+{
+	BudgetTest.Elapsed += DeltaTime;
+	if (BudgetTest.Elapsed >= BudgetTest.Duration)
+	{
+		const bool bPassed = BudgetTest.NumSpawnFramesOverBudget == 0;
+		UE_LOG(LogWaveDirector, Display, TEXT("Wave director budget test: %d frames, %d over budget, max %.2f ms"),
+			BudgetTest.NumFrames, BudgetTest.NumFramesOverBudget, BudgetTest.MaxFrameMs);
+		UE_LOG(LogWaveDirector, Display, TEXT("  Spawn frames: %d, %d over budget, max %.2f ms"),
+			BudgetTest.NumSpawnFrames, BudgetTest.NumSpawnFramesOverBudget, BudgetTest.MaxSpawnFrameMs);
+		UE_LOG(LogWaveDirector, Display, TEXT("  Spawned %d, thinned %d, still queued %d, peak live %d, live cap %d"),
+			BudgetTest.NumSpawned, BudgetTest.NumThinned, SpawnQueue.Num(), BudgetTest.PeakLive, LiveEnemyCap);
+		UE_LOG(LogWaveDirector, Display, TEXT("  Result: %s"), bPassed ? TEXT("PASS (no spawn frame exceeded the budget)") : TEXT("FAIL"));
+
+		BudgetTest.bActive = false;
+		return;
+	}
+
+	++BudgetTest.NumFrames;
+	BudgetTest.MaxFrameMs = FMath::Max(BudgetTest.MaxFrameMs, FrameMs);
+	BudgetTest.PeakLive = FMath::Max(BudgetTest.PeakLive, LiveEnemies.Num());
+	if (FrameMs > GWaveFrameBudgetMs)
+	{
+		++BudgetTest.NumFramesOverBudget;
+	}
+
+	if (bSpawnedLastFrame)
+	{
+		++BudgetTest.NumSpawnFrames;
+		BudgetTest.MaxSpawnFrameMs = FMath::Max(BudgetTest.MaxSpawnFrameMs, FrameMs);
+		if (FrameMs > GWaveFrameBudgetMs)
+		{
+			++BudgetTest.NumSpawnFramesOverBudget;
+		}
+	}
+}
+
+/** 控制台命令：波次导演帧时间预算测试（服务器，可在 -nullrhi 的专用服务器上通过 -ExecCmds 运行） */
+static FAutoConsoleCommandWithWorldAndArgs GWaveDirectorTestCommand(
+	TEXT("fpd.WaveDirectorTest"),
+	TEXT("波次导演预算测试：fpd.WaveDirectorTest [敌人数=200] [秒数=30]，结束时输出生成帧是否超出 fpd.WaveDirector.FrameBudgetMs"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		if (UWaveDirectorSubsystem* Director = World->GetSubsystem<UWaveDirectorSubsystem>())
+		{
+			const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+			const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 30.0f;
+			Director->StartBudgetTest(Count, Duration);
+		}
+	}));
@@ -0,0 +1,123 @@
+// WaveDirectorSubsystem.h - 波次导演：敌人生成队列，按服务器帧时间预算分摊生成并限制存活数量
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WaveDirectorSubsystem.generated.h"
+
+class AEnemyAICharacter;
+
+/**
+ * 波次导演子系统（服务器）
+ *
+ * 游戏模式不再为每个敌人设置计时器，而是把整波敌人放入生成队列，每个请求带有最早生成时间。
+ * 导演每帧测量服务器帧工作时间（帧间隔减去限帧等待），平滑后与预算比较：
+ * - 每帧最多生成 fpd.WaveDirector.MaxSpawnsPerFrame 个，且预计的生成耗时不超过剩余预算
+ * - 存活敌人上限随帧时间加减调整：超出预算时收缩到当前存活数以下，留有余量时逐步放宽
+ * - 到期但未生成的请求顺延；在超出预算时顺延超过 fpd.WaveDirector.MaxDeferSeconds 的请求被舍弃
+ * - 生成失败的请求延迟后重试，多次失败后舍弃；队列因此清空时通知游戏模式检查波次是否结束
+ * 这些决策通过 stat FirstPersonDemo 中的 Wave 统计项观察。
+ */
+UCLASS()
+class UWaveDirectorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** 把Count个敌人加入生成队列，第i个最早在 i * SpawnInterval 秒后生成 */
+	void QueueWave(int32 Count, float SpawnInterval);
+
+	/** 清空生成队列（比赛结束时） */
+	void ClearQueue();
+
+	/** 队列中尚未生成的敌人数 */
+	int32 GetNumQueued() const { return SpawnQueue.Num(); }
+
+	/** 存活敌人数 */
+	int32 GetNumLive() const { return LiveEnemies.Num(); }
+
+	/** 当前存活敌人上限 */
+	int32 GetLiveEnemyCap() const { return LiveEnemyCap; }
+
+	/** 平滑后的服务器帧工作时间（毫秒） */
+	float GetSmoothedFrameMs() const { return SmoothedFrameMs; }
+
+	/** 预算测试：一次排入Count个敌人，Duration秒内记录每帧工作时间，结束时输出生成帧是否超出预算 */
+	void StartBudgetTest(int32 Count, float Duration);
+
+private:
+	/** 一个待生成的敌人 */
+	struct FSpawnRequest
+	{
+		/** 最早生成时间（世界时间） */
+		float DueTime = 0.0f;
+
+		/** 是否已计入顺延统计（每个请求只计一次） */
+		bool bDeferred = false;
+
+		/** 生成失败后的重试次数 */
+		int32 NumRetries = 0;
+	};
+
+	/** 根据上一帧的工作时间更新平滑帧时间和存活上限 */
+	void UpdateBudget(float DeltaTime, float FrameMs);
+
+	/** 生成到期的请求，返回本帧生成数 */
+	int32 SpawnDueRequests(float Now);
+
+	/** 舍弃顺延过久的请求 */
+	void ThinQueue(float Now);
+
+	/** 通过游戏模式生成一个敌人 */
+	AEnemyAICharacter* SpawnEnemy();
+
+	/** 预算测试每帧记录 */
+	void TickBudgetTest(float DeltaTime, float FrameMs);
+
+	/** 按最早生成时间排序的队列 */
+	TArray<FSpawnRequest> SpawnQueue;
+
+	/** 导演生成、尚未死亡的敌人 */
+	TArray<TWeakObjectPtr<AEnemyAICharacter>> LiveEnemies;
+
+	/** 平滑后的帧工作时间（毫秒） */
+	float SmoothedFrameMs = 0.0f;
+
+	/** 是否已取得第一帧的测量值（之前平滑帧时间和存活上限无意义） */
+	bool bBudgetInitialized = false;
+
+	/** 单次生成耗时的平滑估计（毫秒） */
+	float SpawnCostMs = 1.0f;
+
+	/** 当前存活敌人上限 */
+	int32 LiveEnemyCap = 0;
+
+	/** 距离上次调整上限的时间 */
+	float TimeSinceCapAdjust = 0.0f;
+
+	/** 上一帧是否生成过敌人（本帧读到的工作时间属于上一帧） */
+	bool bSpawnedLastFrame = false;
+
+	/** 预算测试状态 */
+	struct FBudgetTest
+	{
+		bool bActive = false;
+		float Duration = 0.0f;
+		float Elapsed = 0.0f;
+		int32 NumFrames = 0;
+		int32 NumSpawnFrames = 0;
+		int32 NumFramesOverBudget = 0;
+		int32 NumSpawnFramesOverBudget = 0;
+		float MaxFrameMs = 0.0f;
+		float MaxSpawnFrameMs = 0.0f;
+		int32 NumSpawned = 0;
+		int32 NumThinned = 0;
+		int32 PeakLive = 0;
+	};
+
+	FBudgetTest BudgetTest;
+};
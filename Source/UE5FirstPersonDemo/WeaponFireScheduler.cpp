@@ -0,0 +1,149 @@
+// WeaponFireScheduler.cpp - 射击调度实现与射速自检
+
+#include "WeaponFireScheduler.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFireScheduler, Log, All);
+
+bool FWeaponFireScheduler::StartFiring(double Now)
+{
+	bTriggerHeld = true;
+
+	if (Now < NextShotTime)
+	{
+		// 仍在冷却中，由Advance在冷却结束的时刻开火
+		return false;
+	}
+
+	NextShotTime = Now + FireInterval;
+	return true;
+}
+
+int32 FWeaponFireScheduler::Advance(double Now, FShotTimes& OutShotTimes)
+{
+	OutShotTimes.Reset();
+
+	if (!bTriggerHeld)
+	{
+		return 0;
+	}
+
+	while (NextShotTime <= Now)
+	{
+		if (OutShotTimes.Num() == MaxShotsPerFrame)
+		{
+			// 卡顿过长：剩余的射击不补发，节奏从当前时刻重新开始
+			const int32 NumSkipped = FMath::FloorToInt((Now - NextShotTime) / FireInterval) + 1;
+			NumDroppedShots += NumSkipped;
+			NextShotTime += NumSkipped * FireInterval;
+			break;
+		}
+
+		OutShotTimes.Add(NextShotTime);
+		NextShotTime += FireInterval;
+	}
+
+	return OutShotTimes.Num();
+}
+
+void FWeaponFireScheduler::Reset()
+{
+	NextShotTime = 0.0;
+	bTriggerHeld = false;
+}
+
+namespace WeaponFireSchedulerTest
+{
+	/** 以给定帧率（可带抖动）模拟按住扳机Duration秒，返回实际射击数和最大间隔误差 */
+	int32 Simulate(float FireInterval, float Fps, float Jitter, double Duration, double& OutMaxIntervalError)
+	{
+		FWeaponFireScheduler Scheduler;
+		Scheduler.SetFireInterval(FireInterval);
+
+		FRandomStream Random(FMath::RoundToInt(Fps * 1000.0f));
+		FWeaponFireScheduler::FShotTimes ShotTimes;
+
+		const double StartTime = 100.0;
+		double LastShotTime = StartTime;
+		int32 NumShots = Scheduler.StartFiring(StartTime) ? 1 : 0;
+		OutMaxIntervalError = 0.0;
+
+		double Now = StartTime;
+		while (Now < StartTime + Duration)
+		{
+			const double FrameTime = (1.0 / Fps) * (1.0 + Random.FRandRange(-Jitter, Jitter));
+			Now = FMath::Min(Now + FrameTime, StartTime + Duration);
+
+			Scheduler.Advance(Now, ShotTimes);
+			for (double ShotTime : ShotTimes)
+			{
+				OutMaxIntervalError = FMath::Max(OutMaxIntervalError, FMath::Abs(ShotTime - LastShotTime - FireInterval));
+				LastShotTime = ShotTime;
+				++NumShots;
+			}
+		}
+
+		return NumShots;
+	}
+
+	/** 按住扳机时死亡（停止推进）DeadTime秒并重置，重生后第一帧的射击数；OutPressShots为重新按下扳机时的射击数 */
+	int32 SimulateResumeAfterReset(float FireInterval, double DeadTime, int32& OutPressShots)
+	{
+		FWeaponFireScheduler Scheduler;
+		Scheduler.SetFireInterval(FireInterval);
+
+		FWeaponFireScheduler::FShotTimes ShotTimes;
+		const double StartTime = 100.0;
+		Scheduler.StartFiring(StartTime);
+		Scheduler.Advance(StartTime + 0.5, ShotTimes);
+
+		// 死亡时重置，死亡期间角色不推进调度器
+		Scheduler.Reset();
+
+		// 重生后的第一帧：未重置时会按死亡前的节奏补发到每帧上限
+		const double ResumeTime = StartTime + 0.5 + DeadTime;
+		const int32 NumResumeShots = Scheduler.Advance(ResumeTime, ShotTimes);
+
+		OutPressShots = Scheduler.StartFiring(ResumeTime) ? 1 : 0;
+		OutPressShots += Scheduler.Advance(ResumeTime + 1.0 / 60.0, ShotTimes);
+		return NumResumeShots;
+	}
+}
+
+/** 控制台命令：射速自检，在20~240fps（含抖动帧时间）下验证射击数和间隔都精确 */
+static FAutoConsoleCommand GFireSchedulerTestCommand(
+	TEXT("fpd.FireSchedulerTest"),
+	TEXT("射击调度自检：在20~240fps（含抖动）下模拟按住扳机10秒，验证射击数和射击间隔"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const float FireInterval = 0.15f;
+		const double Duration = 10.0;
+		const int32 ExpectedShots = FMath::FloorToInt(Duration / FireInterval + KINDA_SMALL_NUMBER) + 1;
+		const float FrameRates[] = { 20.0f, 30.0f, 60.0f, 90.0f, 144.0f, 240.0f };
+		const float Jitters[] = { 0.0f, 0.5f };
+
+		int32 NumFailed = 0;
+		for (float Fps : FrameRates)
+		{
+			for (float Jitter : Jitters)
+			{
+				double MaxIntervalError = 0.0;
+				const int32 NumShots = WeaponFireSchedulerTest::Simulate(FireInterval, Fps, Jitter, Duration, MaxIntervalError);
+				const bool bPassed = NumShots == ExpectedShots && MaxIntervalError < 1e-6;
+				NumFailed += bPassed ? 0 : 1;
+
+				UE_LOG(LogFireScheduler, Display, TEXT("%s %5.0f fps (jitter %2.0f%%): %d / %d shots, max interval error %.3g s"),
+					bPassed ? TEXT("PASS") : TEXT("FAIL"), Fps, Jitter * 100.0f, NumShots, ExpectedShots, MaxIntervalError);
+			}
+		}
+
+		// 重生后恢复射击：不补发死亡期间的射击，重新按下扳机时立即开一发
+		int32 PressShots = 0;
+		const int32 ResumeShots = WeaponFireSchedulerTest::SimulateResumeAfterReset(FireInterval, 5.0, PressShots);
+		const bool bResumePassed = ResumeShots == 0 && PressShots == 1;
+		NumFailed += bResumePassed ? 0 : 1;
+		UE_LOG(LogFireScheduler, Display, TEXT("%s resume after reset: %d shots on the first frame (expected 0), %d on trigger press (expected 1)"),
+			bResumePassed ? TEXT("PASS") : TEXT("FAIL"), ResumeShots, PressShots);
+
+		UE_LOG(LogFireScheduler, Display, TEXT("Fire scheduler test: %s"), NumFailed == 0 ? TEXT("all passed") : TEXT("FAILED"));
+	}));
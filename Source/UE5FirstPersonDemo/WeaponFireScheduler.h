@@ -0,0 +1,52 @@
+// WeaponFireScheduler.h - 与帧率无关的射击调度：精确累积时间，按子帧时间戳输出本帧应发射的射击
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 武器射击调度器
+ *
+ * 下一发的时间按固定间隔累加（而不是“上次射击时间 + 间隔，且重置为当前帧时间”），
+ * 因此每帧可能发射零发或多发，每发带有落在帧内的精确时间戳，实际射速与帧率无关。
+ * 松开扳机后冷却仍然生效；重新按下时若已冷却则立即在按下时刻开火。
+ */
+class FWeaponFireScheduler
+{
+public:
+	/** 每帧最多输出的射击数（严重卡顿后不补发超过此数量的射击） */
+	static constexpr int32 MaxShotsPerFrame = 4;
+
+	using FShotTimes = TArray<double, TInlineAllocator<MaxShotsPerFrame>>;
+
+	/** 设置射击间隔（秒） */
+	void SetFireInterval(float InFireInterval) { FireInterval = FMath::Max(InFireInterval, KINDA_SMALL_NUMBER); }
+
+	/** 按下扳机；已冷却时在Now立即开火并返回true */
+	bool StartFiring(double Now);
+
+	/** 松开扳机 */
+	void StopFiring() { bTriggerHeld = false; }
+
+	/** 是否按住扳机 */
+	bool IsFiring() const { return bTriggerHeld; }
+
+	/** 推进到Now，输出(上一帧, Now]内应发射的射击时间戳，返回射击数 */
+	int32 Advance(double Now, FShotTimes& OutShotTimes);
+
+	/** 清空状态（死亡或重生时） */
+	void Reset();
+
+	/** 因超过每帧上限而丢弃的射击数 */
+	int32 GetNumDroppedShots() const { return NumDroppedShots; }
+
+private:
+	float FireInterval = 0.15f;
+
+	/** 下一发允许开火的时间 */
+	double NextShotTime = 0.0;
+
+	bool bTriggerHeld = false;
+
+	int32 NumDroppedShots = 0;
+};